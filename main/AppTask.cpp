@@ -20,6 +20,13 @@
 #include "AppEvent.h"
 #include "WDMFeature.h"
 #include "LEDWidget.h"
+#include "ImageStore.h"
+#include "DownloadScheduler.h"
+#include "Diagnostics.h"
+#include "ThreadPollingPolicy.h"
+#include "LivenessPolicy.h"
+#include "ServiceSession.h"
+#include "BLEConnectionPolicy.h"
 
 #include <schema/include/BoltLockTrait.h>
 
@@ -33,7 +40,6 @@
 #include "FreeRTOS.h"
 
 #include <Weave/Profiles/WeaveProfiles.h>
-#include <Weave/Support/crypto/HashAlgos.h>
 #include <Weave/DeviceLayer/SoftwareUpdateManager.h>
 
 using namespace ::nl::Weave::TLV;
@@ -44,7 +50,7 @@ using namespace ::nl::Weave::Profiles::SoftwareUpdate;
 #define FACTORY_RESET_CANCEL_WINDOW_TIMEOUT 3000
 #define APP_TASK_STACK_SIZE                 (4096)
 #define APP_TASK_PRIORITY                   2
-#define APP_EVENT_QUEUE_SIZE                10
+#define APP_EVENT_QUEUE_SIZE                (10 + BOLT_LOCK_ACTUATOR_COUNT) // Actuators complete concurrently.
 
 APP_TIMER_DEF(sFunctionTimer);
 
@@ -53,6 +59,14 @@ static SemaphoreHandle_t sWeaveEventLock;
 static TaskHandle_t sAppTaskHandle;
 static QueueHandle_t sAppEventQueue;
 
+#if configSUPPORT_STATIC_ALLOCATION
+static StaticSemaphore_t sWeaveEventLockStruct;
+static StaticTask_t sAppTaskStruct;
+static StackType_t sAppTaskStack[APP_TASK_STACK_SIZE / sizeof(StackType_t)];
+static StaticQueue_t sAppEventQueueStruct;
+static uint8_t sAppEventQueueBuffer[APP_EVENT_QUEUE_SIZE * sizeof(AppEvent)];
+#endif
+
 static LEDWidget sStatusLED;
 static LEDWidget sLockLED;
 static LEDWidget sUnusedLED;
@@ -66,8 +80,6 @@ static bool sIsServiceSubscriptionEstablished = false;
 static bool sHaveBLEConnections               = false;
 static bool sHaveServiceConnectivity          = false;
 
-static nl::Weave::Platform::Security::SHA256 sSHA256;
-
 AppTask AppTask::sAppTask;
 
 namespace nl {
@@ -96,7 +108,11 @@ int AppTask::StartAppTask()
 {
     ret_code_t ret = NRF_SUCCESS;
 
+#if configSUPPORT_STATIC_ALLOCATION
+    sAppEventQueue = xQueueCreateStatic(APP_EVENT_QUEUE_SIZE, sizeof(AppEvent), sAppEventQueueBuffer, &sAppEventQueueStruct);
+#else
     sAppEventQueue = xQueueCreate(APP_EVENT_QUEUE_SIZE, sizeof(AppEvent));
+#endif
     if (sAppEventQueue == NULL)
     {
         NRF_LOG_INFO("Failed to allocate app event queue");
@@ -105,11 +121,20 @@ int AppTask::StartAppTask()
     }
 
     // Start App task.
+#if configSUPPORT_STATIC_ALLOCATION
+    sAppTaskHandle = xTaskCreateStatic(AppTaskMain, "APP", ARRAY_SIZE(sAppTaskStack), NULL, APP_TASK_PRIORITY, sAppTaskStack,
+                                       &sAppTaskStruct);
+    if (sAppTaskHandle == NULL)
+    {
+        ret = NRF_ERROR_NULL;
+    }
+#else
     if (xTaskCreate(AppTaskMain, "APP", APP_TASK_STACK_SIZE / sizeof(StackType_t), NULL, APP_TASK_PRIORITY, &sAppTaskHandle) !=
         pdPASS)
     {
         ret = NRF_ERROR_NULL;
     }
+#endif
 
     return ret;
 }
@@ -123,7 +148,7 @@ int AppTask::Init()
     sStatusLED.Init(SYSTEM_STATE_LED);
 
     sLockLED.Init(LOCK_STATE_LED);
-    sLockLED.Set(!BoltLockMgr().IsUnlocked());
+    sLockLED.Set(AreAllLocksLocked());
 
     sUnusedLED.Init(BSP_LED_2);
     sUnusedLED_1.Init(BSP_LED_3);
@@ -163,16 +188,23 @@ int AppTask::Init()
         APP_ERROR_HANDLER(ret);
     }
 
-    ret = BoltLockMgr().Init();
-    if (ret != NRF_SUCCESS)
+    for (uint8_t i = 0; i < BOLT_LOCK_ACTUATOR_COUNT; i++)
     {
-        NRF_LOG_INFO("BoltLockMgr().Init() failed");
-        APP_ERROR_HANDLER(ret);
-    }
+        ret = BoltLockMgr(i).Init(i);
+        if (ret != NRF_SUCCESS)
+        {
+            NRF_LOG_INFO("BoltLockMgr(%u).Init() failed", i);
+            APP_ERROR_HANDLER(ret);
+        }
 
-    BoltLockMgr().SetCallbacks(ActionInitiated, ActionCompleted);
+        BoltLockMgr(i).SetCallbacks(ActionInitiated, ActionCompleted);
+    }
 
+#if configSUPPORT_STATIC_ALLOCATION
+    sWeaveEventLock = xSemaphoreCreateMutexStatic(&sWeaveEventLockStruct);
+#else
     sWeaveEventLock = xSemaphoreCreateMutex();
+#endif
     if (sWeaveEventLock == NULL)
     {
         NRF_LOG_INFO("xSemaphoreCreateMutex() failed");
@@ -187,6 +219,54 @@ int AppTask::Init()
         APP_ERROR_HANDLER(ret);
     }
 
+    // Hold the shared CASE session with the service across reconnects
+    err = GetServiceSession().Init();
+    if (err != WEAVE_NO_ERROR)
+    {
+        NRF_LOG_INFO("GetServiceSession().Init() failed");
+        APP_ERROR_HANDLER(err);
+    }
+
+    // Initialize persistent storage for software update images
+    err = GetImageStore().Init();
+    if (err != WEAVE_NO_ERROR)
+    {
+        NRF_LOG_INFO("GetImageStore().Init() failed");
+        APP_ERROR_HANDLER(err);
+    }
+
+    // Start periodic diagnostics reporting
+    ret = GetDiagnostics().Init();
+    if (ret != NRF_SUCCESS)
+    {
+        NRF_LOG_INFO("GetDiagnostics().Init() failed");
+        APP_ERROR_HANDLER(ret);
+    }
+
+    // Start adaptive Thread polling
+    ret = GetThreadPollingPolicy().Init();
+    if (ret != NRF_SUCCESS)
+    {
+        NRF_LOG_INFO("GetThreadPollingPolicy().Init() failed");
+        APP_ERROR_HANDLER(ret);
+    }
+
+    // Select the service liveness timeout for the current power state
+    ret = GetLivenessPolicy().Init();
+    if (ret != NRF_SUCCESS)
+    {
+        NRF_LOG_INFO("GetLivenessPolicy().Init() failed");
+        APP_ERROR_HANDLER(ret);
+    }
+
+    // Negotiate fast BLE connections while provisioning over WoBLE
+    ret = GetBLEConnectionPolicy().Init();
+    if (ret != NRF_SUCCESS)
+    {
+        NRF_LOG_INFO("GetBLEConnectionPolicy().Init() failed");
+        APP_ERROR_HANDLER(ret);
+    }
+
     SoftwareUpdateMgr().SetEventCallback(this, HandleSoftwareUpdateEvent);
 
     // Enable timer based Software Update Checks
@@ -198,7 +278,7 @@ int AppTask::Init()
     err = ConfigurationMgr().GetFirmwareRevision(currentFirmwareRev, sizeof(currentFirmwareRev), currentFirmwareRevLen);
     APP_ERROR_CHECK(err);
 
-    NRF_LOG_INFO("Current Firmware Version: %s", currentFirmwareRev);
+    NRF_LOG_INFO("Current Firmware Version: %s", NRF_LOG_PUSH(currentFirmwareRev));
 
     return ret;
 }
@@ -289,16 +369,27 @@ void AppTask::LockActionEventHandler(AppEvent * aEvent)
     bool initiated = false;
     BoltLockManager::Action_t action;
     int32_t actor;
+    uint8_t firstActuator;
+    uint8_t lastActuator;
     ret_code_t ret = NRF_SUCCESS;
 
     if (aEvent->Type == AppEvent::kEventType_Lock)
     {
-        action = static_cast<BoltLockManager::Action_t>(aEvent->LockEvent.Action);
-        actor  = aEvent->LockEvent.Actor;
+        action        = static_cast<BoltLockManager::Action_t>(aEvent->LockEvent.Action);
+        actor         = aEvent->LockEvent.Actor;
+        firstActuator = aEvent->LockEvent.Actuator;
+        lastActuator  = aEvent->LockEvent.Actuator;
+
+        if (firstActuator >= BOLT_LOCK_ACTUATOR_COUNT)
+        {
+            ret = NRF_ERROR_INVALID_PARAM;
+        }
     }
     else if (aEvent->Type == AppEvent::kEventType_Button)
     {
-        if (BoltLockMgr().IsUnlocked())
+        // The lock button operates the whole door: lock every actuator unless they are all
+        // already locked.
+        if (!AreAllLocksLocked())
         {
             action = BoltLockManager::LOCK_ACTION;
         }
@@ -307,7 +398,9 @@ void AppTask::LockActionEventHandler(AppEvent * aEvent)
             action = BoltLockManager::UNLOCK_ACTION;
         }
 
-        actor = Schema::Weave::Trait::Security::BoltLockTrait::BOLT_LOCK_ACTOR_METHOD_PHYSICAL;
+        actor         = Schema::Weave::Trait::Security::BoltLockTrait::BOLT_LOCK_ACTOR_METHOD_PHYSICAL;
+        firstActuator = 0;
+        lastActuator  = BOLT_LOCK_ACTUATOR_COUNT - 1;
     }
     else
     {
@@ -316,13 +409,59 @@ void AppTask::LockActionEventHandler(AppEvent * aEvent)
 
     if (ret == NRF_SUCCESS)
     {
-        initiated = BoltLockMgr().InitiateAction(actor, action);
+        for (uint8_t i = firstActuator; i <= lastActuator; i++)
+        {
+            initiated = BoltLockMgr(i).InitiateAction(actor, action);
+
+            if (!initiated)
+            {
+                NRF_LOG_INFO("Action is already in progress or active on actuator %u.", i);
+            }
+
+            // Only a command that started a lock action is timed to the action's completion.
+            if (aEvent->Type == AppEvent::kEventType_Lock)
+            {
+                BoltLockTraitDataSource & source = WdmFeature().GetBoltLockTraitDataSource(i);
+                BoltLockTraitDataSource::CommandSource commandSource =
+                    static_cast<BoltLockTraitDataSource::CommandSource>(aEvent->LockEvent.CommandSource);
+
+                if (initiated)
+                {
+                    source.StartCommand(commandSource, aEvent->LockEvent.CommandInitiationTimeUS);
+                }
+                else
+                {
+                    source.RefuseCommand(commandSource);
+                }
+            }
+        }
+    }
+}
+
+bool AppTask::AreAllLocksLocked(void)
+{
+    for (uint8_t i = 0; i < BOLT_LOCK_ACTUATOR_COUNT; i++)
+    {
+        if (BoltLockMgr(i).IsUnlocked())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
 
-        if (!initiated)
+bool AppTask::IsAnyLockActionInProgress(void)
+{
+    for (uint8_t i = 0; i < BOLT_LOCK_ACTUATOR_COUNT; i++)
+    {
+        if (BoltLockMgr(i).IsActionInProgress())
         {
-            NRF_LOG_INFO("Action is already in progress or active.");
+            return true;
         }
     }
+
+    return false;
 }
 
 void AppTask::ButtonEventHandler(uint8_t pin_no, uint8_t button_action)
@@ -434,7 +573,7 @@ void AppTask::FunctionHandler(AppEvent * aEvent)
             sUnusedLED_1.Set(false);
 
             // Set lock status LED back to show state of lock.
-            sLockLED.Set(!BoltLockMgr().IsUnlocked());
+            sLockLED.Set(AreAllLocksLocked());
 
             sAppTask.CancelTimer();
 
@@ -474,54 +613,65 @@ void AppTask::StartTimer(uint32_t aTimeoutInMs)
     mFunctionTimerActive = true;
 }
 
-void AppTask::ActionInitiated(BoltLockManager::Action_t aAction, int32_t aActor)
+void AppTask::ActionInitiated(BoltLockManager & aLock, BoltLockManager::Action_t aAction, int32_t aActor)
 {
     // If the action has been initiated by the lock, update the bolt lock trait
     // and start flashing the LEDs rapidly to indicate action initiation.
     if (aAction == BoltLockManager::LOCK_ACTION)
     {
-        WdmFeature().GetBoltLockTraitDataSource().InitiateLock(aActor);
-        NRF_LOG_INFO("Lock Action has been initiated")
+        WdmFeature().GetBoltLockTraitDataSource(aLock.GetIndex()).InitiateLock(aActor);
+        NRF_LOG_INFO("Lock Action has been initiated on actuator %u", aLock.GetIndex());
     }
     else if (aAction == BoltLockManager::UNLOCK_ACTION)
     {
-        WdmFeature().GetBoltLockTraitDataSource().InitiateUnlock(aActor);
-        NRF_LOG_INFO("Unlock Action has been initiated")
+        WdmFeature().GetBoltLockTraitDataSource(aLock.GetIndex()).InitiateUnlock(aActor);
+        NRF_LOG_INFO("Unlock Action has been initiated on actuator %u", aLock.GetIndex());
     }
 
+    // Poll quickly while the action is in progress, and learn when the lock is typically used.
+    GetThreadPollingPolicy().BeginActivity(ThreadPollingPolicy::kActivity_LockCommand);
+    GetThreadPollingPolicy().RecordUserActivity();
+
     sLockLED.Blink(50, 50);
 }
 
-void AppTask::ActionCompleted(BoltLockManager::Action_t aAction)
+void AppTask::ActionCompleted(BoltLockManager & aLock, BoltLockManager::Action_t aAction)
 {
     // if the action has been completed by the lock, update the bolt lock trait.
-    // Turn on the lock LED if in a LOCKED state OR
-    // Turn off the lock LED if in an UNLOCKED state.
     if (aAction == BoltLockManager::LOCK_ACTION)
     {
-        NRF_LOG_INFO("Lock Action has been completed")
+        NRF_LOG_INFO("Lock Action has been completed on actuator %u", aLock.GetIndex());
 
-        WdmFeature().GetBoltLockTraitDataSource().LockingSuccessful();
-
-        sLockLED.Set(true);
+        WdmFeature().GetBoltLockTraitDataSource(aLock.GetIndex()).LockingSuccessful();
     }
     else if (aAction == BoltLockManager::UNLOCK_ACTION)
     {
-        NRF_LOG_INFO("Unlock Action has been completed")
+        NRF_LOG_INFO("Unlock Action has been completed on actuator %u", aLock.GetIndex());
 
-        WdmFeature().GetBoltLockTraitDataSource().UnlockingSuccessful();
+        WdmFeature().GetBoltLockTraitDataSource(aLock.GetIndex()).UnlockingSuccessful();
+    }
 
-        sLockLED.Set(false);
+    // Once every actuator has stopped moving, turn on the lock LED if all of them are
+    // LOCKED, or turn it off if any of them is UNLOCKED.
+    if (!IsAnyLockActionInProgress())
+    {
+        sLockLED.Set(AreAllLocksLocked());
+
+        GetThreadPollingPolicy().EndActivity(ThreadPollingPolicy::kActivity_LockCommand);
     }
 }
 
-void AppTask::PostLockActionRequest(int32_t aActor, BoltLockManager::Action_t aAction)
+void AppTask::PostLockActionRequest(uint8_t aActuator, int32_t aActor, BoltLockManager::Action_t aAction, uint8_t aCommandSource,
+                                    int64_t aCommandInitiationTimeUS)
 {
     AppEvent event;
-    event.Type             = AppEvent::kEventType_Lock;
-    event.LockEvent.Actor  = aActor;
-    event.LockEvent.Action = aAction;
-    event.Handler          = LockActionEventHandler;
+    event.Type                              = AppEvent::kEventType_Lock;
+    event.LockEvent.Actuator                = aActuator;
+    event.LockEvent.Actor                   = aActor;
+    event.LockEvent.Action                  = aAction;
+    event.LockEvent.CommandSource           = aCommandSource;
+    event.LockEvent.CommandInitiationTimeUS = aCommandInitiationTimeUS;
+    event.Handler                           = LockActionEventHandler;
     PostEvent(&event);
 }
 
@@ -536,6 +686,21 @@ void AppTask::PostEvent(const AppEvent * aEvent)
     }
 }
 
+void AppTask::PostEventFromISR(const AppEvent * aEvent)
+{
+    BaseType_t yieldRequired = pdFALSE;
+
+    if (sAppEventQueue != NULL)
+    {
+        if (!xQueueSendFromISR(sAppEventQueue, aEvent, &yieldRequired))
+        {
+            NRF_LOG_INFO("Failed to post event to app task event queue");
+        }
+    }
+
+    portYIELD_FROM_ISR(yieldRequired);
+}
+
 void AppTask::DispatchEvent(AppEvent * aEvent)
 {
     if (aEvent->Handler)
@@ -550,7 +715,12 @@ void AppTask::DispatchEvent(AppEvent * aEvent)
 
 void AppTask::InstallEventHandler(AppEvent * aEvent)
 {
-    SoftwareUpdateMgr().ImageInstallComplete(WEAVE_NO_ERROR);
+    // There is no bootloader in this example to apply the image.  Discard it, so that the
+    // next software update attempt downloads the image again rather than resuming at its
+    // end, and report that install is not supported.
+    GetImageStore().Reset();
+
+    SoftwareUpdateMgr().ImageInstallComplete(WEAVE_ERROR_NOT_IMPLEMENTED);
 }
 
 void AppTask::HandleSoftwareUpdateEvent(void *apAppState,
@@ -558,9 +728,6 @@ void AppTask::HandleSoftwareUpdateEvent(void *apAppState,
                                         const SoftwareUpdateManager::InEventParam& aInParam,
                                         SoftwareUpdateManager::OutEventParam& aOutParam)
 {
-    static uint32_t persistedImageLen = 0;
-    static char persistedImageURI[WEAVE_DEVICE_CONFIG_SOFTWARE_UPDATE_URI_LEN+1] = "";
-
     switch(aEvent)
     {
         case SoftwareUpdateManager::kEvent_PrepareQuery:
@@ -609,12 +776,12 @@ void AppTask::HandleSoftwareUpdateEvent(void *apAppState,
             if (aInParam.QueryPrepareFailed.Error == WEAVE_ERROR_STATUS_REPORT_RECEIVED)
             {
                 NRF_LOG_INFO("Software Update failed during prepare: Received StatusReport %s",
-                             nl::StatusReportStr(aInParam.QueryPrepareFailed.StatusReport->mProfileId,
-                                     aInParam.QueryPrepareFailed.StatusReport->mStatusCode));
+                             NRF_LOG_PUSH(nl::StatusReportStr(aInParam.QueryPrepareFailed.StatusReport->mProfileId,
+                                                              aInParam.QueryPrepareFailed.StatusReport->mStatusCode)));
             }
             else
             {
-                NRF_LOG_INFO("Software Update failed during prepare: %s", nl::ErrorStr(aInParam.QueryPrepareFailed.Error));
+                NRF_LOG_INFO("Software Update failed during prepare: %s", NRF_LOG_PUSH(nl::ErrorStr(aInParam.QueryPrepareFailed.Error)));
             }
             break;
         }
@@ -628,14 +795,14 @@ void AppTask::HandleSoftwareUpdateEvent(void *apAppState,
             err = ConfigurationMgr().GetFirmwareRevision(currentFirmwareRev, sizeof(currentFirmwareRev), currentFirmwareRevLen);
             APP_ERROR_CHECK(err);
 
-            NRF_LOG_INFO("Current Firmware Version: %s", currentFirmwareRev);
+            NRF_LOG_INFO("Current Firmware Version: %s", NRF_LOG_PUSH(currentFirmwareRev));
 
             NRF_LOG_INFO("Software Update Available - Priority: %d Condition: %d Version: %s IntegrityType: %d URI: %s",
                                                                                 aInParam.SoftwareUpdateAvailable.Priority,
                                                                                 aInParam.SoftwareUpdateAvailable.Condition,
-                                                                                aInParam.SoftwareUpdateAvailable.Version,
+                                                                                NRF_LOG_PUSH(aInParam.SoftwareUpdateAvailable.Version),
                                                                                 aInParam.SoftwareUpdateAvailable.IntegrityType,
-                                                                                aInParam.SoftwareUpdateAvailable.URI);
+                                                                                NRF_LOG_PUSH(aInParam.SoftwareUpdateAvailable.URI));
 
             break;
         }
@@ -643,10 +810,11 @@ void AppTask::HandleSoftwareUpdateEvent(void *apAppState,
         case SoftwareUpdateManager::kEvent_FetchPartialImageInfo:
         {
             NRF_LOG_INFO("Fetching Partial Image Information");
-            if (strcmp(aInParam.FetchPartialImageInfo.URI, persistedImageURI) == 0)
+            uint32_t partialImageLen = GetImageStore().GetPartialImageLength(aInParam.FetchPartialImageInfo.URI);
+            if (partialImageLen != 0)
             {
-                NRF_LOG_INFO("Partial image detected in local storage; resuming download at offset %" PRId32, persistedImageLen);
-                aOutParam.FetchPartialImageInfo.PartialImageLen = persistedImageLen;
+                NRF_LOG_INFO("Partial image detected in local storage; resuming download at offset %" PRId32, partialImageLen);
+                aOutParam.FetchPartialImageInfo.PartialImageLen = partialImageLen;
             }
             else
             {
@@ -660,62 +828,65 @@ void AppTask::HandleSoftwareUpdateEvent(void *apAppState,
         {
             NRF_LOG_INFO("Preparing Image Storage");
 
-            // Capture state information about the image being downloaded.
-            persistedImageLen = 0;
-            strncpy(persistedImageURI, aInParam.PrepareImageStorage.URI, sizeof(persistedImageURI));
-            persistedImageURI[sizeof(persistedImageURI) - 1] = 0;
-
-            // Prepare to compute the integrity of the image as it is received.
-            //
-            // This example does not actually store image blocks in persistent storage and merely discards
-            // them after computing the SHA over it. As a result, integrity has to be computed as the image
-            // blocks are received, rather than over the entire image at the end. This pattern is NOT
-            // recommended since the computed integrity will be lost if the device rebooted during download.
-            //
-            sSHA256.Begin();
+            // Discard any previously stored image and record the URI of the image being
+            // downloaded, so that the download can be resumed if the device is reset.
+            WEAVE_ERROR err = GetImageStore().PrepareImage(aInParam.PrepareImageStorage.URI);
+            if (err != WEAVE_NO_ERROR)
+            {
+                NRF_LOG_INFO("Failed to prepare image storage: %s", NRF_LOG_PUSH(nl::ErrorStr(err)));
+            }
 
             // Tell the SoftwareUpdateManager that storage preparation has completed.
-            SoftwareUpdateMgr().PrepareImageStorageComplete(WEAVE_NO_ERROR);
+            SoftwareUpdateMgr().PrepareImageStorageComplete(err);
             break;
         }
 
         case SoftwareUpdateManager::kEvent_StartImageDownload:
         {
-            NRF_LOG_INFO("Starting Image Download");
+            GetDownloadScheduler().OnDownloadStart(GetImageStore().GetImageLength());
             break;
         }
         case SoftwareUpdateManager::kEvent_StoreImageBlock:
         {
-            sSHA256.AddData(aInParam.StoreImageBlock.DataBlock, aInParam.StoreImageBlock.DataBlockLen);
-            persistedImageLen += aInParam.StoreImageBlock.DataBlockLen;
-            NRF_LOG_INFO("Image Download: %" PRId32 " bytes received", persistedImageLen);
+            uint64_t storeStartMS = nl::Weave::System::Platform::Layer::GetClock_MonotonicMS();
+
+            WEAVE_ERROR err = GetImageStore().StoreBlock(aInParam.StoreImageBlock.DataBlock,
+                                                         aInParam.StoreImageBlock.DataBlockLen);
+            if (err != WEAVE_NO_ERROR)
+            {
+                NRF_LOG_INFO("Failed to store image block: %s", NRF_LOG_PUSH(nl::ErrorStr(err)));
+                aOutParam.StoreImageBlock.Error = err;
+            }
+
+            // The next block is not requested until this event returns, so flash writes pace the
+            // transfer without further buffering.  Progress logging is rate-limited by the scheduler.
+            GetDownloadScheduler().OnBlockStored(aInParam.StoreImageBlock.DataBlockLen, GetImageStore().GetImageLength(),
+                static_cast<uint32_t>(nl::Weave::System::Platform::Layer::GetClock_MonotonicMS() - storeStartMS));
             break;
         }
 
         case SoftwareUpdateManager::kEvent_ComputeImageIntegrity:
         {
-            NRF_LOG_INFO("Computing image integrity");
-            NRF_LOG_INFO("Total image length: %" PRId32, persistedImageLen);
+            GetDownloadScheduler().OnDownloadEnd();
 
-            // Make sure that the buffer provided in the parameter is large enough.
-            if (aInParam.ComputeImageIntegrity.IntegrityValueBufLen < sSHA256.kHashLength)
-            {
-                aOutParam.ComputeImageIntegrity.Error = WEAVE_ERROR_BUFFER_TOO_SMALL;
-            }
-            else
-            {
-                sSHA256.Finish(aInParam.ComputeImageIntegrity.IntegrityValueBuf);
-            }
+            NRF_LOG_INFO("Computing image integrity");
+            NRF_LOG_INFO("Total image length: %" PRId32, GetImageStore().GetImageLength());
+
+            // The image store hashes blocks as they are committed to flash and checkpoints the
+            // hash state, so the result does not depend on the device having stayed up for the
+            // entire download.
+            aOutParam.ComputeImageIntegrity.Error =
+                GetImageStore().ComputeIntegrity(aInParam.ComputeImageIntegrity.IntegrityValueBuf,
+                                                 aInParam.ComputeImageIntegrity.IntegrityValueBufLen);
             break;
         }
 
         case SoftwareUpdateManager::kEvent_ResetPartialImageInfo:
         {
-            // Reset the "persistent" state information related to the image being downloaded,
+            // Reset the persistent state information related to the image being downloaded,
             // This ensures that the image will be re-downloaded in its entirety during the next
             // software update attempt.
-            persistedImageLen = 0;
-            persistedImageURI[0] = '\0';
+            GetImageStore().Reset();
             break;
         }
 
@@ -741,6 +912,9 @@ void AppTask::HandleSoftwareUpdateEvent(void *apAppState,
 
         case SoftwareUpdateManager::kEvent_Finished:
         {
+            // Restore normal polling if the download was aborted or failed part way through.
+            GetDownloadScheduler().OnDownloadEnd();
+
             if (aInParam.Finished.Error == WEAVE_ERROR_NO_SW_UPDATE_AVAILABLE)
             {
                 NRF_LOG_INFO("No Software Update Available");
@@ -758,23 +932,17 @@ void AppTask::HandleSoftwareUpdateEvent(void *apAppState,
                 if (aInParam.Finished.Error == WEAVE_ERROR_STATUS_REPORT_RECEIVED)
                 {
                     NRF_LOG_INFO("Software Update failed: Received StatusReport %s",
-                                 nl::StatusReportStr(aInParam.Finished.StatusReport->mProfileId,
-                                                     aInParam.Finished.StatusReport->mStatusCode));
+                                 NRF_LOG_PUSH(nl::StatusReportStr(aInParam.Finished.StatusReport->mProfileId,
+                                                                  aInParam.Finished.StatusReport->mStatusCode)));
                 }
                 else
                 {
-                    NRF_LOG_INFO("Software Update failed: %s", nl::ErrorStr(aInParam.Finished.Error));
+                    NRF_LOG_INFO("Software Update failed: %s", NRF_LOG_PUSH(nl::ErrorStr(aInParam.Finished.Error)));
                 }
             }
             else
             {
                 NRF_LOG_INFO("Software Update Completed");
-
-                // Reset the "persistent" image state information.  Since we don't actually apply the
-                // downloaded image, this ensures that the next software update attempt will re-download
-                // the image.
-                persistedImageLen = 0;
-                persistedImageURI[0] = '\0';
             }
             break;
         }
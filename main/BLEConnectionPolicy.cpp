@@ -0,0 +1,311 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "BLEConnectionPolicy.h"
+#include "AppTask.h"
+#include "app_config.h"
+
+#include "app_util.h"
+#include "nrf_sdh_ble.h"
+#include "nrf_log.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <string.h>
+
+using namespace ::nl::Weave;
+using namespace ::nl::Weave::DeviceLayer;
+
+// Observe SoftDevice BLE events after the Weave device layer has handled them.
+#define BLE_CONNECTION_POLICY_OBSERVER_PRIO 3
+
+NRF_SDH_BLE_OBSERVER(sBLEConnectionPolicyObserver, BLE_CONNECTION_POLICY_OBSERVER_PRIO, BLEConnectionPolicy::SoftDeviceEventHandler,
+                     NULL);
+
+BLEConnectionPolicy BLEConnectionPolicy::sBLEConnectionPolicy;
+
+ret_code_t BLEConnectionPolicy::Init(void)
+{
+    mConnHandle      = BLE_CONN_HANDLE_INVALID;
+    mIsRelaxed       = false;
+    mPendingRequests = 0;
+    mConnectedMS     = 0;
+    mRxBytes         = 0;
+    memset(&mStats, 0, sizeof(mStats));
+
+    PlatformMgr().LockWeaveStack();
+    mIsProvisioned = ConfigurationMgr().IsFullyProvisioned();
+    PlatformMgr().UnlockWeaveStack();
+
+    PlatformMgr().AddEventHandler(PlatformEventHandler);
+
+    return NRF_SUCCESS;
+}
+
+void BLEConnectionPolicy::GetStats(BLEConnectionStats & aStats) const
+{
+    taskENTER_CRITICAL();
+    aStats = mStats;
+    taskEXIT_CRITICAL();
+}
+
+void BLEConnectionPolicy::RequestFastConnection(void)
+{
+    mIsRelaxed       = false;
+    mPendingRequests = kRequest_PhyUpdate | kRequest_ConnParamUpdate;
+    SendPendingRequests();
+}
+
+void BLEConnectionPolicy::RequestRelaxedConnection(void)
+{
+    mIsRelaxed = true;
+    mPendingRequests |= kRequest_ConnParamUpdate;
+    SendPendingRequests();
+}
+
+void BLEConnectionPolicy::SendPendingRequests(void)
+{
+    ret_code_t ret;
+
+    // The SoftDevice runs one link layer procedure at a time, and the GATT module starts the
+    // data length and MTU procedures as soon as a central connects.  A request refused with
+    // NRF_ERROR_BUSY stays pending and is sent again when a procedure completes.
+    if (mPendingRequests & kRequest_PhyUpdate)
+    {
+        ble_gap_phys_t phys;
+
+        phys.tx_phys = BLE_GAP_PHY_2MBPS;
+        phys.rx_phys = BLE_GAP_PHY_2MBPS;
+
+        ret = sd_ble_gap_phy_update(mConnHandle, &phys);
+        if (ret != NRF_ERROR_BUSY)
+        {
+            mPendingRequests &= ~kRequest_PhyUpdate;
+            if (ret != NRF_SUCCESS)
+            {
+                NRF_LOG_INFO("sd_ble_gap_phy_update() failed: 0x%08" PRIX32, ret);
+            }
+        }
+    }
+
+    if (mPendingRequests & kRequest_ConnParamUpdate)
+    {
+        ble_gap_conn_params_t connParams;
+
+        if (mIsRelaxed)
+        {
+            connParams.min_conn_interval = MSEC_TO_UNITS(BLE_CONN_SLOW_MIN_INTERVAL_MS, UNIT_1_25_MS);
+            connParams.max_conn_interval = MSEC_TO_UNITS(BLE_CONN_SLOW_MAX_INTERVAL_MS, UNIT_1_25_MS);
+            connParams.slave_latency     = BLE_CONN_SLOW_SLAVE_LATENCY;
+            connParams.conn_sup_timeout  = MSEC_TO_UNITS(BLE_CONN_SLOW_SUPERVISION_TIMEOUT_MS, UNIT_10_MS);
+        }
+        else
+        {
+            connParams.min_conn_interval = MSEC_TO_UNITS(BLE_CONN_FAST_MIN_INTERVAL_MS, UNIT_1_25_MS);
+            connParams.max_conn_interval = MSEC_TO_UNITS(BLE_CONN_FAST_MAX_INTERVAL_MS, UNIT_1_25_MS);
+            connParams.slave_latency     = 0;
+            connParams.conn_sup_timeout  = MSEC_TO_UNITS(BLE_CONN_FAST_SUPERVISION_TIMEOUT_MS, UNIT_10_MS);
+        }
+
+        ret = sd_ble_gap_conn_param_update(mConnHandle, &connParams);
+        if (ret != NRF_ERROR_BUSY)
+        {
+            mPendingRequests &= ~kRequest_ConnParamUpdate;
+            if (ret != NRF_SUCCESS)
+            {
+                NRF_LOG_INFO("sd_ble_gap_conn_param_update() failed: 0x%08" PRIX32, ret);
+            }
+        }
+    }
+}
+
+void BLEConnectionPolicy::SoftDeviceEventHandler(const ble_evt_t * aEvent, void * aContext)
+{
+    AppEvent event;
+
+    // Called in the context of the SoftDevice event interrupt.  Only the bytes written by the
+    // central are counted here; everything else is handed to the application task.
+    event.Type                = AppEvent::kEventType_BLE;
+    event.Handler             = BLEEventHandler;
+    event.BLEEvent.Id         = aEvent->header.evt_id;
+    event.BLEEvent.ConnHandle = aEvent->evt.gap_evt.conn_handle;
+
+    switch (aEvent->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            sBLEConnectionPolicy.mRxBytes = 0;
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            event.BLEEvent.RxBytes = sBLEConnectionPolicy.mRxBytes;
+            break;
+
+        case BLE_GAP_EVT_PHY_UPDATE:
+            event.BLEEvent.PhyUpdate.TxPhy  = aEvent->evt.gap_evt.params.phy_update.tx_phy;
+            event.BLEEvent.PhyUpdate.RxPhy  = aEvent->evt.gap_evt.params.phy_update.rx_phy;
+            event.BLEEvent.PhyUpdate.Status = aEvent->evt.gap_evt.params.phy_update.status;
+            break;
+
+        case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+            event.BLEEvent.ConnParamUpdate.ConnInterval = aEvent->evt.gap_evt.params.conn_param_update.conn_params.max_conn_interval;
+            event.BLEEvent.ConnParamUpdate.SlaveLatency = aEvent->evt.gap_evt.params.conn_param_update.conn_params.slave_latency;
+            break;
+
+        case BLE_GAP_EVT_DATA_LENGTH_UPDATE:
+            break;
+
+        case BLE_GATTS_EVT_EXCHANGE_MTU_REQUEST:
+            event.BLEEvent.ConnHandle = aEvent->evt.gatts_evt.conn_handle;
+            break;
+
+        case BLE_GATTC_EVT_EXCHANGE_MTU_RSP:
+            event.BLEEvent.ConnHandle = aEvent->evt.gattc_evt.conn_handle;
+            break;
+
+        case BLE_GATTS_EVT_WRITE:
+            // WoBLE supports a single peripheral link.
+            sBLEConnectionPolicy.mRxBytes += aEvent->evt.gatts_evt.params.write.len;
+            return;
+
+        default:
+            return;
+    }
+
+    GetAppTask().PostEventFromISR(&event);
+}
+
+void BLEConnectionPolicy::BLEEventHandler(AppEvent * aEvent)
+{
+    BLEConnectionPolicy & policy = sBLEConnectionPolicy;
+
+    switch (aEvent->BLEEvent.Id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+            policy.mConnHandle  = aEvent->BLEEvent.ConnHandle;
+            policy.mConnectedMS = System::Platform::Layer::GetClock_MonotonicMS();
+
+            taskENTER_CRITICAL();
+            policy.mStats.Connections++;
+            taskEXIT_CRITICAL();
+
+            if (policy.mIsProvisioned)
+            {
+                policy.RequestRelaxedConnection();
+            }
+            else
+            {
+                policy.RequestFastConnection();
+            }
+            break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+            if (aEvent->BLEEvent.ConnHandle == policy.mConnHandle)
+            {
+                uint32_t durationMS = static_cast<uint32_t>(System::Platform::Layer::GetClock_MonotonicMS() - policy.mConnectedMS);
+
+                taskENTER_CRITICAL();
+                policy.mStats.LastDurationMS = durationMS;
+                policy.mStats.LastRxBytes    = aEvent->BLEEvent.RxBytes;
+                taskEXIT_CRITICAL();
+
+                NRF_LOG_INFO("BLE connection closed after %" PRIu32 " ms, %" PRIu32 " bytes received", durationMS,
+                             aEvent->BLEEvent.RxBytes);
+
+                policy.mConnHandle      = BLE_CONN_HANDLE_INVALID;
+                policy.mPendingRequests = 0;
+            }
+            break;
+
+        case BLE_GAP_EVT_PHY_UPDATE:
+            NRF_LOG_INFO("BLE PHY updated: tx 0x%02x, rx 0x%02x (status 0x%02x)", aEvent->BLEEvent.PhyUpdate.TxPhy,
+                         aEvent->BLEEvent.PhyUpdate.RxPhy, aEvent->BLEEvent.PhyUpdate.Status);
+            break;
+
+        case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+        {
+            uint32_t interval = aEvent->BLEEvent.ConnParamUpdate.ConnInterval;
+
+            // Intervals are in units of 1.25 ms.
+            NRF_LOG_INFO("BLE connection interval %" PRIu32 ".%02" PRIu32 " ms, slave latency %u", (interval * 125) / 100,
+                         (interval * 125) % 100, aEvent->BLEEvent.ConnParamUpdate.SlaveLatency);
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    // A link layer procedure has completed, so retry any request the SoftDevice refused as busy.
+    if (policy.mPendingRequests != 0 && aEvent->BLEEvent.ConnHandle == policy.mConnHandle)
+    {
+        policy.SendPendingRequests();
+    }
+}
+
+void BLEConnectionPolicy::PlatformEventHandler(const WeaveDeviceEvent * event, intptr_t arg)
+{
+    AppEvent appEvent;
+
+    if (ConfigurationMgr().IsFullyProvisioned() == sBLEConnectionPolicy.mIsProvisioned)
+    {
+        return;
+    }
+
+    // Apply the change in the context of the application task, which owns the connection state.
+    appEvent.Type    = AppEvent::kEventType_BLE;
+    appEvent.Handler = ProvisioningEventHandler;
+    GetAppTask().PostEvent(&appEvent);
+}
+
+void BLEConnectionPolicy::ProvisioningEventHandler(AppEvent * aEvent)
+{
+    BLEConnectionPolicy & policy = sBLEConnectionPolicy;
+    bool isProvisioned;
+
+    PlatformMgr().LockWeaveStack();
+    isProvisioned = ConfigurationMgr().IsFullyProvisioned();
+    PlatformMgr().UnlockWeaveStack();
+
+    if (isProvisioned == policy.mIsProvisioned)
+    {
+        return;
+    }
+
+    policy.mIsProvisioned = isProvisioned;
+
+    // Provisioning has completed over the current connection: record how long it took and
+    // stop holding the connection at the fast interval.
+    if (isProvisioned && policy.mConnHandle != BLE_CONN_HANDLE_INVALID && !policy.mIsRelaxed)
+    {
+        uint32_t provisioningMS = static_cast<uint32_t>(System::Platform::Layer::GetClock_MonotonicMS() - policy.mConnectedMS);
+
+        taskENTER_CRITICAL();
+        policy.mStats.Provisioned++;
+        policy.mStats.LastProvisioningMS = provisioningMS;
+        if (provisioningMS > policy.mStats.MaxProvisioningMS)
+        {
+            policy.mStats.MaxProvisioningMS = provisioningMS;
+        }
+        taskEXIT_CRITICAL();
+
+        NRF_LOG_INFO("Provisioned over BLE in %" PRIu32 " ms (%" PRIu32 " bytes received)", provisioningMS, policy.mRxBytes);
+
+        policy.RequestRelaxedConnection();
+    }
+}
@@ -27,15 +27,20 @@
 #include "AppTask.h"
 #include "FreeRTOS.h"
 
-BoltLockManager BoltLockManager::sLock;
+#include <string.h>
 
-APP_TIMER_DEF(sLockTimer);
+BoltLockManager BoltLockManager::sLocks[BOLT_LOCK_ACTUATOR_COUNT];
 
-int BoltLockManager::Init()
+int BoltLockManager::Init(uint8_t aIndex)
 {
     ret_code_t ret;
 
-    ret = app_timer_create(&sLockTimer, APP_TIMER_MODE_SINGLE_SHOT, TimerEventHandler);
+    // Each actuator owns its timer, so that actuators can move (and auto-relock) concurrently.
+    memset(&mTimerData, 0, sizeof(mTimerData));
+    mTimer = &mTimerData;
+    mIndex = aIndex;
+
+    ret = app_timer_create(&mTimer, APP_TIMER_MODE_SINGLE_SHOT, TimerEventHandler);
     if (ret != NRF_SUCCESS)
     {
         NRF_LOG_INFO("app_timer_create() failed");
@@ -114,7 +119,7 @@ bool BoltLockManager::InitiateAction(int32_t aActor, Action_t aAction)
 
         if (mActionInitiated_CB)
         {
-            mActionInitiated_CB(aAction, aActor);
+            mActionInitiated_CB(*this, aAction, aActor);
         }
     }
 
@@ -124,7 +129,7 @@ bool BoltLockManager::InitiateAction(int32_t aActor, Action_t aAction)
 void BoltLockManager::StartTimer(uint32_t aTimeoutMs)
 {
     ret_code_t ret;
-    ret = app_timer_start(sLockTimer, pdMS_TO_TICKS(aTimeoutMs), this);
+    ret = app_timer_start(mTimer, pdMS_TO_TICKS(aTimeoutMs), this);
     if (ret != NRF_SUCCESS)
     {
         NRF_LOG_INFO("app_timer_start() failed");
@@ -135,7 +140,7 @@ void BoltLockManager::StartTimer(uint32_t aTimeoutMs)
 void BoltLockManager::CancelTimer(void)
 {
     ret_code_t ret;
-    ret = app_timer_stop(sLockTimer);
+    ret = app_timer_stop(mTimer);
     if (ret != NRF_SUCCESS)
     {
         NRF_LOG_INFO("app_timer_stop() failed");
@@ -148,7 +153,7 @@ void BoltLockManager::TimerEventHandler(void * p_context)
     BoltLockManager * lock = static_cast<BoltLockManager *>(p_context);
 
     // The timer event handler will be called in the context of the timer task
-    // once sLockTimer expires. Post an event to apptask queue with the actual handler
+    // once the lock's timer expires. Post an event to apptask queue with the actual handler
     // so that the event can be handled in the context of the apptask.
     AppEvent event;
     event.Type               = AppEvent::kEventType_Timer;
@@ -177,7 +182,7 @@ void BoltLockManager::AutoReLockTimerEventHandler(AppEvent * aEvent)
 
     lock->mAutoLockTimerArmed = false;
 
-    NRF_LOG_INFO("Auto Re-Lock has been triggered!");
+    NRF_LOG_INFO("Auto Re-Lock has been triggered on actuator %u", lock->mIndex);
 
     lock->InitiateAction(actor, LOCK_ACTION);
 }
@@ -203,7 +208,7 @@ void BoltLockManager::ActuatorMovementTimerEventHandler(AppEvent * aEvent)
     {
         if (lock->mActionCompleted_CB)
         {
-            lock->mActionCompleted_CB(actionCompleted);
+            lock->mActionCompleted_CB(*lock, actionCompleted);
         }
 
         if (lock->mAutoRelock && actionCompleted == UNLOCK_ACTION)
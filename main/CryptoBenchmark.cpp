@@ -0,0 +1,195 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Implementation of the crypto benchmark (see CryptoBenchmark.h).
+ */
+
+#include "CryptoBenchmark.h"
+#include "PersistentSHA256.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "nrf.h"
+#include "nrf_log.h"
+
+#include <mbedtls/aes.h>
+#include <mbedtls/ecdh.h>
+#include <mbedtls/sha256.h>
+
+#if CRYPTO_BENCHMARK_ENABLED
+
+#define CRYPTO_BENCHMARK_HASH_ITERATIONS 8
+
+#define CRYPTO_BENCHMARK_AES_BLOCKS 256
+
+#define CRYPTO_BENCHMARK_ECDH_ITERATIONS 4
+
+namespace {
+
+// One flash page of data, the unit in which software update images are hashed.
+uint8_t sData[4096];
+
+// A fixed P-256 key pair, so that the benchmark needs no random number generator.
+const uint8_t kPrivateKey[] = { 0x46, 0x89, 0xA1, 0x43, 0x3C, 0x96, 0x66, 0xD9, 0x58, 0xEF, 0x79, 0x39, 0x88, 0xFB, 0xF9, 0x47,
+                                0x67, 0x2E, 0x29, 0xE0, 0xD1, 0xB5, 0x4B, 0x69, 0xD6, 0x8B, 0xD6, 0x76, 0x2D, 0x3D, 0xDA, 0xEE };
+
+const uint8_t kPeerPublicKey[] = { 0x04, 0x3E, 0xF9, 0x96, 0x36, 0x7E, 0x03, 0xB6, 0xB0, 0xE8, 0xC8, 0x25, 0x73, 0xB1, 0xB8, 0xDC, 0x4A,
+                                   0xAE, 0x73, 0x50, 0xAE, 0xFE, 0x47, 0x26, 0x4D, 0xAA, 0x2C, 0xBC, 0x3C, 0x4F, 0x9C, 0x34, 0x1C, 0xB9,
+                                   0xD1, 0xD4, 0x4C, 0xB6, 0x5D, 0x4A, 0x83, 0xAB, 0x2D, 0x0A, 0x40, 0x84, 0xD2, 0x5E, 0xBF, 0x1C, 0xE1,
+                                   0xEC, 0x5E, 0x7E, 0xCF, 0x66, 0x59, 0x79, 0xF9, 0x2E, 0x8E, 0xD7, 0xF9, 0x5E, 0xFE };
+
+uint32_t BenchmarkSoftwareSHA256(void)
+{
+    mbedtls_sha256_context ctx;
+    uint8_t hash[32];
+    uint32_t start = DWT->CYCCNT;
+
+    for (uint32_t i = 0; i < CRYPTO_BENCHMARK_HASH_ITERATIONS; i++)
+    {
+        mbedtls_sha256_init(&ctx);
+        mbedtls_sha256_starts_ret(&ctx, 0);
+        mbedtls_sha256_update_ret(&ctx, sData, sizeof(sData));
+        mbedtls_sha256_finish_ret(&ctx, hash);
+        mbedtls_sha256_free(&ctx);
+    }
+
+    return DWT->CYCCNT - start;
+}
+
+uint32_t BenchmarkBackendSHA256(void)
+{
+    PersistentSHA256 sha;
+    uint8_t hash[PersistentSHA256::kHashLength];
+    uint32_t start = DWT->CYCCNT;
+
+    for (uint32_t i = 0; i < CRYPTO_BENCHMARK_HASH_ITERATIONS; i++)
+    {
+        sha.Begin();
+        sha.AddData(sData, sizeof(sData));
+        sha.Finish(hash);
+    }
+
+    return DWT->CYCCNT - start;
+}
+
+uint32_t BenchmarkAES128(void)
+{
+    mbedtls_aes_context ctx;
+    uint8_t block[16];
+    uint32_t start;
+    uint32_t cycles;
+
+    mbedtls_aes_init(&ctx);
+    mbedtls_aes_setkey_enc(&ctx, sData, 128);
+
+    start = DWT->CYCCNT;
+    for (uint32_t i = 0; i < CRYPTO_BENCHMARK_AES_BLOCKS; i++)
+    {
+        mbedtls_aes_crypt_ecb(&ctx, MBEDTLS_AES_ENCRYPT, &sData[i * sizeof(block)], block);
+    }
+    cycles = DWT->CYCCNT - start;
+
+    mbedtls_aes_free(&ctx);
+
+    return cycles;
+}
+
+uint32_t BenchmarkECDH(void)
+{
+    mbedtls_ecp_group grp;
+    mbedtls_ecp_point peerKey;
+    mbedtls_mpi privKey;
+    mbedtls_mpi secret;
+    uint32_t cycles = 0;
+    int ret;
+
+    mbedtls_ecp_group_init(&grp);
+    mbedtls_ecp_point_init(&peerKey);
+    mbedtls_mpi_init(&privKey);
+    mbedtls_mpi_init(&secret);
+
+    ret = mbedtls_ecp_group_load(&grp, MBEDTLS_ECP_DP_SECP256R1);
+    if (ret == 0)
+    {
+        ret = mbedtls_ecp_point_read_binary(&grp, &peerKey, kPeerPublicKey, sizeof(kPeerPublicKey));
+    }
+    if (ret == 0)
+    {
+        ret = mbedtls_mpi_read_binary(&privKey, kPrivateKey, sizeof(kPrivateKey));
+    }
+    if (ret == 0)
+    {
+        uint32_t start = DWT->CYCCNT;
+
+        for (uint32_t i = 0; i < CRYPTO_BENCHMARK_ECDH_ITERATIONS && ret == 0; i++)
+        {
+            ret = mbedtls_ecdh_compute_shared(&grp, &secret, &peerKey, &privKey, NULL, NULL);
+        }
+        cycles = DWT->CYCCNT - start;
+    }
+    if (ret != 0)
+    {
+        NRF_LOG_INFO("Crypto benchmark: ECDH failed: -0x%04" PRIx32, (uint32_t) -ret);
+        cycles = 0;
+    }
+
+    mbedtls_mpi_free(&secret);
+    mbedtls_mpi_free(&privKey);
+    mbedtls_ecp_point_free(&peerKey);
+    mbedtls_ecp_group_free(&grp);
+
+    return cycles;
+}
+
+} // namespace
+
+void RunCryptoBenchmark(void)
+{
+    const uint32_t hashBytes = CRYPTO_BENCHMARK_HASH_ITERATIONS * sizeof(sData);
+    const uint32_t aesBytes  = CRYPTO_BENCHMARK_AES_BLOCKS * 16;
+    uint32_t softwareSHACycles;
+    uint32_t backendSHACycles;
+    uint32_t aesCycles;
+    uint32_t ecdhCycles;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    for (uint32_t i = 0; i < sizeof(sData); i++)
+    {
+        sData[i] = static_cast<uint8_t>(i);
+    }
+
+    softwareSHACycles = BenchmarkSoftwareSHA256();
+    backendSHACycles  = BenchmarkBackendSHA256();
+    aesCycles         = BenchmarkAES128();
+    ecdhCycles        = BenchmarkECDH();
+
+    // Cycles per byte are reported in hundredths.
+    NRF_LOG_INFO("Crypto benchmark: SHA-256 software %" PRIu32 ", %s %" PRIu32 " cycles/100 bytes",
+                 (uint32_t) ((uint64_t) softwareSHACycles * 100 / hashBytes), (uint32_t) (APP_CRYPTO_BACKEND_CC310 ? "cc310" : "software"),
+                 (uint32_t) ((uint64_t) backendSHACycles * 100 / hashBytes));
+    NRF_LOG_INFO("Crypto benchmark: AES-128 software %" PRIu32 " cycles/100 bytes, P-256 ECDH software %" PRIu32 " cycles/op",
+                 (uint32_t) ((uint64_t) aesCycles * 100 / aesBytes), ecdhCycles / CRYPTO_BENCHMARK_ECDH_ITERATIONS);
+}
+
+#endif // CRYPTO_BENCHMARK_ENABLED
@@ -0,0 +1,291 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "DeltaPatcher.h"
+#include "PersistentSHA256.h"
+
+#include "nrf_log.h"
+
+#include <string.h>
+
+using namespace ::nl::Weave;
+
+namespace {
+
+inline uint32_t ReadLE32(const uint8_t * p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+        (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline uint32_t Min(uint32_t a, uint32_t b)
+{
+    return (a < b) ? a : b;
+}
+
+} // unnamed namespace
+
+void DeltaPatcher::Init(const uint8_t * aSource, uint32_t aSourceSize)
+{
+    mSource     = aSource;
+    mSourceSize = aSourceSize;
+    Begin();
+}
+
+void DeltaPatcher::Begin(void)
+{
+    memset(&mState, 0, sizeof(mState));
+    mState.Phase = kPhase_Header;
+}
+
+bool DeltaPatcher::IsDeltaImage(const uint8_t * aData, uint32_t aDataLen)
+{
+    return aDataLen >= sizeof(uint32_t) && ReadLE32(aData) == kMagic;
+}
+
+void DeltaPatcher::SaveState(uint8_t * aStateBuf) const
+{
+    memcpy(aStateBuf, &mState, sizeof(mState));
+}
+
+void DeltaPatcher::RestoreState(const uint8_t * aStateBuf)
+{
+    memcpy(&mState, aStateBuf, sizeof(mState));
+}
+
+WEAVE_ERROR DeltaPatcher::Apply(const uint8_t * aIn, uint32_t aInLen, uint32_t & aConsumed, uint8_t * aOut, uint32_t aOutLen,
+                                uint32_t & aProduced)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint32_t inPos  = 0;
+    uint32_t outPos = 0;
+    uint32_t n;
+
+    // Each pass either consumes input or produces output; the loop ends when one of the buffers
+    // is exhausted or the target image is complete.
+    while (mState.Phase != kPhase_Done)
+    {
+        switch (mState.Phase)
+        {
+            case kPhase_Header:
+            case kPhase_Control:
+            {
+                // Fixed-length fields may be split across input blocks, so accumulate them first.
+                uint8_t * field   = (mState.Phase == kPhase_Header) ? reinterpret_cast<uint8_t *>(&mState.Hdr) : mState.Control;
+                uint32_t fieldLen = (mState.Phase == kPhase_Header) ? sizeof(Header) : kControlLength;
+
+                n = Min(fieldLen - mState.FieldLen, aInLen - inPos);
+                if (n == 0)
+                {
+                    ExitNow();
+                }
+
+                memcpy(field + mState.FieldLen, aIn + inPos, n);
+                mState.FieldLen += n;
+                inPos += n;
+
+                if (mState.FieldLen == fieldLen)
+                {
+                    mState.FieldLen = 0;
+                    err             = (mState.Phase == kPhase_Header) ? ParseHeader() : ParseControl();
+                    SuccessOrExit(err);
+                }
+                break;
+            }
+
+            case kPhase_DiffToken:
+            {
+                if (inPos == aInLen)
+                {
+                    ExitNow();
+                }
+
+                uint8_t token = aIn[inPos++];
+
+                mState.RunRemaining = (token & 0x7F) + 1;
+                VerifyOrExit(mState.RunRemaining <= mState.DiffRemaining, err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+                mState.Phase = (token & 0x80) ? kPhase_DiffCopy : kPhase_DiffAdd;
+                break;
+            }
+
+            case kPhase_DiffCopy:
+            case kPhase_DiffAdd:
+            {
+                const uint8_t * src = mSource + mState.SourcePos;
+
+                n = Min(mState.RunRemaining, aOutLen - outPos);
+                if (mState.Phase == kPhase_DiffAdd)
+                {
+                    n = Min(n, aInLen - inPos);
+                }
+                if (n == 0)
+                {
+                    ExitNow();
+                }
+
+                if (mState.Phase == kPhase_DiffCopy)
+                {
+                    memcpy(aOut + outPos, src, n);
+                }
+                else
+                {
+                    for (uint32_t i = 0; i < n; i++)
+                    {
+                        aOut[outPos + i] = static_cast<uint8_t>(src[i] + aIn[inPos + i]);
+                    }
+                    inPos += n;
+                }
+
+                outPos += n;
+                mState.SourcePos += n;
+                mState.TargetPos += n;
+                mState.DiffRemaining -= n;
+                mState.RunRemaining -= n;
+
+                if (mState.RunRemaining == 0)
+                {
+                    NextDiffPhase();
+                    if (mState.Phase == kPhase_Control)
+                    {
+                        err = EndCommand();
+                        SuccessOrExit(err);
+                    }
+                }
+                break;
+            }
+
+            case kPhase_Extra:
+            {
+                n = Min(Min(mState.ExtraRemaining, aOutLen - outPos), aInLen - inPos);
+                if (n == 0)
+                {
+                    ExitNow();
+                }
+
+                memcpy(aOut + outPos, aIn + inPos, n);
+                inPos += n;
+                outPos += n;
+                mState.TargetPos += n;
+                mState.ExtraRemaining -= n;
+
+                if (mState.ExtraRemaining == 0)
+                {
+                    err = EndCommand();
+                    SuccessOrExit(err);
+                }
+                break;
+            }
+
+            default:
+                ExitNow(err = WEAVE_ERROR_INCORRECT_STATE);
+        }
+    }
+
+exit:
+    aConsumed = inPos;
+    aProduced = outPos;
+    return err;
+}
+
+WEAVE_ERROR DeltaPatcher::ParseHeader(void)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    const Header & hdr = mState.Hdr;
+    uint8_t sourceHash[kHashLength];
+    PersistentSHA256 sha256;
+
+    VerifyOrExit(hdr.Magic == kMagic, err = WEAVE_ERROR_INVALID_ARGUMENT);
+    VerifyOrExit(hdr.Version == kVersion, err = WEAVE_ERROR_UNSUPPORTED_MESSAGE_VERSION);
+    VerifyOrExit(hdr.TargetLen > 0, err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    // The patch is only meaningful against the exact image it was generated from.
+    VerifyOrExit(hdr.SourceLen <= mSourceSize, err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    sha256.Begin();
+    sha256.AddData(mSource, hdr.SourceLen);
+    sha256.Finish(sourceHash);
+    VerifyOrExit(memcmp(sourceHash, hdr.SourceHash, kHashLength) == 0, err = WEAVE_ERROR_INTEGRITY_CHECK_FAILED);
+
+    NRF_LOG_INFO("Applying delta image: %" PRIu32 " byte source, %" PRIu32 " byte target", hdr.SourceLen, hdr.TargetLen);
+
+    mState.Phase = kPhase_Control;
+
+exit:
+    if (err != WEAVE_NO_ERROR)
+    {
+        NRF_LOG_INFO("Delta image does not apply to running image: %s", NRF_LOG_PUSH(ErrorStr(err)));
+    }
+    return err;
+}
+
+WEAVE_ERROR DeltaPatcher::ParseControl(void)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint32_t diffLen  = ReadLE32(mState.Control);
+    uint32_t extraLen = ReadLE32(mState.Control + 4);
+
+    // Validate the whole command up front so that no bounds checks are needed per byte.
+    VerifyOrExit(diffLen <= mState.Hdr.TargetLen - mState.TargetPos, err = WEAVE_ERROR_INVALID_ARGUMENT);
+    VerifyOrExit(extraLen <= mState.Hdr.TargetLen - mState.TargetPos - diffLen, err = WEAVE_ERROR_INVALID_ARGUMENT);
+    VerifyOrExit(diffLen <= mState.Hdr.SourceLen - mState.SourcePos, err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    mState.DiffRemaining  = diffLen;
+    mState.ExtraRemaining = extraLen;
+    mState.Seek           = static_cast<int32_t>(ReadLE32(mState.Control + 8));
+
+    NextDiffPhase();
+    if (mState.Phase == kPhase_Control)
+    {
+        err = EndCommand();
+    }
+
+exit:
+    return err;
+}
+
+void DeltaPatcher::NextDiffPhase(void)
+{
+    if (mState.DiffRemaining > 0)
+    {
+        mState.Phase = kPhase_DiffToken;
+    }
+    else if (mState.ExtraRemaining > 0)
+    {
+        mState.Phase = kPhase_Extra;
+    }
+    else
+    {
+        mState.Phase = kPhase_Control;
+    }
+}
+
+WEAVE_ERROR DeltaPatcher::EndCommand(void)
+{
+    int64_t sourcePos = static_cast<int64_t>(mState.SourcePos) + mState.Seek;
+
+    if (sourcePos < 0 || sourcePos > mState.Hdr.SourceLen)
+    {
+        return WEAVE_ERROR_INVALID_ARGUMENT;
+    }
+
+    mState.SourcePos = static_cast<uint32_t>(sourcePos);
+    mState.Phase     = (mState.TargetPos == mState.Hdr.TargetLen) ? kPhase_Done : kPhase_Control;
+
+    return WEAVE_NO_ERROR;
+}
@@ -0,0 +1,381 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "Diagnostics.h"
+#include "AppTask.h"
+#include "BLEConnectionPolicy.h"
+#include "HeapMonitor.h"
+#include "MemManagerMonitor.h"
+#include "PoolAllocator.h"
+#include "RunTimeStats.h"
+#include "ServiceSession.h"
+#include "SleepProfiler.h"
+#include "StackMonitor.h"
+#include "WDMFeature.h"
+
+#include "app_config.h"
+#include "app_timer.h"
+#include "nrf.h"
+#include "nrf_log.h"
+
+#include "FreeRTOS.h"
+
+#include <Weave/DeviceLayer/WeaveDeviceLayer.h>
+#include <Weave/Profiles/data-management/DataManagement.h>
+
+using namespace ::nl::Weave::DeviceLayer;
+using namespace ::nl::Weave::Profiles::DataManagement;
+
+APP_TIMER_DEF(sDiagnosticsTimer);
+
+Diagnostics Diagnostics::sDiagnostics;
+
+ret_code_t Diagnostics::Init(void)
+{
+    ret_code_t ret;
+
+    ret = app_timer_create(&sDiagnosticsTimer, APP_TIMER_MODE_REPEATED, TimerEventHandler);
+    if (ret != NRF_SUCCESS)
+    {
+        NRF_LOG_INFO("app_timer_create() failed");
+        APP_ERROR_HANDLER(ret);
+    }
+
+    ret = app_timer_start(sDiagnosticsTimer, pdMS_TO_TICKS(DIAGNOSTICS_REPORT_INTERVAL_MS), NULL);
+    if (ret != NRF_SUCCESS)
+    {
+        NRF_LOG_INFO("app_timer_start() failed");
+        APP_ERROR_HANDLER(ret);
+    }
+
+    return ret;
+}
+
+void Diagnostics::Report(void)
+{
+    ReportHeap();
+    ReportPools();
+    ReportMemManager();
+    ReportStacks();
+    ReportRunTime();
+    ReportSleep();
+    ReportPublish();
+    ReportServiceRTT();
+    ReportServiceSession();
+    ReportCommands();
+    ReportBLE();
+}
+
+void Diagnostics::ReportHeap(void)
+{
+    HeapStats stats;
+    HeapLockStats lockStats;
+    HeapCallSiteStats sites[DIAGNOSTICS_REPORT_MAX_CALL_SITES];
+    size_t siteCount;
+
+    GetHeapStats(&stats);
+
+    NRF_LOG_INFO("Heap: size %" PRIu32 ", in use %" PRIu32 ", peak %" PRIu32 ", free %" PRIu32 ", largest free %" PRIu32,
+                 stats.TotalSize, stats.InUse, stats.PeakInUse, stats.FreeTotal, stats.LargestFree);
+    NRF_LOG_INFO("Heap: fragmentation %" PRIu32 "/1000, %" PRIu32 " allocs, %" PRIu32 " failures", stats.FragmentationPermille,
+                 stats.AllocCount, stats.FailCount);
+
+    GetHeapLockStats(&lockStats);
+    if (lockStats.LockCount != 0)
+    {
+        // With the mutex, hold times are not time spent with interrupts masked.
+        NRF_LOG_INFO("Heap lock (%s): %" PRIu32 " acquisitions, %" PRIu32 " contended, %s max %" PRIu32 " us, total %" PRIu32
+                     " ms",
+                     lockStats.InterruptsMasked ? "critical section" : "mutex", lockStats.LockCount, lockStats.ContentionCount,
+                     lockStats.InterruptsMasked ? "interrupts masked" : "held (interrupts enabled)",
+                     lockStats.MaxHoldCycles / (SystemCoreClock / 1000000),
+                     static_cast<uint32_t>(lockStats.TotalHoldCycles / (SystemCoreClock / 1000)));
+    }
+
+    // Report the largest consumers by call site.  Addresses can be resolved against the
+    // application ELF file with addr2line.
+    siteCount = GetHeapCallSiteStats(sites, DIAGNOSTICS_REPORT_MAX_CALL_SITES);
+    for (size_t i = 0; i < siteCount; i++)
+    {
+        NRF_LOG_INFO("  site 0x%08" PRIX32 ": %" PRIu32 " blocks, %" PRIu32 " bytes (peak %" PRIu32 "), %" PRIu32 " failures",
+                     static_cast<uint32_t>(sites[i].CallSite), sites[i].LiveCount, sites[i].LiveBytes, sites[i].PeakBytes,
+                     sites[i].FailCount);
+    }
+
+    PlatformMgr().LockWeaveStack();
+    LogFreeform(nl::Weave::Profiles::DataManagement::Debug,
+                "heap size=%" PRIu32 " inuse=%" PRIu32 " peak=%" PRIu32 " free=%" PRIu32 " largest=%" PRIu32 " frag=%" PRIu32
+                " fail=%" PRIu32,
+                stats.TotalSize, stats.InUse, stats.PeakInUse, stats.FreeTotal, stats.LargestFree, stats.FragmentationPermille,
+                stats.FailCount);
+    PlatformMgr().UnlockWeaveStack();
+}
+
+void Diagnostics::ReportPools(void)
+{
+    for (uint8_t i = 0; i < PoolAllocator::kPoolCount; i++)
+    {
+        const BlockPool & pool = GetPoolAllocator().GetPool(i);
+
+        NRF_LOG_INFO("Pool %u: %u x %u bytes, in use %u, peak %u, exhausted %" PRIu32, i, pool.GetBlockCount(),
+                     pool.GetBlockSize(), pool.GetInUse(), pool.GetPeakInUse(), pool.GetExhaustedCount());
+    }
+
+    NRF_LOG_INFO("Pool heap fallbacks: %" PRIu32, GetPoolAllocator().GetHeapFallbackCount());
+}
+
+void Diagnostics::ReportMemManager(void)
+{
+    MemManagerClassStats stats;
+
+    for (uint8_t i = 0; i < kMemManagerClassCount; i++)
+    {
+        GetMemManagerClassStats(i, &stats);
+
+        NRF_LOG_INFO("MemMgr %" PRIu32 " x %" PRIu32 ": pool peak %" PRIu32 ", demand peak %" PRIu32 ", max request %" PRIu32
+                     ", %" PRIu32 " fallbacks, %" PRIu32 " failures, recommend %" PRIu32 " blocks",
+                     stats.BlockCount, stats.BlockSize, stats.PeakOutstanding, stats.PeakDemand, stats.MaxRequestSize,
+                     stats.FallbackCount, stats.FailCount, GetMemManagerRecommendedBlockCount(&stats));
+    }
+}
+
+void Diagnostics::ReportStacks(void)
+{
+    TaskStackStats stats[STACK_MONITOR_MAX_TASKS];
+    size_t taskCount;
+
+    taskCount = GetTaskStackStats(stats, STACK_MONITOR_MAX_TASKS);
+
+    PlatformMgr().LockWeaveStack();
+
+    for (size_t i = 0; i < taskCount; i++)
+    {
+        NRF_LOG_INFO("Stack %s: size %" PRIu32 ", peak %" PRIu32 ", recommend %" PRIu32, (uint32_t) stats[i].Name,
+                     stats[i].StackSize, stats[i].PeakUsed, stats[i].Recommended);
+
+        LogFreeform(nl::Weave::Profiles::DataManagement::Debug, "stack task=%s size=%" PRIu32 " peak=%" PRIu32, stats[i].Name,
+                    stats[i].StackSize, stats[i].PeakUsed);
+    }
+
+    PlatformMgr().UnlockWeaveStack();
+}
+
+void Diagnostics::ReportRunTime(void)
+{
+    TaskRunTimeStats stats[RUN_TIME_STATS_MAX_TASKS];
+    RunTimeSummary summary;
+    size_t taskCount;
+
+    taskCount = GetTaskRunTimeStats(stats, RUN_TIME_STATS_MAX_TASKS, &summary);
+    if (taskCount == 0)
+    {
+        ExitNow();
+    }
+
+    NRF_LOG_INFO("CPU: %" PRIu32 " ms in %" PRIu32 " ms, duty cycle %" PRIu32 "/1000", summary.CPUTimeUS / 1000, summary.IntervalMS,
+                 summary.DutyCyclePermille);
+
+    PlatformMgr().LockWeaveStack();
+
+    for (size_t i = 0; i < taskCount; i++)
+    {
+        NRF_LOG_INFO("  %s: %" PRIu32 "/1000, %" PRIu32 " wakeups", (uint32_t) stats[i].Name, stats[i].CPUPermille, stats[i].Wakeups);
+
+        LogFreeform(nl::Weave::Profiles::DataManagement::Debug, "cpu task=%s permille=%" PRIu32 " wakeups=%" PRIu32, stats[i].Name,
+                    stats[i].CPUPermille, stats[i].Wakeups);
+    }
+
+    PlatformMgr().UnlockWeaveStack();
+
+exit:
+    return;
+}
+
+void Diagnostics::ReportSleep(void)
+{
+    SleepProfile profile;
+
+    GetSleepProfile(&profile);
+
+    NRF_LOG_INFO("Sleep: %" PRIu32 " periods, %" PRIu32 " ms asleep", profile.SleepCount,
+                 static_cast<uint32_t>((static_cast<uint64_t>(profile.SleepTicks) * 1000) / configTICK_RATE_HZ));
+
+    for (uint8_t i = 0; i < kWakeReason_Count; i++)
+    {
+        NRF_LOG_INFO("  woken by %s: %" PRIu32, (uint32_t) GetWakeReasonName(static_cast<WakeReason>(i)), profile.WakeCount[i]);
+    }
+
+    for (uint8_t i = 0; i < kSleepHistogramBuckets; i++)
+    {
+        if (profile.BucketCount[i] != 0)
+        {
+            NRF_LOG_INFO("  %s%" PRIu32 " ticks: %" PRIu32 " periods, %" PRIu32 " ticks", (uint32_t) ((i == 0) ? "< " : ">= "),
+                         (i == 0) ? 2 : (1UL << i), profile.BucketCount[i], profile.BucketTicks[i]);
+        }
+    }
+
+    PlatformMgr().LockWeaveStack();
+    LogFreeform(nl::Weave::Profiles::DataManagement::Debug,
+                "sleep count=%" PRIu32 " ticks=%" PRIu32 " tick=%" PRIu32 " timer=%" PRIu32 " radio=%" PRIu32 " gpio=%" PRIu32
+                " other=%" PRIu32,
+                profile.SleepCount, profile.SleepTicks, profile.WakeCount[kWakeReason_Tick], profile.WakeCount[kWakeReason_Timer],
+                profile.WakeCount[kWakeReason_Radio], profile.WakeCount[kWakeReason_GPIO], profile.WakeCount[kWakeReason_Other]);
+    PlatformMgr().UnlockWeaveStack();
+}
+
+void Diagnostics::ReportPublish(void)
+{
+    PublishStats stats;
+
+    PlatformMgr().LockWeaveStack();
+
+    WdmFeature().GetPublishStats(stats);
+
+    NRF_LOG_INFO("Publish: %" PRIu32 " immediate, %" PRIu32 " deferred, %" PRIu32 " recovered (max %" PRIu32 " ms), %" PRIu32
+                 " resubscribe kicks",
+                 stats.Immediate, stats.Deferred, stats.Recovered, stats.MaxRecoveryMS, stats.ResubscribeKicks);
+
+    LogFreeform(nl::Weave::Profiles::DataManagement::Debug,
+                "publish immediate=%" PRIu32 " deferred=%" PRIu32 " recovered=%" PRIu32 " maxrecovery=%" PRIu32 " kicks=%" PRIu32,
+                stats.Immediate, stats.Deferred, stats.Recovered, stats.MaxRecoveryMS, stats.ResubscribeKicks);
+
+    PlatformMgr().UnlockWeaveStack();
+}
+
+void Diagnostics::ReportServiceRTT(void)
+{
+    AckStats acks;
+
+    PlatformMgr().LockWeaveStack();
+
+    const RTTEstimator & rtt = WdmFeature().GetServiceRTT();
+
+    WdmFeature().GetAckStats(acks);
+
+    NRF_LOG_INFO("Service RTT: srtt %" PRIu32 " ms, rttvar %" PRIu32 " ms, retrans timeout %" PRIu32 " ms (%" PRIu32 " samples)",
+                 rtt.GetSmoothedRTT(), rtt.GetRTTVariance(), rtt.GetRetransTimeout(), rtt.GetSampleCount());
+
+    LogFreeform(nl::Weave::Profiles::DataManagement::Debug,
+                "rtt srtt=%" PRIu32 " rttvar=%" PRIu32 " rto=%" PRIu32 " samples=%" PRIu32, rtt.GetSmoothedRTT(), rtt.GetRTTVariance(),
+                rtt.GetRetransTimeout(), rtt.GetSampleCount());
+
+    NRF_LOG_INFO("Command acks: %" PRIu32 " piggybacked, %" PRIu32 " standalone (piggyback timeout %" PRIu32 " ms)",
+                 acks.Piggybacked, acks.Standalone, WdmFeature().GetAppliedPiggybackAckTimeout());
+
+    LogFreeform(nl::Weave::Profiles::DataManagement::Debug, "acks piggybacked=%" PRIu32 " standalone=%" PRIu32 " timeout=%" PRIu32,
+                acks.Piggybacked, acks.Standalone, WdmFeature().GetAppliedPiggybackAckTimeout());
+
+    PlatformMgr().UnlockWeaveStack();
+}
+
+void Diagnostics::ReportServiceSession(void)
+{
+    ServiceSessionStats stats;
+
+    PlatformMgr().LockWeaveStack();
+
+    GetServiceSession().GetStats(stats);
+
+    NRF_LOG_INFO("Service session: %s, %" PRIu32 " established, %" PRIu32 " failed, setup %" PRIu32 " ms (max %" PRIu32 " ms)",
+                 GetServiceSession().IsReady() ? "ready" : "not ready", stats.Established, stats.Failed, stats.LastSetupMS,
+                 stats.MaxSetupMS);
+
+    LogFreeform(nl::Weave::Profiles::DataManagement::Debug,
+                "session ready=%d established=%" PRIu32 " failed=%" PRIu32 " setup=%" PRIu32 " maxsetup=%" PRIu32,
+                GetServiceSession().IsReady(), stats.Established, stats.Failed, stats.LastSetupMS, stats.MaxSetupMS);
+
+    PlatformMgr().UnlockWeaveStack();
+}
+
+void Diagnostics::ReportCommands(void)
+{
+    for (uint8_t s = 0; s < BoltLockTraitDataSource::kCommandSource_Count; s++)
+    {
+        BoltLockTraitDataSource::CommandSource source = static_cast<BoltLockTraitDataSource::CommandSource>(s);
+        CommandStats total = { 0, 0, 0, 0, 0, 0 };
+        uint32_t avgLatencyMS;
+
+        for (uint8_t i = 0; i < BOLT_LOCK_ACTUATOR_COUNT; i++)
+        {
+            CommandStats stats;
+
+            WdmFeature().GetBoltLockTraitDataSource(i).GetCommandStats(source, stats);
+
+            total.Completed += stats.Completed;
+            total.Timed += stats.Timed;
+            total.Refused += stats.Refused;
+            total.Rejected += stats.Rejected;
+            total.TotalLatencyMS += stats.TotalLatencyMS;
+            if (stats.MaxLatencyMS > total.MaxLatencyMS)
+            {
+                total.MaxLatencyMS = stats.MaxLatencyMS;
+            }
+        }
+
+        avgLatencyMS = (total.Timed != 0) ? total.TotalLatencyMS / total.Timed : 0;
+
+        NRF_LOG_INFO("Commands (%s): %" PRIu32 " completed, %" PRIu32 " refused, %" PRIu32 " rejected",
+                     BoltLockTraitDataSource::GetCommandSourceName(source), total.Completed, total.Refused, total.Rejected);
+        NRF_LOG_INFO("Commands (%s): latency from initiation avg %" PRIu32 " ms, max %" PRIu32 " ms (%" PRIu32 " timed)",
+                     BoltLockTraitDataSource::GetCommandSourceName(source), avgLatencyMS, total.MaxLatencyMS, total.Timed);
+
+        PlatformMgr().LockWeaveStack();
+        LogFreeform(nl::Weave::Profiles::DataManagement::Debug,
+                    "commands source=%s completed=%" PRIu32 " refused=%" PRIu32 " rejected=%" PRIu32 " timed=%" PRIu32
+                    " avg=%" PRIu32 " max=%" PRIu32,
+                    BoltLockTraitDataSource::GetCommandSourceName(source), total.Completed, total.Refused, total.Rejected,
+                    total.Timed, avgLatencyMS, total.MaxLatencyMS);
+        PlatformMgr().UnlockWeaveStack();
+    }
+}
+
+void Diagnostics::ReportBLE(void)
+{
+    BLEConnectionStats stats;
+
+    GetBLEConnectionPolicy().GetStats(stats);
+
+    NRF_LOG_INFO("BLE: %" PRIu32 " connections, last %" PRIu32 " ms / %" PRIu32 " bytes, %" PRIu32 " provisioned (last %" PRIu32
+                 " ms, max %" PRIu32 " ms)",
+                 stats.Connections, stats.LastDurationMS, stats.LastRxBytes, stats.Provisioned, stats.LastProvisioningMS,
+                 stats.MaxProvisioningMS);
+
+    PlatformMgr().LockWeaveStack();
+    LogFreeform(nl::Weave::Profiles::DataManagement::Debug,
+                "ble conns=%" PRIu32 " duration=%" PRIu32 " rxbytes=%" PRIu32 " provisioned=%" PRIu32 " provtime=%" PRIu32
+                " maxprovtime=%" PRIu32,
+                stats.Connections, stats.LastDurationMS, stats.LastRxBytes, stats.Provisioned, stats.LastProvisioningMS,
+                stats.MaxProvisioningMS);
+    PlatformMgr().UnlockWeaveStack();
+}
+
+void Diagnostics::TimerEventHandler(void * p_context)
+{
+    AppEvent event;
+
+    // Generate the report in the context of the application task.
+    event.Type               = AppEvent::kEventType_Timer;
+    event.TimerEvent.Context = p_context;
+    event.Handler            = ReportEventHandler;
+    GetAppTask().PostEvent(&event);
+}
+
+void Diagnostics::ReportEventHandler(AppEvent * aEvent)
+{
+    sDiagnostics.Report();
+}
@@ -0,0 +1,105 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "DownloadScheduler.h"
+#include "ThreadPollingPolicy.h"
+
+#include "app_config.h"
+#include "nrf_log.h"
+
+#include <string.h>
+
+#include <Weave/DeviceLayer/WeaveDeviceLayer.h>
+
+using namespace ::nl::Weave;
+using namespace ::nl::Weave::DeviceLayer;
+
+DownloadScheduler DownloadScheduler::sDownloadScheduler;
+
+void DownloadScheduler::OnDownloadStart(uint32_t aResumeOffset)
+{
+    memset(&mStats, 0, sizeof(mStats));
+    mStartTimeMS    = System::Platform::Layer::GetClock_MonotonicMS();
+    mNextLogOffset  = aResumeOffset + SWU_PROGRESS_LOG_INTERVAL_BYTES;
+    mDownloadActive = true;
+
+    // Poll the parent at a fast rate for the duration of the transfer.  Each BDX block is a
+    // request/response exchange, so on a sleepy end device the download rate is otherwise
+    // bounded by one block per sleepy polling period.
+    GetThreadPollingPolicy().BeginActivity(ThreadPollingPolicy::kActivity_SoftwareUpdate);
+
+    NRF_LOG_INFO("Image download started at offset %" PRIu32, aResumeOffset);
+}
+
+void DownloadScheduler::OnBlockStored(uint32_t aBlockLen, uint32_t aImageLen, uint32_t aStoreTimeMS)
+{
+    mStats.BytesReceived += aBlockLen;
+    mStats.BlocksReceived++;
+    mStats.StoreTimeMS += aStoreTimeMS;
+    if (aBlockLen > mStats.MaxBlockLen)
+    {
+        mStats.MaxBlockLen = aBlockLen;
+    }
+
+    // Log progress at most once per SWU_PROGRESS_LOG_INTERVAL_BYTES rather than for every block;
+    // synchronous logging on every block measurably slows the transfer.
+    if (aImageLen >= mNextLogOffset)
+    {
+        UpdateElapsed();
+        NRF_LOG_INFO("Image Download: %" PRIu32 " bytes received (%" PRIu32 " B/s)", aImageLen, GetThroughput());
+        mNextLogOffset = aImageLen + SWU_PROGRESS_LOG_INTERVAL_BYTES;
+    }
+    else
+    {
+        mStats.SuppressedLogs++;
+    }
+}
+
+void DownloadScheduler::OnDownloadEnd(void)
+{
+    if (!mDownloadActive)
+    {
+        return;
+    }
+
+    UpdateElapsed();
+    mDownloadActive = false;
+
+    GetThreadPollingPolicy().EndActivity(ThreadPollingPolicy::kActivity_SoftwareUpdate);
+
+    NRF_LOG_INFO("Image download ended: %" PRIu32 " bytes in %" PRIu32 " ms (%" PRIu32 " B/s)", mStats.BytesReceived,
+                 mStats.ElapsedMS, GetThroughput());
+    NRF_LOG_INFO("  %" PRIu32 " blocks (max %" PRIu32 " B), %" PRIu32 " ms storing, ~%" PRIu32 " data polls, %" PRIu32
+                 " logs suppressed",
+                 mStats.BlocksReceived, mStats.MaxBlockLen, mStats.StoreTimeMS, mStats.EstimatedPolls, mStats.SuppressedLogs);
+}
+
+uint32_t DownloadScheduler::GetThroughput(void) const
+{
+    return (mStats.ElapsedMS != 0) ? static_cast<uint32_t>((static_cast<uint64_t>(mStats.BytesReceived) * 1000) / mStats.ElapsedMS)
+                                   : 0;
+}
+
+void DownloadScheduler::UpdateElapsed(void)
+{
+    mStats.ElapsedMS = static_cast<uint32_t>(System::Platform::Layer::GetClock_MonotonicMS() - mStartTimeMS);
+
+    // The radio is woken once per polling interval for the duration of the transfer; this
+    // dominates the energy cost of the download on a sleepy end device.
+    mStats.EstimatedPolls = mStats.ElapsedMS / SWU_DOWNLOAD_POLLING_INTERVAL_MS;
+}
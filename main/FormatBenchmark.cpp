@@ -0,0 +1,134 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Implementation of the formatting benchmark (see FormatBenchmark.h).
+ */
+
+#include "FormatBenchmark.h"
+#include "FormatUtils.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "app_config.h"
+#include "nrf.h"
+#include "nrf_log.h"
+
+#if FORMAT_BENCHMARK_ENABLED
+
+#define FORMAT_BENCHMARK_ITERATIONS 64
+
+// Bytes of stack painted below the caller's frame; more than either engine uses.
+#define FORMAT_BENCHMARK_STACK_PAINT 1024
+
+#define FORMAT_BENCHMARK_PAINT_PATTERN 0xA5A5A5A5
+
+namespace {
+
+typedef void (*FormatFunct)(void);
+
+char sBuf[24];
+volatile uint32_t sDecimal = 4294967295U;
+volatile uint64_t sHex     = 0x18B4300000000042ULL;
+
+void FormatDecimalFast(void)
+{
+    FormatDecimal(sBuf, sizeof(sBuf), sDecimal);
+}
+
+void FormatDecimalPrintf(void)
+{
+    snprintf(sBuf, sizeof(sBuf), "%" PRIu32, sDecimal);
+}
+
+void FormatHexFast(void)
+{
+    FormatHex(sBuf, sizeof(sBuf), sHex, 16);
+}
+
+void FormatHexPrintf(void)
+{
+    snprintf(sBuf, sizeof(sBuf), "%016" PRIX64, sHex);
+}
+
+void FormatDateFast(void)
+{
+    FormatDate(sBuf, sizeof(sBuf), 2019, 7, 4);
+}
+
+void FormatDatePrintf(void)
+{
+    snprintf(sBuf, sizeof(sBuf), "%04u-%02u-%02u", 2019U, 7U, 4U);
+}
+
+uint32_t MeasureCycles(FormatFunct aFunct)
+{
+    uint32_t start = DWT->CYCCNT;
+
+    for (uint32_t i = 0; i < FORMAT_BENCHMARK_ITERATIONS; i++)
+    {
+        aFunct();
+    }
+
+    return (DWT->CYCCNT - start) / FORMAT_BENCHMARK_ITERATIONS;
+}
+
+// Kept out of line so that the painted region starts below this function's own frame.
+__attribute__((noinline)) uint32_t MeasureStack(FormatFunct aFunct)
+{
+    volatile uint32_t * sp = reinterpret_cast<volatile uint32_t *>(__get_MSP());
+    volatile uint32_t * bottom = sp - FORMAT_BENCHMARK_STACK_PAINT / sizeof(uint32_t);
+    volatile uint32_t * p;
+
+    for (p = bottom; p < sp; p++)
+    {
+        *p = FORMAT_BENCHMARK_PAINT_PATTERN;
+    }
+
+    aFunct();
+
+    for (p = bottom; p < sp && *p == FORMAT_BENCHMARK_PAINT_PATTERN; p++)
+    {
+    }
+
+    return static_cast<uint32_t>(sp - p) * sizeof(uint32_t);
+}
+
+void Compare(const char * aName, FormatFunct aFast, FormatFunct aPrintf)
+{
+    NRF_LOG_INFO("Format benchmark: %s helper %" PRIu32 " cycles %" PRIu32 " bytes stack, snprintf %" PRIu32
+                 " cycles %" PRIu32 " bytes stack",
+                 (uint32_t) aName, MeasureCycles(aFast), MeasureStack(aFast), MeasureCycles(aPrintf), MeasureStack(aPrintf));
+}
+
+} // namespace
+
+void RunFormatBenchmark(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    // Run before the scheduler is started, so the caller is on the main stack.
+    Compare("decimal", FormatDecimalFast, FormatDecimalPrintf);
+    Compare("hex64", FormatHexFast, FormatHexPrintf);
+    Compare("date", FormatDateFast, FormatDatePrintf);
+}
+
+#endif // FORMAT_BENCHMARK_ENABLED
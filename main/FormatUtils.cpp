@@ -0,0 +1,118 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "FormatUtils.h"
+
+namespace {
+
+// Copies the digits in aDigits[0..aDigitCount) (least significant first) into aBuf,
+// most significant first, left padded with zeros to aMinWidth.
+size_t EmitDigits(char * aBuf, size_t aBufSize, const char * aDigits, size_t aDigitCount, uint8_t aMinWidth)
+{
+    size_t len = (aDigitCount > aMinWidth) ? aDigitCount : aMinWidth;
+    char * p   = aBuf;
+
+    if (aBufSize == 0)
+    {
+        return 0;
+    }
+
+    if (len >= aBufSize)
+    {
+        aBuf[0] = '\0';
+        return 0;
+    }
+
+    for (size_t i = aDigitCount; i < len; i++)
+    {
+        *p++ = '0';
+    }
+
+    while (aDigitCount > 0)
+    {
+        *p++ = aDigits[--aDigitCount];
+    }
+
+    *p = '\0';
+
+    return len;
+}
+
+} // unnamed namespace
+
+size_t FormatDecimal(char * aBuf, size_t aBufSize, uint32_t aValue, uint8_t aMinWidth)
+{
+    char digits[10];
+    size_t count = 0;
+
+    do
+    {
+        digits[count++] = static_cast<char>('0' + aValue % 10);
+        aValue /= 10;
+    } while (aValue != 0);
+
+    return EmitDigits(aBuf, aBufSize, digits, count, aMinWidth);
+}
+
+size_t FormatHex(char * aBuf, size_t aBufSize, uint64_t aValue, uint8_t aMinWidth)
+{
+    static const char kHexDigits[] = "0123456789ABCDEF";
+    char digits[16];
+    size_t count = 0;
+
+    // Work on 32-bit halves so that the common case of a value that fits in 32 bits
+    // never needs 64-bit shifts.
+    uint32_t lo = static_cast<uint32_t>(aValue);
+    uint32_t hi = static_cast<uint32_t>(aValue >> 32);
+
+    do
+    {
+        digits[count++] = kHexDigits[lo & 0xF];
+        lo >>= 4;
+    } while ((hi != 0) ? (count < 8) : (lo != 0));
+
+    while (hi != 0)
+    {
+        digits[count++] = kHexDigits[hi & 0xF];
+        hi >>= 4;
+    }
+
+    return EmitDigits(aBuf, aBufSize, digits, count, aMinWidth);
+}
+
+size_t FormatDate(char * aBuf, size_t aBufSize, uint16_t aYear, uint8_t aMonth, uint8_t aDayOfMonth)
+{
+    size_t len;
+
+    if (aBufSize < kFormatDateStrSize || aYear > 9999 || aMonth > 99 || aDayOfMonth > 99)
+    {
+        if (aBufSize > 0)
+        {
+            aBuf[0] = '\0';
+        }
+        return 0;
+    }
+
+    len         = FormatDecimal(aBuf, aBufSize, aYear, 4);
+    aBuf[len++] = '-';
+    len += FormatDecimal(aBuf + len, aBufSize - len, aMonth, 2);
+    aBuf[len++] = '-';
+    len += FormatDecimal(aBuf + len, aBufSize - len, aDayOfMonth, 2);
+
+    return len;
+}
@@ -0,0 +1,671 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "ImageStore.h"
+
+#include "app_config.h"
+#include "crc16.h"
+#include "nrf_log.h"
+#include "nrf_fstorage_sd.h"
+
+#include <stddef.h>
+#include <string.h>
+
+using namespace ::nl::Weave;
+
+extern "C" {
+// Flash regions reserved for the image slot and image state page (see openweave-nrf52840-lock-example.ld).
+extern char __start_image_slot_flash;
+extern char __stop_image_slot_flash;
+extern char __start_image_state_flash;
+extern char __start_app_flash;
+}
+
+#define ROUND_UP_4(n) (((n) + 3) & ~3)
+
+namespace {
+
+struct ImageInfoRecord
+{
+    uint16_t URILen;
+    uint16_t Reserved;
+    char URI[ROUND_UP_4(WEAVE_DEVICE_CONFIG_SOFTWARE_UPDATE_URI_LEN + 1)];
+};
+
+struct ProgressRecord
+{
+    uint32_t ImageLen;
+};
+
+struct HashCheckpointRecord
+{
+    uint32_t ImageLen;
+    uint32_t StateLen;
+    uint8_t State[ROUND_UP_4(PersistentSHA256::kStateLength)];
+};
+
+struct PatchCheckpointRecord
+{
+    uint32_t ImageLen;
+    uint32_t PatchLen;
+    uint32_t StateLen;
+    uint32_t PatcherStateLen;
+    uint8_t State[ROUND_UP_4(PersistentSHA256::kStateLength)];
+    uint8_t PatcherState[ROUND_UP_4(DeltaPatcher::kStateLength)];
+};
+
+union RecordBody
+{
+    ImageInfoRecord ImageInfo;
+    ProgressRecord Progress;
+    HashCheckpointRecord HashCheckpoint;
+    PatchCheckpointRecord PatchCheckpoint;
+};
+
+} // unnamed namespace
+
+nrf_fstorage_t ImageStore::sFStorage;
+ImageStore ImageStore::sImageStore;
+
+WEAVE_ERROR ImageStore::Init(void)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    ret_code_t ret;
+
+    mSlotStart  = reinterpret_cast<uint32_t>(&__start_image_slot_flash);
+    mSlotSize   = reinterpret_cast<uint32_t>(&__stop_image_slot_flash) - mSlotStart;
+    mStateStart = reinterpret_cast<uint32_t>(&__start_image_state_flash);
+
+    // Delta images are applied against the running application image.
+    mPatcher.Init(reinterpret_cast<const uint8_t *>(&__start_app_flash),
+                  reinterpret_cast<uint32_t>(&__start_image_slot_flash) - reinterpret_cast<uint32_t>(&__start_app_flash));
+
+#if configSUPPORT_STATIC_ALLOCATION
+    mFlashOpSem = xSemaphoreCreateBinaryStatic(&mFlashOpSemStruct);
+#else
+    mFlashOpSem = xSemaphoreCreateBinary();
+#endif
+    VerifyOrExit(mFlashOpSem != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+    sFStorage.evt_handler = FStorageEventHandler;
+    sFStorage.start_addr  = mSlotStart;
+    sFStorage.end_addr    = mStateStart + kPageSize;
+
+    ret = nrf_fstorage_init(&sFStorage, &nrf_fstorage_sd, NULL);
+    VerifyOrExit(ret == NRF_SUCCESS, err = WEAVE_ERROR_PERSISTED_STORAGE_FAIL);
+
+    err = LoadState();
+    SuccessOrExit(err);
+
+    if (mHaveImageInfo)
+    {
+        NRF_LOG_INFO("Partial %simage found in image slot (%" PRIu32 " bytes)", mIsDelta ? "delta " : "", mImageLen);
+    }
+
+exit:
+    return err;
+}
+
+WEAVE_ERROR ImageStore::PrepareImage(const char * aURI)
+{
+    WEAVE_ERROR err;
+    ImageInfoRecord info;
+    size_t uriLen = strlen(aURI);
+
+    VerifyOrExit(uriLen <= WEAVE_DEVICE_CONFIG_SOFTWARE_UPDATE_URI_LEN, err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    err = Reset();
+    SuccessOrExit(err);
+
+    mSHA256.Begin();
+
+    memset(&info, 0xFF, sizeof(info));
+    info.URILen = static_cast<uint16_t>(uriLen);
+    memcpy(info.URI, aURI, uriLen);
+
+    err = AppendRecord(kRecordType_ImageInfo, &info, offsetof(ImageInfoRecord, URI) + uriLen);
+    SuccessOrExit(err);
+
+    mHaveImageInfo = true;
+
+exit:
+    return err;
+}
+
+uint32_t ImageStore::GetPartialImageLength(const char * aURI)
+{
+    const RecordHeader * rec = FindRecord(kRecordType_ImageInfo);
+    const ImageInfoRecord * info;
+
+    if (rec == NULL)
+    {
+        return 0;
+    }
+
+    info = reinterpret_cast<const ImageInfoRecord *>(rec + 1);
+    if (info->URILen != strlen(aURI) || memcmp(info->URI, aURI, info->URILen) != 0)
+    {
+        return 0;
+    }
+
+    // A download aborted earlier in this session can leave a partial page in mPageBuf, and for
+    // delta images the patcher may have consumed input past the last checkpoint.  The resumed
+    // transfer starts at the offset reported here and PrepareImage() is not called again, so
+    // drop everything held in RAM and rebuild the hash (and patcher) state from the last record
+    // persisted in flash, exactly as after a reset.
+    if (LoadState() != WEAVE_NO_ERROR || !mHaveImageInfo)
+    {
+        return 0;
+    }
+
+    // Delta images resume from the patch offset of the last checkpoint.
+    return mIsDelta ? mPatchLen : mImageLen;
+}
+
+WEAVE_ERROR ImageStore::StoreBlock(const uint8_t * aData, uint32_t aDataLen)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit(mHaveImageInfo, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    // The image type is determined by the first block of the download.
+    if (GetImageLength() == 0 && mPatchLen == 0 && DeltaPatcher::IsDeltaImage(aData, aDataLen))
+    {
+        mIsDelta = true;
+        mPatcher.Begin();
+    }
+
+    if (mIsDelta)
+    {
+        ExitNow(err = StorePatchBlock(aData, aDataLen));
+    }
+
+    // Only the final page of an image may be partially filled.
+    VerifyOrExit((mImageLen % kPageSize) == 0, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    VerifyOrExit(GetImageLength() + aDataLen <= mSlotSize, err = WEAVE_ERROR_BUFFER_TOO_SMALL);
+
+    while (aDataLen > 0)
+    {
+        uint32_t copyLen = kPageSize - mPageBufLen;
+        if (copyLen > aDataLen)
+        {
+            copyLen = aDataLen;
+        }
+
+        memcpy(reinterpret_cast<uint8_t *>(mPageBuf) + mPageBufLen, aData, copyLen);
+        mPageBufLen += copyLen;
+        aData += copyLen;
+        aDataLen -= copyLen;
+
+        if (mPageBufLen == kPageSize)
+        {
+            err = FlushPage();
+            SuccessOrExit(err);
+        }
+    }
+
+exit:
+    return err;
+}
+
+WEAVE_ERROR ImageStore::ComputeIntegrity(uint8_t * aHashBuf, uint32_t aHashBufLen)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit(aHashBufLen >= kHashLength, err = WEAVE_ERROR_BUFFER_TOO_SMALL);
+    VerifyOrExit(mHaveImageInfo, err = WEAVE_ERROR_INCORRECT_STATE);
+    VerifyOrExit(!mIsDelta || mPatcher.IsComplete(), err = WEAVE_ERROR_INCORRECT_STATE);
+
+    if (!mHaveDigest)
+    {
+        // Commit the final, partially-filled page.
+        if (mPageBufLen > 0)
+        {
+            err = FlushPage();
+            SuccessOrExit(err);
+        }
+
+        // Every downloaded byte has already been fed to the hash by FlushPage() (or, for delta
+        // images, by StorePatchBlock()).
+        mSHA256.Finish(mDigest);
+
+        if (mIsDelta)
+        {
+            err = VerifyPatchedImage();
+            SuccessOrExit(err);
+        }
+
+        mHaveDigest = true;
+    }
+
+    memcpy(aHashBuf, mDigest, kHashLength);
+
+exit:
+    return err;
+}
+
+WEAVE_ERROR ImageStore::Reset(void)
+{
+    WEAVE_ERROR err;
+
+    err = EraseFlash(mStateStart, 1);
+    SuccessOrExit(err);
+
+    mStateWriteOffset = 0;
+    mImageLen         = 0;
+    mPageBufLen       = 0;
+    mPatchLen         = 0;
+    mIsDelta          = false;
+    mHaveImageInfo    = false;
+    mHaveDigest       = false;
+
+exit:
+    return err;
+}
+
+WEAVE_ERROR ImageStore::LoadState(void)
+{
+    const RecordHeader * checkpoint = NULL;
+    uint32_t offset                 = 0;
+
+    mImageLen         = 0;
+    mPageBufLen       = 0;
+    mPatchLen         = 0;
+    mIsDelta          = false;
+    mHaveImageInfo    = false;
+    mHaveDigest       = false;
+
+    while (offset + sizeof(RecordHeader) <= kPageSize)
+    {
+        const RecordHeader * rec = reinterpret_cast<const RecordHeader *>(mStateStart + offset);
+        const uint8_t * body     = reinterpret_cast<const uint8_t *>(rec + 1);
+
+        if (rec->Type == kRecordType_Erased)
+        {
+            break;
+        }
+
+        // A header with an impossible length is the result of an interrupted write.  Nothing
+        // after it can be trusted, so treat the state page as full.
+        if ((rec->Length % 4) != 0 || rec->Length > kPageSize - offset - sizeof(RecordHeader))
+        {
+            offset = kPageSize;
+            break;
+        }
+
+        offset += sizeof(RecordHeader) + rec->Length;
+
+        // Skip records whose body was torn by a reset.
+        if (crc16_compute(body, rec->Length, NULL) != rec->CRC)
+        {
+            continue;
+        }
+
+        switch (rec->Type)
+        {
+            case kRecordType_ImageInfo:
+                mHaveImageInfo = true;
+                mImageLen      = 0;
+                mPatchLen      = 0;
+                mIsDelta       = false;
+                checkpoint     = NULL;
+                break;
+
+            case kRecordType_HashCheckpoint:
+                mImageLen  = reinterpret_cast<const HashCheckpointRecord *>(body)->ImageLen;
+                checkpoint = rec;
+                break;
+
+            case kRecordType_PatchCheckpoint:
+                mImageLen  = reinterpret_cast<const PatchCheckpointRecord *>(body)->ImageLen;
+                mPatchLen  = reinterpret_cast<const PatchCheckpointRecord *>(body)->PatchLen;
+                mIsDelta   = true;
+                checkpoint = rec;
+                break;
+
+            case kRecordType_Progress:
+                mImageLen = reinterpret_cast<const ProgressRecord *>(body)->ImageLen;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    mStateWriteOffset = offset;
+
+    if (mHaveImageInfo)
+    {
+        return RestoreHashState(checkpoint);
+    }
+
+    return WEAVE_NO_ERROR;
+}
+
+WEAVE_ERROR ImageStore::RestoreHashState(const RecordHeader * aCheckpoint)
+{
+    const HashCheckpointRecord * cp = NULL;
+    uint32_t hashedLen              = 0;
+
+    if (aCheckpoint != NULL && aCheckpoint->Type == kRecordType_PatchCheckpoint)
+    {
+        const PatchCheckpointRecord * pcp = reinterpret_cast<const PatchCheckpointRecord *>(aCheckpoint + 1);
+
+        // Output written after the checkpoint is discarded and regenerated from the patch
+        // data, which is downloaded again from the checkpointed patch offset.
+        if (pcp->StateLen == PersistentSHA256::kStateLength && pcp->PatcherStateLen == DeltaPatcher::kStateLength &&
+            mSHA256.RestoreState(pcp->State) == WEAVE_NO_ERROR)
+        {
+            mPatcher.RestoreState(pcp->PatcherState);
+
+            NRF_LOG_INFO("Restored delta image state at patch offset %" PRIu32 " (%" PRIu32 " bytes written)", mPatchLen,
+                         mImageLen);
+
+            return WEAVE_NO_ERROR;
+        }
+
+        // Checkpoint from an incompatible build, or hash state from a different crypto
+        // backend; the patch cannot be replayed from here, so restart the download.
+        mIsDelta    = false;
+        mImageLen   = 0;
+        mPatchLen   = 0;
+        aCheckpoint = NULL;
+    }
+
+    if (aCheckpoint != NULL)
+    {
+        cp = reinterpret_cast<const HashCheckpointRecord *>(aCheckpoint + 1);
+
+        // Ignore checkpoints written by a build with a different hash context layout.
+        if (cp->StateLen != PersistentSHA256::kStateLength)
+        {
+            cp = NULL;
+        }
+    }
+
+    if (cp != NULL && mSHA256.RestoreState(cp->State) == WEAVE_NO_ERROR)
+    {
+        hashedLen = cp->ImageLen;
+    }
+    else
+    {
+        // No usable hash state; restart the hash over the whole of the slot contents.
+        mSHA256.Begin();
+    }
+
+    // Pages committed after the last checkpoint are hashed from the image slot.  This covers
+    // at most SWU_HASH_CHECKPOINT_INTERVAL_PAGES - 1 pages and reads only local flash.
+    if (hashedLen < mImageLen)
+    {
+        mSHA256.AddData(reinterpret_cast<const uint8_t *>(mSlotStart + hashedLen), mImageLen - hashedLen);
+    }
+
+    NRF_LOG_INFO("Restored image hash state at offset %" PRIu32 " (%" PRIu32 " bytes re-hashed)", hashedLen,
+                 mImageLen - hashedLen);
+
+    return WEAVE_NO_ERROR;
+}
+
+const ImageStore::RecordHeader * ImageStore::FindRecord(uint16_t aType) const
+{
+    const RecordHeader * found = NULL;
+    uint32_t offset            = 0;
+
+    while (offset + sizeof(RecordHeader) <= mStateWriteOffset)
+    {
+        const RecordHeader * rec = reinterpret_cast<const RecordHeader *>(mStateStart + offset);
+
+        if (rec->Type == kRecordType_Erased || rec->Length > mStateWriteOffset - offset - sizeof(RecordHeader))
+        {
+            break;
+        }
+
+        if (rec->Type == aType && crc16_compute(reinterpret_cast<const uint8_t *>(rec + 1), rec->Length, NULL) == rec->CRC)
+        {
+            found = rec;
+        }
+
+        offset += sizeof(RecordHeader) + rec->Length;
+    }
+
+    return found;
+}
+
+WEAVE_ERROR ImageStore::FlushPage(void)
+{
+    WEAVE_ERROR err;
+    uint32_t pageAddr = mSlotStart + mImageLen;
+    RecordBody record;
+
+    // Pad the final word with erased-flash bytes; fstorage writes whole words only.
+    memset(reinterpret_cast<uint8_t *>(mPageBuf) + mPageBufLen, 0xFF, ROUND_UP_4(mPageBufLen) - mPageBufLen);
+
+    // Erase each page just before it is written rather than erasing the whole slot up front.
+    // This spreads the (slow) erase operations over the download instead of stalling the
+    // SoftDevice flash scheduler for several seconds when storage is prepared.
+    err = EraseFlash(pageAddr, 1);
+    SuccessOrExit(err);
+
+    err = WriteFlash(pageAddr, mPageBuf, ROUND_UP_4(mPageBufLen));
+    SuccessOrExit(err);
+
+    // For delta images the hash covers the downloaded patch rather than the slot contents.
+    if (!mIsDelta)
+    {
+        mSHA256.AddData(reinterpret_cast<const uint8_t *>(mPageBuf), mPageBufLen);
+    }
+
+    mImageLen += mPageBufLen;
+    mPageBufLen = 0;
+
+    // Delta images can only be resumed from a checkpoint that captures the patch applier
+    // state, so no separate progress records are written for them.
+    if (mIsDelta)
+    {
+        if ((mImageLen % (kPageSize * SWU_HASH_CHECKPOINT_INTERVAL_PAGES)) == 0 && HaveRoomForCheckpoint() &&
+            mSHA256.SaveState(record.PatchCheckpoint.State) == WEAVE_NO_ERROR)
+        {
+            record.PatchCheckpoint.ImageLen        = mImageLen;
+            record.PatchCheckpoint.PatchLen        = mPatchLen;
+            record.PatchCheckpoint.StateLen        = PersistentSHA256::kStateLength;
+            record.PatchCheckpoint.PatcherStateLen = DeltaPatcher::kStateLength;
+            mPatcher.SaveState(record.PatchCheckpoint.PatcherState);
+            err = AppendRecord(kRecordType_PatchCheckpoint, &record.PatchCheckpoint, sizeof(record.PatchCheckpoint));
+            SuccessOrExit(err);
+        }
+        ExitNow();
+    }
+
+    // Periodically checkpoint the running hash along with the progress; otherwise just
+    // record the progress.
+    if ((mImageLen % (kPageSize * SWU_HASH_CHECKPOINT_INTERVAL_PAGES)) == 0 && HaveRoomForCheckpoint() &&
+        mSHA256.SaveState(record.HashCheckpoint.State) == WEAVE_NO_ERROR)
+    {
+        record.HashCheckpoint.ImageLen = mImageLen;
+        record.HashCheckpoint.StateLen = PersistentSHA256::kStateLength;
+        err = AppendRecord(kRecordType_HashCheckpoint, &record.HashCheckpoint,
+                           offsetof(HashCheckpointRecord, State) + PersistentSHA256::kStateLength);
+        SuccessOrExit(err);
+    }
+    else
+    {
+        record.Progress.ImageLen = mImageLen;
+        err                      = AppendRecord(kRecordType_Progress, &record.Progress, sizeof(record.Progress));
+        SuccessOrExit(err);
+    }
+
+exit:
+    return err;
+}
+
+WEAVE_ERROR ImageStore::StorePatchBlock(const uint8_t * aData, uint32_t aDataLen)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint32_t consumed;
+    uint32_t produced;
+
+    while (aDataLen > 0)
+    {
+        // Data beyond the end of the patch indicates a corrupt or mismatched image.
+        VerifyOrExit(!mPatcher.IsComplete(), err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+        err = mPatcher.Apply(aData, aDataLen, consumed, reinterpret_cast<uint8_t *>(mPageBuf) + mPageBufLen,
+                             kPageSize - mPageBufLen, produced);
+        SuccessOrExit(err);
+
+        VerifyOrExit(!mPatcher.HaveHeader() || mPatcher.GetHeader().TargetLen <= mSlotSize, err = WEAVE_ERROR_BUFFER_TOO_SMALL);
+
+        // Only the consumed portion is hashed, so that a checkpoint taken by FlushPage() below
+        // captures the hash and applier state at the same patch offset.
+        mSHA256.AddData(aData, consumed);
+        mPatchLen += consumed;
+        aData += consumed;
+        aDataLen -= consumed;
+        mPageBufLen += produced;
+
+        if (mPageBufLen == kPageSize)
+        {
+            err = FlushPage();
+            SuccessOrExit(err);
+        }
+    }
+
+exit:
+    return err;
+}
+
+WEAVE_ERROR ImageStore::VerifyPatchedImage(void)
+{
+    PersistentSHA256 sha256;
+    uint8_t targetHash[kHashLength];
+
+    if (mImageLen != mPatcher.GetHeader().TargetLen)
+    {
+        return WEAVE_ERROR_INCORRECT_STATE;
+    }
+
+    // Hash the reconstructed image from the slot, which also catches flash write errors.
+    sha256.Begin();
+    sha256.AddData(reinterpret_cast<const uint8_t *>(mSlotStart), mImageLen);
+    sha256.Finish(targetHash);
+
+    if (memcmp(targetHash, mPatcher.GetHeader().TargetHash, kHashLength) != 0)
+    {
+        NRF_LOG_INFO("Reconstructed image does not match delta image target hash");
+        return WEAVE_ERROR_INTEGRITY_CHECK_FAILED;
+    }
+
+    return WEAVE_NO_ERROR;
+}
+
+bool ImageStore::HaveRoomForCheckpoint(void) const
+{
+    // Checkpoints are optional; never let one consume space needed for the progress
+    // records of the remaining pages.
+    uint32_t remainingPages = (mSlotSize - mImageLen) / kPageSize;
+    uint32_t required       = (sizeof(RecordHeader) + sizeof(HashCheckpointRecord)) +
+        remainingPages * (sizeof(RecordHeader) + sizeof(ProgressRecord));
+
+    if (mIsDelta)
+    {
+        required = sizeof(RecordHeader) + sizeof(PatchCheckpointRecord);
+    }
+
+    return mStateWriteOffset + required <= kPageSize;
+}
+
+WEAVE_ERROR ImageStore::AppendRecord(uint16_t aType, const void * aBody, uint16_t aBodyLen)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint32_t recordBuf[(sizeof(RecordHeader) + sizeof(RecordBody)) / sizeof(uint32_t)];
+    RecordHeader * rec = reinterpret_cast<RecordHeader *>(recordBuf);
+    uint8_t * body     = reinterpret_cast<uint8_t *>(rec + 1);
+    uint16_t paddedLen = ROUND_UP_4(aBodyLen);
+
+    VerifyOrExit(sizeof(RecordHeader) + paddedLen <= sizeof(recordBuf), err = WEAVE_ERROR_INVALID_ARGUMENT);
+    VerifyOrExit(mStateWriteOffset + sizeof(RecordHeader) + paddedLen <= kPageSize, err = WEAVE_ERROR_BUFFER_TOO_SMALL);
+
+    memcpy(body, aBody, aBodyLen);
+    memset(body + aBodyLen, 0xFF, paddedLen - aBodyLen);
+
+    rec->Type     = aType;
+    rec->Length   = paddedLen;
+    rec->CRC      = crc16_compute(body, paddedLen, NULL);
+    rec->Reserved = 0xFFFF;
+
+    // Header and body are written in a single operation so that an interrupted write
+    // can always be detected by the CRC check in LoadState().
+    err = WriteFlash(mStateStart + mStateWriteOffset, recordBuf, sizeof(RecordHeader) + paddedLen);
+    SuccessOrExit(err);
+
+    mStateWriteOffset += sizeof(RecordHeader) + paddedLen;
+
+exit:
+    return err;
+}
+
+WEAVE_ERROR ImageStore::EraseFlash(uint32_t aAddr, uint32_t aNumPages)
+{
+    ret_code_t ret;
+
+    ret = nrf_fstorage_erase(&sFStorage, aAddr, aNumPages, NULL);
+    if (ret == NRF_SUCCESS)
+    {
+        xSemaphoreTake(mFlashOpSem, portMAX_DELAY);
+        ret = mFlashOpResult;
+    }
+
+    if (ret != NRF_SUCCESS)
+    {
+        NRF_LOG_INFO("Image slot flash erase failed at 0x%08" PRIX32 ": %" PRIu32, aAddr, ret);
+        return WEAVE_ERROR_PERSISTED_STORAGE_FAIL;
+    }
+
+    return WEAVE_NO_ERROR;
+}
+
+WEAVE_ERROR ImageStore::WriteFlash(uint32_t aAddr, const void * aData, uint32_t aDataLen)
+{
+    ret_code_t ret;
+
+    ret = nrf_fstorage_write(&sFStorage, aAddr, aData, aDataLen, NULL);
+    if (ret == NRF_SUCCESS)
+    {
+        xSemaphoreTake(mFlashOpSem, portMAX_DELAY);
+        ret = mFlashOpResult;
+    }
+
+    if (ret != NRF_SUCCESS)
+    {
+        NRF_LOG_INFO("Image slot flash write failed at 0x%08" PRIX32 ": %" PRIu32, aAddr, ret);
+        return WEAVE_ERROR_PERSISTED_STORAGE_FAIL;
+    }
+
+    return WEAVE_NO_ERROR;
+}
+
+void ImageStore::FStorageEventHandler(nrf_fstorage_evt_t * aEvent)
+{
+    BaseType_t yieldRequired = pdFALSE;
+
+    // Called from the SoftDevice SoC event dispatch once a queued flash operation completes.
+    sImageStore.mFlashOpResult = aEvent->result;
+    xSemaphoreGiveFromISR(sImageStore.mFlashOpSem, &yieldRequired);
+    portYIELD_FROM_ISR(yieldRequired);
+}
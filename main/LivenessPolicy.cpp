@@ -0,0 +1,135 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "LivenessPolicy.h"
+#include "AppTask.h"
+#include "PowerMonitor.h"
+#include "WDMFeature.h"
+
+#include "app_timer.h"
+#include "nrf_log.h"
+
+#include "FreeRTOS.h"
+
+APP_TIMER_DEF(sLivenessPolicyTimer);
+
+const uint32_t LivenessPolicy::sLivenessTimeoutSec[kPowerState_Count] = {
+    LIVENESS_TIMEOUT_EXTERNAL_POWER_SEC, // kPowerState_External
+    LIVENESS_TIMEOUT_BATTERY_SEC,        // kPowerState_Battery
+    LIVENESS_TIMEOUT_LOW_BATTERY_SEC,    // kPowerState_LowBattery
+};
+
+LivenessPolicy LivenessPolicy::sLivenessPolicy;
+
+ret_code_t LivenessPolicy::Init(void)
+{
+    ret_code_t ret;
+
+    mPowerState = kPowerState_Battery;
+    mSupplyMV   = 0;
+
+    // Determine the initial power state.  The service subscriptions are not yet established,
+    // so there is nothing to renegotiate.
+    Update();
+
+    ret = app_timer_create(&sLivenessPolicyTimer, APP_TIMER_MODE_REPEATED, TimerEventHandler);
+    if (ret != NRF_SUCCESS)
+    {
+        NRF_LOG_INFO("app_timer_create() failed");
+        APP_ERROR_HANDLER(ret);
+    }
+
+    ret = app_timer_start(sLivenessPolicyTimer, pdMS_TO_TICKS(LIVENESS_POLICY_UPDATE_INTERVAL_MS), NULL);
+    if (ret != NRF_SUCCESS)
+    {
+        NRF_LOG_INFO("app_timer_start() failed");
+        APP_ERROR_HANDLER(ret);
+    }
+
+    return ret;
+}
+
+const char * LivenessPolicy::GetPowerStateName(PowerState aState)
+{
+    switch (aState)
+    {
+        case kPowerState_External:
+            return "external";
+        case kPowerState_Battery:
+            return "battery";
+        case kPowerState_LowBattery:
+            return "low battery";
+        default:
+            return "unknown";
+    }
+}
+
+bool LivenessPolicy::Update(void)
+{
+    PowerState newState;
+
+    mSupplyMV = MeasureSupplyVoltage();
+
+    if (GetPowerSource() == kPowerSource_External)
+    {
+        newState = kPowerState_External;
+    }
+    else if (mSupplyMV < LIVENESS_LOW_BATTERY_MV)
+    {
+        newState = kPowerState_LowBattery;
+    }
+    else if (mPowerState == kPowerState_LowBattery && mSupplyMV < LIVENESS_LOW_BATTERY_MV + LIVENESS_LOW_BATTERY_HYSTERESIS_MV)
+    {
+        newState = kPowerState_LowBattery;
+    }
+    else
+    {
+        newState = kPowerState_Battery;
+    }
+
+    if (newState == mPowerState)
+    {
+        return false;
+    }
+
+    NRF_LOG_INFO("Power state %s (%" PRIu32 " mV): liveness timeout %" PRIu32 " s", (uint32_t) GetPowerStateName(newState),
+                 mSupplyMV, sLivenessTimeoutSec[newState]);
+
+    mPowerState = newState;
+
+    return true;
+}
+
+void LivenessPolicy::TimerEventHandler(void * p_context)
+{
+    AppEvent event;
+
+    // Sample the power state in the context of the application task.
+    event.Type               = AppEvent::kEventType_Timer;
+    event.TimerEvent.Context = p_context;
+    event.Handler            = UpdateEventHandler;
+    GetAppTask().PostEvent(&event);
+}
+
+void LivenessPolicy::UpdateEventHandler(AppEvent * aEvent)
+{
+    if (sLivenessPolicy.Update())
+    {
+        WdmFeature().RenegotiateLiveness();
+    }
+}
@@ -0,0 +1,148 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "PersistentSHA256.h"
+
+#include <string.h>
+
+#if APP_CRYPTO_BACKEND_CC310
+
+#include "nrf_log.h"
+#include "nrfx_common.h"
+
+#define PERSISTENT_SHA256_BACKEND kBackend_CC310
+
+void PersistentSHA256::Begin(void)
+{
+    ret_code_t ret = nrf_crypto_hash_init(&mCtx, &g_nrf_crypto_hash_sha256_info);
+    if (ret != NRF_SUCCESS)
+    {
+        NRF_LOG_INFO("nrf_crypto_hash_init() failed: 0x%" PRIx32, ret);
+    }
+    mActive = (ret == NRF_SUCCESS);
+}
+
+void PersistentSHA256::AddData(const uint8_t * aData, uint32_t aDataLen)
+{
+    ret_code_t ret;
+
+    // The CryptoCell DMA engine can only read from RAM.  Data held in flash (e.g. image pages
+    // being re-hashed from the image slot) is staged through a small RAM buffer.
+    if (nrfx_is_in_ram(aData))
+    {
+        ret = nrf_crypto_hash_update(&mCtx, aData, aDataLen);
+    }
+    else
+    {
+        uint8_t stagingBuf[256];
+
+        ret = NRF_SUCCESS;
+        while (aDataLen > 0 && ret == NRF_SUCCESS)
+        {
+            uint32_t chunkLen = (aDataLen > sizeof(stagingBuf)) ? sizeof(stagingBuf) : aDataLen;
+            memcpy(stagingBuf, aData, chunkLen);
+            ret = nrf_crypto_hash_update(&mCtx, stagingBuf, chunkLen);
+            aData += chunkLen;
+            aDataLen -= chunkLen;
+        }
+    }
+
+    if (ret != NRF_SUCCESS)
+    {
+        NRF_LOG_INFO("nrf_crypto_hash_update() failed: 0x%" PRIx32, ret);
+    }
+}
+
+void PersistentSHA256::Finish(uint8_t * aHashBuf)
+{
+    size_t hashLen = kHashLength;
+    ret_code_t ret = nrf_crypto_hash_finalize(&mCtx, aHashBuf, &hashLen);
+    if (ret != NRF_SUCCESS)
+    {
+        NRF_LOG_INFO("nrf_crypto_hash_finalize() failed: 0x%" PRIx32, ret);
+    }
+    mActive = false;
+}
+
+#else // APP_CRYPTO_BACKEND_CC310
+
+#define PERSISTENT_SHA256_BACKEND kBackend_Software
+
+void PersistentSHA256::Begin(void)
+{
+    mbedtls_sha256_init(&mCtx);
+    mbedtls_sha256_starts_ret(&mCtx, 0);
+    mActive = true;
+}
+
+void PersistentSHA256::AddData(const uint8_t * aData, uint32_t aDataLen)
+{
+    mbedtls_sha256_update_ret(&mCtx, aData, aDataLen);
+}
+
+void PersistentSHA256::Finish(uint8_t * aHashBuf)
+{
+    mbedtls_sha256_finish_ret(&mCtx, aHashBuf);
+    mbedtls_sha256_free(&mCtx);
+    mActive = false;
+}
+
+#endif // APP_CRYPTO_BACKEND_CC310
+
+PersistentSHA256::PersistentSHA256(void) : mActive(false) { }
+
+WEAVE_ERROR PersistentSHA256::SaveState(uint8_t * aStateBuf) const
+{
+    StateHeader hdr;
+
+    if (!mActive)
+    {
+        return WEAVE_ERROR_INCORRECT_STATE;
+    }
+
+    hdr.Backend    = PERSISTENT_SHA256_BACKEND;
+    hdr.Version    = kStateVersion;
+    hdr.ContextLen = sizeof(mCtx);
+
+    // Neither backend context holds pointers into RAM (the nrf_crypto context only
+    // references the constant SHA-256 algorithm descriptor in flash), so a plain copy
+    // is a complete snapshot of the running hash for a given firmware build.
+    memcpy(aStateBuf, &hdr, sizeof(hdr));
+    memcpy(aStateBuf + sizeof(hdr), &mCtx, sizeof(mCtx));
+
+    return WEAVE_NO_ERROR;
+}
+
+WEAVE_ERROR PersistentSHA256::RestoreState(const uint8_t * aStateBuf)
+{
+    StateHeader hdr;
+
+    memcpy(&hdr, aStateBuf, sizeof(hdr));
+
+    mActive = false;
+
+    if (hdr.Backend != PERSISTENT_SHA256_BACKEND || hdr.Version != kStateVersion || hdr.ContextLen != sizeof(mCtx))
+    {
+        return WEAVE_ERROR_INVALID_ARGUMENT;
+    }
+
+    memcpy(&mCtx, aStateBuf + sizeof(hdr), sizeof(mCtx));
+    mActive = true;
+
+    return WEAVE_NO_ERROR;
+}
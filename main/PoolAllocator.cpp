@@ -0,0 +1,160 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "PoolAllocator.h"
+
+#include "app_config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Pool storage.  Block sizes are multiples of 8 so every block is suitably aligned for
+// any mbedTLS structure.
+static uint8_t sSmallPoolStorage[POOL_ALLOCATOR_SMALL_BLOCK_SIZE * POOL_ALLOCATOR_SMALL_BLOCK_COUNT] __attribute__((aligned(8)));
+static uint8_t sMediumPoolStorage[POOL_ALLOCATOR_MEDIUM_BLOCK_SIZE * POOL_ALLOCATOR_MEDIUM_BLOCK_COUNT] __attribute__((aligned(8)));
+static uint8_t sLargePoolStorage[POOL_ALLOCATOR_LARGE_BLOCK_SIZE * POOL_ALLOCATOR_LARGE_BLOCK_COUNT] __attribute__((aligned(8)));
+
+PoolAllocator PoolAllocator::sPoolAllocator;
+
+void BlockPool::Init(uint8_t * aStorage, uint16_t aBlockSize, uint16_t aBlockCount)
+{
+    mStorage        = aStorage;
+    mBlockSize      = aBlockSize;
+    mBlockCount     = aBlockCount;
+    mInUse          = 0;
+    mPeakInUse      = 0;
+    mExhaustedCount = 0;
+
+    for (uint16_t i = 0; i < aBlockCount; i++)
+    {
+        Link(i) = (i + 1 < aBlockCount) ? i + 1 : kEndOfList;
+    }
+
+    mHead = (aBlockCount > 0) ? 0 : kEndOfList;
+}
+
+void * BlockPool::Alloc(void)
+{
+    uint32_t head = __atomic_load_n(&mHead, __ATOMIC_ACQUIRE);
+    uint32_t newHead;
+    uint16_t index;
+    uint16_t inUse;
+    uint16_t peak;
+
+    do
+    {
+        index = static_cast<uint16_t>(head);
+        if (index == kEndOfList)
+        {
+            __atomic_fetch_add(&mExhaustedCount, 1, __ATOMIC_RELAXED);
+            return NULL;
+        }
+
+        // The link may be overwritten by a concurrent owner of the block; in that case the
+        // tag in the list head will have changed and the exchange below fails and retries.
+        newHead = ((head + 0x10000) & 0xFFFF0000) | Link(index);
+    } while (!__atomic_compare_exchange_n(&mHead, &head, newHead, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    inUse = __atomic_add_fetch(&mInUse, 1, __ATOMIC_RELAXED);
+    peak  = __atomic_load_n(&mPeakInUse, __ATOMIC_RELAXED);
+    while (inUse > peak && !__atomic_compare_exchange_n(&mPeakInUse, &peak, inUse, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+
+    return mStorage + static_cast<uint32_t>(index) * mBlockSize;
+}
+
+void BlockPool::Free(void * aBlock)
+{
+    uint16_t index = static_cast<uint16_t>((static_cast<uint8_t *>(aBlock) - mStorage) / mBlockSize);
+    uint32_t head  = __atomic_load_n(&mHead, __ATOMIC_ACQUIRE);
+    uint32_t newHead;
+
+    // Count the block as released before it becomes visible to other allocators, so that the
+    // usage counters never exceed the pool size.
+    __atomic_sub_fetch(&mInUse, 1, __ATOMIC_RELAXED);
+
+    do
+    {
+        Link(index) = static_cast<uint16_t>(head);
+        newHead     = ((head + 0x10000) & 0xFFFF0000) | index;
+    } while (!__atomic_compare_exchange_n(&mHead, &head, newHead, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+}
+
+volatile uint16_t & BlockPool::Link(uint16_t aIndex) const
+{
+    // The index of the next free block is stored in the first bytes of each free block.
+    return *reinterpret_cast<volatile uint16_t *>(mStorage + static_cast<uint32_t>(aIndex) * mBlockSize);
+}
+
+void PoolAllocator::Init(void)
+{
+    mPools[0].Init(sSmallPoolStorage, POOL_ALLOCATOR_SMALL_BLOCK_SIZE, POOL_ALLOCATOR_SMALL_BLOCK_COUNT);
+    mPools[1].Init(sMediumPoolStorage, POOL_ALLOCATOR_MEDIUM_BLOCK_SIZE, POOL_ALLOCATOR_MEDIUM_BLOCK_COUNT);
+    mPools[2].Init(sLargePoolStorage, POOL_ALLOCATOR_LARGE_BLOCK_SIZE, POOL_ALLOCATOR_LARGE_BLOCK_COUNT);
+    mHeapFallbackCount = 0;
+}
+
+void * PoolAllocator::Calloc(size_t aCount, size_t aSize)
+{
+    void * ptr = NULL;
+    size_t size;
+
+    if (aSize != 0 && aCount > SIZE_MAX / aSize)
+    {
+        return NULL;
+    }
+
+    size = aCount * aSize;
+
+    // Use the smallest class that fits; if it is exhausted, try the next larger one
+    // before falling back to the heap.
+    for (uint8_t i = 0; i < kPoolCount && ptr == NULL; i++)
+    {
+        if (size <= sPoolAllocator.mPools[i].GetBlockSize())
+        {
+            ptr = sPoolAllocator.mPools[i].Alloc();
+        }
+    }
+
+    if (ptr != NULL)
+    {
+        memset(ptr, 0, size);
+    }
+    else
+    {
+        __atomic_fetch_add(&sPoolAllocator.mHeapFallbackCount, 1, __ATOMIC_RELAXED);
+        ptr = calloc(aCount, aSize);
+    }
+
+    return ptr;
+}
+
+void PoolAllocator::Free(void * aPtr)
+{
+    for (uint8_t i = 0; i < kPoolCount; i++)
+    {
+        if (sPoolAllocator.mPools[i].Contains(aPtr))
+        {
+            sPoolAllocator.mPools[i].Free(aPtr);
+            return;
+        }
+    }
+
+    free(aPtr);
+}
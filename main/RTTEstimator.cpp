@@ -0,0 +1,72 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "RTTEstimator.h"
+
+void RTTEstimator::Init(uint32_t aInitialTimeoutMS, uint32_t aMinTimeoutMS, uint32_t aMaxTimeoutMS)
+{
+    mScaledSRTT   = 0;
+    mScaledRTTVar = 0;
+    mTimeoutMS    = aInitialTimeoutMS;
+    mMinTimeoutMS = aMinTimeoutMS;
+    mMaxTimeoutMS = aMaxTimeoutMS;
+    mSampleCount  = 0;
+}
+
+void RTTEstimator::AddSample(uint32_t aRTTMS)
+{
+    uint32_t timeout;
+
+    if (mSampleCount == 0)
+    {
+        mScaledSRTT   = aRTTMS << 3;
+        mScaledRTTVar = aRTTMS << 1; // RTTVAR = R/2, scaled by 4.
+    }
+    else
+    {
+        // Deviation of the sample from the current SRTT; the scaled updates below are the
+        // fixed point forms of the RFC 6298 equations.
+        int32_t delta = static_cast<int32_t>(aRTTMS) - static_cast<int32_t>(mScaledSRTT >> 3);
+
+        mScaledSRTT = static_cast<uint32_t>(static_cast<int32_t>(mScaledSRTT) + delta);
+
+        if (delta < 0)
+        {
+            delta = -delta;
+        }
+        mScaledRTTVar = static_cast<uint32_t>(static_cast<int32_t>(mScaledRTTVar) + delta - static_cast<int32_t>(mScaledRTTVar >> 2));
+    }
+
+    if (mSampleCount < UINT32_MAX)
+    {
+        mSampleCount++;
+    }
+
+    timeout = (mScaledSRTT >> 3) + mScaledRTTVar; // SRTT + 4 * RTTVAR
+
+    if (timeout < mMinTimeoutMS)
+    {
+        timeout = mMinTimeoutMS;
+    }
+    else if (timeout > mMaxTimeoutMS)
+    {
+        timeout = mMaxTimeoutMS;
+    }
+
+    mTimeoutMS = timeout;
+}
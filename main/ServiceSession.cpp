@@ -0,0 +1,148 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "ServiceSession.h"
+#include "WDMFeature.h"
+#include "app_config.h"
+
+#include "nrf_log.h"
+
+#include <string.h>
+
+#include <Weave/DeviceLayer/WeaveDeviceLayer.h>
+
+using namespace ::nl;
+using namespace ::nl::Weave;
+using namespace ::nl::Weave::DeviceLayer;
+
+ServiceSession ServiceSession::sServiceSession;
+
+WEAVE_ERROR ServiceSession::Init(void)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    mConnectivityMS = 0;
+    memset(&mStats, 0, sizeof(mStats));
+
+    mBinding = ExchangeMgr.NewBinding(HandleBindingEvent, this);
+    VerifyOrExit(NULL != mBinding, err = WEAVE_ERROR_NO_MEMORY);
+
+    PlatformMgr().AddEventHandler(PlatformEventHandler);
+
+exit:
+    return err;
+}
+
+void ServiceSession::Prepare(void)
+{
+#if SERVICE_SESSION_PREESTABLISH
+    WEAVE_ERROR err;
+
+    // Nothing to do if the session is ready, or already being established.
+    if (!mBinding->CanBePrepared())
+    {
+        return;
+    }
+
+    NRF_LOG_INFO("Establishing shared service session");
+
+    err = mBinding->RequestPrepare();
+    if (err != WEAVE_NO_ERROR)
+    {
+        NRF_LOG_INFO("Binding::RequestPrepare() failed: %s", NRF_LOG_PUSH(ErrorStr(err)));
+        mStats.Failed++;
+    }
+#endif // SERVICE_SESSION_PREESTABLISH
+}
+
+void ServiceSession::PlatformEventHandler(const WeaveDeviceEvent * event, intptr_t arg)
+{
+    bool haveServiceConnectivity = (ConnectivityMgr().HaveServiceConnectivity() && ConfigurationMgr().IsPairedToAccount());
+
+    if (!haveServiceConnectivity)
+    {
+        sServiceSession.mConnectivityMS = 0;
+        return;
+    }
+
+    // Time the reconnect from the first event that reports service connectivity.
+    if (sServiceSession.mConnectivityMS == 0 && !sServiceSession.IsReady())
+    {
+        sServiceSession.mConnectivityMS = System::Platform::Layer::GetClock_MonotonicMS();
+    }
+
+    sServiceSession.Prepare();
+}
+
+void ServiceSession::HandleBindingEvent(void * appState, Binding::EventType eventType, const Binding::InEventParam & inParam,
+                                        Binding::OutEventParam & outParam)
+{
+    Binding * binding = inParam.Source;
+
+    switch (eventType)
+    {
+        case Binding::kEvent_PrepareRequested:
+            outParam.PrepareRequested.PrepareError = binding->BeginConfiguration()
+                                                         .Target_ServiceEndpoint(kServiceEndpoint_Data_Management)
+                                                         .Transport_UDP_WRM()
+                                                         .Transport_DefaultWRMPConfig(WdmFeature().GetServiceWRMPConfig())
+                                                         .Exchange_ResponseTimeoutMsec(WdmFeature().GetServiceResponseTimeout())
+                                                         .Security_SharedCASESession()
+                                                         .PrepareBinding();
+            break;
+
+        case Binding::kEvent_PrepareFailed:
+            NRF_LOG_INFO("Failed to establish shared service session: %s", NRF_LOG_PUSH(ErrorStr(inParam.PrepareFailed.Reason)));
+            sServiceSession.mStats.Failed++;
+
+            // Allow the session to be re-established when connectivity next changes.
+            binding->Reset();
+            break;
+
+        case Binding::kEvent_BindingFailed:
+            NRF_LOG_INFO("Shared service session lost: %s", NRF_LOG_PUSH(ErrorStr(inParam.BindingFailed.Reason)));
+            sServiceSession.mStats.Failed++;
+            binding->Reset();
+            break;
+
+        case Binding::kEvent_BindingReady:
+            sServiceSession.mStats.Established++;
+            if (sServiceSession.mConnectivityMS != 0)
+            {
+                uint32_t setupMS =
+                    static_cast<uint32_t>(System::Platform::Layer::GetClock_MonotonicMS() - sServiceSession.mConnectivityMS);
+
+                sServiceSession.mStats.LastSetupMS = setupMS;
+                if (setupMS > sServiceSession.mStats.MaxSetupMS)
+                {
+                    sServiceSession.mStats.MaxSetupMS = setupMS;
+                }
+                sServiceSession.mConnectivityMS = 0;
+
+                NRF_LOG_INFO("Shared service session ready (%" PRIu32 " ms after connectivity)", setupMS);
+            }
+            else
+            {
+                NRF_LOG_INFO("Shared service session ready");
+            }
+            break;
+
+        default:
+            Binding::DefaultEventHandler(appState, eventType, inParam, outParam);
+    }
+}
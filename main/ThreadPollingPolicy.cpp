@@ -0,0 +1,317 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "ThreadPollingPolicy.h"
+#include "AppTask.h"
+#include "WDMFeature.h"
+
+#include "app_timer.h"
+#include "nrf_log.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <string.h>
+
+#include <Weave/DeviceLayer/WeaveDeviceLayer.h>
+
+using namespace ::nl::Weave;
+using namespace ::nl::Weave::DeviceLayer;
+
+#define THREAD_POLLING_WINDOW_MS ((24ULL * 60 * 60 * 1000) / THREAD_POLLING_WINDOW_COUNT)
+
+APP_TIMER_DEF(sPollingPolicyTimer);
+
+const ThreadPollingPolicy::ActivityConfig ThreadPollingPolicy::sActivityConfig[kActivity_Count] = {
+    // kActivity_LockCommand
+    { THREAD_ACTIVE_POLLING_INTERVAL_MS, THREAD_POLLING_ACTIVITY_LINGER_MS, THREAD_POLLING_ACTIVITY_MAX_DURATION_MS },
+    // kActivity_SubscriptionSetup
+    { THREAD_ACTIVE_POLLING_INTERVAL_MS, THREAD_POLLING_ACTIVITY_LINGER_MS, THREAD_POLLING_ACTIVITY_MAX_DURATION_MS },
+    // kActivity_SoftwareUpdate: each BDX block is a request/response exchange, so the download rate is
+    // bounded by one block per polling interval.  The download always signals its end.
+    { SWU_DOWNLOAD_POLLING_INTERVAL_MS, 0, 0 },
+};
+
+ThreadPollingPolicy ThreadPollingPolicy::sThreadPollingPolicy;
+
+ret_code_t ThreadPollingPolicy::Init(void)
+{
+    ret_code_t ret;
+
+    memset(mDeadlineMS, 0, sizeof(mDeadlineMS));
+    memset(mWindowScore, 0, sizeof(mWindowScore));
+    mIdleSinceMS               = System::Platform::Layer::GetClock_MonotonicMS();
+    mActivePollingIntervalMS   = 0;
+    mInactivePollingIntervalMS = 0;
+    mActivityMask              = 0;
+    mCurrentWindow             = GetWindow(mIdleSinceMS);
+    mUpdatePending             = false;
+
+    ret = app_timer_create(&sPollingPolicyTimer, APP_TIMER_MODE_SINGLE_SHOT, TimerEventHandler);
+    if (ret != NRF_SUCCESS)
+    {
+        NRF_LOG_INFO("app_timer_create() failed");
+        APP_ERROR_HANDLER(ret);
+    }
+
+    // Update() arms the timer for the next point at which the policy may change.
+    Update();
+
+    return ret;
+}
+
+void ThreadPollingPolicy::BeginActivity(Activity aActivity)
+{
+    uint64_t now         = System::Platform::Layer::GetClock_MonotonicMS();
+    uint32_t maxDuration = sActivityConfig[aActivity].MaxDurationMS;
+
+    taskENTER_CRITICAL();
+    mActivityMask |= (1 << aActivity);
+    mDeadlineMS[aActivity] = (maxDuration != 0) ? now + maxDuration : 0;
+    taskEXIT_CRITICAL();
+
+    RequestUpdate();
+}
+
+void ThreadPollingPolicy::EndActivity(Activity aActivity)
+{
+    uint64_t now = System::Platform::Layer::GetClock_MonotonicMS();
+
+    // Keep polling fast for a little while after the activity ends, to pick up any follow-up messages.
+    taskENTER_CRITICAL();
+    if (mActivityMask & (1 << aActivity))
+    {
+        mDeadlineMS[aActivity] = now + sActivityConfig[aActivity].LingerMS;
+    }
+    taskEXIT_CRITICAL();
+
+    RequestUpdate();
+}
+
+void ThreadPollingPolicy::RecordUserActivity(void)
+{
+    uint8_t window = GetWindow(System::Platform::Layer::GetClock_MonotonicMS());
+
+    taskENTER_CRITICAL();
+    mWindowScore[window] = (mWindowScore[window] > UINT8_MAX - THREAD_POLLING_WINDOW_SCORE_INCREMENT)
+        ? UINT8_MAX
+        : mWindowScore[window] + THREAD_POLLING_WINDOW_SCORE_INCREMENT;
+    taskEXIT_CRITICAL();
+}
+
+void ThreadPollingPolicy::RequestUpdate(void)
+{
+    AppEvent event;
+
+    if (mUpdatePending)
+    {
+        return;
+    }
+    mUpdatePending = true;
+
+    // Apply the policy in the context of the application task.
+    event.Type               = AppEvent::kEventType_Timer;
+    event.TimerEvent.Context = NULL;
+    event.Handler            = UpdateEventHandler;
+    GetAppTask().PostEvent(&event);
+}
+
+void ThreadPollingPolicy::Update(void)
+{
+    WEAVE_ERROR err;
+    ConnectivityManager::ThreadPollingConfig pollingConfig;
+    uint64_t now = System::Platform::Layer::GetClock_MonotonicMS();
+    uint64_t idleSince;
+    uint32_t activeIntervalMS;
+    uint32_t inactiveIntervalMS;
+    uint8_t activityMask;
+
+    mUpdatePending = false;
+
+    // Lapse activities whose deadline has passed.
+    taskENTER_CRITICAL();
+    activityMask = mActivityMask;
+    for (uint8_t i = 0; i < kActivity_Count; i++)
+    {
+        if ((mActivityMask & (1 << i)) && mDeadlineMS[i] != 0 && now >= mDeadlineMS[i])
+        {
+            mActivityMask &= ~(1 << i);
+        }
+    }
+    if (activityMask != 0 && mActivityMask == 0)
+    {
+        mIdleSinceMS = now;
+    }
+    activityMask = mActivityMask;
+    idleSince    = mIdleSinceMS;
+    taskEXIT_CRITICAL();
+
+    UpdateWindow(now);
+
+    if (activityMask != 0)
+    {
+        // Poll at the fastest rate required by any activity in flight.
+        activeIntervalMS = UINT32_MAX;
+        for (uint8_t i = 0; i < kActivity_Count; i++)
+        {
+            if ((activityMask & (1 << i)) && sActivityConfig[i].PollingIntervalMS < activeIntervalMS)
+            {
+                activeIntervalMS = sActivityConfig[i].PollingIntervalMS;
+            }
+        }
+        inactiveIntervalMS = activeIntervalMS;
+    }
+    else
+    {
+        activeIntervalMS   = THREAD_ACTIVE_POLLING_INTERVAL_MS;
+        inactiveIntervalMS = THREAD_INACTIVE_POLLING_INTERVAL_MS;
+
+        // Back off exponentially while idle, except during a learned activity window.
+        if (!IsInActivityWindow())
+        {
+            uint64_t steps = (now - idleSince) / THREAD_POLLING_BACKOFF_STEP_MS;
+
+            while (steps > 0 && inactiveIntervalMS < THREAD_POLLING_MAX_INACTIVE_INTERVAL_MS)
+            {
+                inactiveIntervalMS *= 2;
+                steps--;
+            }
+            if (inactiveIntervalMS > THREAD_POLLING_MAX_INACTIVE_INTERVAL_MS)
+            {
+                inactiveIntervalMS = THREAD_POLLING_MAX_INACTIVE_INTERVAL_MS;
+            }
+        }
+    }
+
+    ScheduleUpdate(now, activityMask, idleSince, inactiveIntervalMS);
+
+    if (activeIntervalMS == mActivePollingIntervalMS && inactiveIntervalMS == mInactivePollingIntervalMS)
+    {
+        return;
+    }
+
+    pollingConfig.Clear();
+    pollingConfig.ActivePollingIntervalMS   = activeIntervalMS;
+    pollingConfig.InactivePollingIntervalMS = inactiveIntervalMS;
+
+    PlatformMgr().LockWeaveStack();
+    err = ConnectivityMgr().SetThreadPollingConfig(pollingConfig);
+    if (err == WEAVE_NO_ERROR)
+    {
+        mActivePollingIntervalMS   = activeIntervalMS;
+        mInactivePollingIntervalMS = inactiveIntervalMS;
+
+        // The service piggyback ack timeout follows the inactive polling interval.
+        WdmFeature().UpdatePiggybackAckTimeout();
+    }
+    PlatformMgr().UnlockWeaveStack();
+
+    if (err != WEAVE_NO_ERROR)
+    {
+        NRF_LOG_INFO("ConnectivityMgr().SetThreadPollingConfig() failed: %s", NRF_LOG_PUSH(ErrorStr(err)));
+        return;
+    }
+
+    NRF_LOG_INFO("Thread polling interval: active %" PRIu32 " ms, inactive %" PRIu32 " ms (activities 0x%02x)", activeIntervalMS,
+                 inactiveIntervalMS, activityMask);
+}
+
+void ThreadPollingPolicy::ScheduleUpdate(uint64_t aNowMS, uint8_t aActivityMask, uint64_t aIdleSinceMS, uint32_t aInactiveIntervalMS)
+{
+    ret_code_t ret;
+    uint64_t nextUpdateMS;
+
+    // The policy next changes at the start of the next window, ...
+    nextUpdateMS = (aNowMS / THREAD_POLLING_WINDOW_MS + 1) * THREAD_POLLING_WINDOW_MS;
+
+    if (aActivityMask != 0)
+    {
+        // ... when an activity in flight lapses, ...
+        for (uint8_t i = 0; i < kActivity_Count; i++)
+        {
+            if ((aActivityMask & (1 << i)) && mDeadlineMS[i] != 0 && mDeadlineMS[i] < nextUpdateMS)
+            {
+                nextUpdateMS = mDeadlineMS[i];
+            }
+        }
+    }
+    else if (aInactiveIntervalMS < THREAD_POLLING_MAX_INACTIVE_INTERVAL_MS && !IsInActivityWindow())
+    {
+        // ... or, while backing off, at the next backoff step.
+        uint64_t nextStepMS = aIdleSinceMS + ((aNowMS - aIdleSinceMS) / THREAD_POLLING_BACKOFF_STEP_MS + 1) * THREAD_POLLING_BACKOFF_STEP_MS;
+
+        if (nextStepMS < nextUpdateMS)
+        {
+            nextUpdateMS = nextStepMS;
+        }
+    }
+
+    // BeginActivity() and EndActivity() request updates of their own.
+    ret = app_timer_stop(sPollingPolicyTimer);
+    if (ret == NRF_SUCCESS)
+    {
+        uint32_t delayMS = (nextUpdateMS > aNowMS) ? static_cast<uint32_t>(nextUpdateMS - aNowMS) : 1;
+
+        ret = app_timer_start(sPollingPolicyTimer, pdMS_TO_TICKS(delayMS), NULL);
+    }
+    if (ret != NRF_SUCCESS)
+    {
+        NRF_LOG_INFO("app_timer_start() failed");
+        APP_ERROR_HANDLER(ret);
+    }
+}
+
+void ThreadPollingPolicy::UpdateWindow(uint64_t aNowMS)
+{
+    uint8_t window = GetWindow(aNowMS);
+
+    // Decay the score of each window once a day, as it is entered.
+    taskENTER_CRITICAL();
+    if (window != mCurrentWindow)
+    {
+        mCurrentWindow = window;
+        mWindowScore[window] -= mWindowScore[window] / THREAD_POLLING_WINDOW_DECAY_DIVISOR;
+    }
+    taskEXIT_CRITICAL();
+}
+
+bool ThreadPollingPolicy::IsInActivityWindow(void) const
+{
+    // Also consider the upcoming window, so that polling is already fast when the user arrives.
+    uint8_t next = (mCurrentWindow + 1) % THREAD_POLLING_WINDOW_COUNT;
+
+    return (mWindowScore[mCurrentWindow] >= THREAD_POLLING_WINDOW_SCORE_THRESHOLD ||
+            mWindowScore[next] >= THREAD_POLLING_WINDOW_SCORE_THRESHOLD);
+}
+
+uint8_t ThreadPollingPolicy::GetWindow(uint64_t aNowMS)
+{
+    return static_cast<uint8_t>((aNowMS / THREAD_POLLING_WINDOW_MS) % THREAD_POLLING_WINDOW_COUNT);
+}
+
+void ThreadPollingPolicy::TimerEventHandler(void * p_context)
+{
+    // Post unconditionally, so that a previously failed post does not stall the policy.
+    sThreadPollingPolicy.mUpdatePending = false;
+    sThreadPollingPolicy.RequestUpdate();
+}
+
+void ThreadPollingPolicy::UpdateEventHandler(AppEvent * aEvent)
+{
+    sThreadPollingPolicy.Update();
+}
@@ -17,11 +17,15 @@
  */
 
 #include "WDMFeature.h"
+#include "ThreadPollingPolicy.h"
+#include "FormatUtils.h"
+#include "LivenessPolicy.h"
 
 #include "nrf_log.h"
 #include "nrf_error.h"
 
 #include <Weave/DeviceLayer/WeaveDeviceLayer.h>
+#include <Weave/Profiles/echo/WeaveEcho.h>
 
 using namespace ::nl;
 using namespace ::nl::Inet;
@@ -30,43 +34,38 @@ using namespace ::nl::Weave::DeviceLayer;
 using namespace ::nl::Weave::DeviceLayer::Internal;
 using namespace ::nl::Weave::Profiles::DataManagement_Current;
 
-// TODO: Remove this
-#define kServiceEndpoint_Data_Management 0x18B4300200000003ull ///< Core Weave data management protocol endpoint
-
-/** Defines the timeout for liveness between the service and the device.
- *  For sleepy end node devices, this timeout will be much larger than the current
- *  value to preserve battery.
- */
-#define SERVICE_LIVENESS_TIMEOUT_SEC 60 * 1 // 1 minute
-
 /** Defines the timeout for a response to any message initiated by the device to the service.
  *  This includes notifies, subscribe confirms, cancels and updates.
  *  This timeout is kept SERVICE_WRM_MAX_RETRANS x SERVICE_WRM_INITIAL_RETRANS_TIMEOUT_MS + some buffer
- *  to account for latency in the message transmission through multiple hops.
+ *  to account for latency in the message transmission through multiple hops.  It is the
+ *  minimum; the timeout is extended when the derived retransmission timeout grows.
  */
 #define SERVICE_MESSAGE_RESPONSE_TIMEOUT_MS 10000
 
 /** Defines the timeout for a message to get retransmitted when no wrm ack or
- *  response has been heard back from the service. This timeout is kept larger
- *  for now since the message has to travel through multiple hops and service
- *  layers before actually making it to the actual receiver.
+ *  response has been heard back from the service, until the service round trip time
+ *  has been measured. This timeout is kept larger since the message has to travel
+ *  through multiple hops and service layers before actually making it to the actual
+ *  receiver.
  *  @note
  *    WRM has an initial and active retransmission timeouts to interact with
- *    sleepy destination nodes. For the time being, the pinna WRM config would
- *    set both these timeouts to be the same based on the assumption that the pinna
- *    would not be interacting directly with a sleepy peer.
+ *    sleepy destination nodes. The service is not a sleepy peer, so both timeouts
+ *    are set to the same (measured) value.
  */
 #define SERVICE_WRM_INITIAL_RETRANS_TIMEOUT_MS 2500
 
-#define SERVICE_WRM_ACTIVE_RETRANS_TIMEOUT_MS 2500
-
 /** Define the maximum number of retransmissions in WRM
  */
 #define SERVICE_WRM_MAX_RETRANS 3
 
-/** Define the timeout for piggybacking a WRM acknowledgment message
+/** Defines the upper bound on the time a WRM acknowledgment is held back waiting for a
+ *  message to piggyback on.  The device is a sleepy end device, and the service paces its
+ *  traffic to the device by the sleepy (inactive) Thread polling interval, so the hold-off
+ *  tracks that interval: the ack waits for a response for as long as the service expects the
+ *  device to take to hear from it anyway.  The bound is also kept below half the service
+ *  retransmission timeout, so a held ack never provokes a retransmission from the service.
  */
-#define SERVICE_WRM_PIGGYBACK_ACK_TIMEOUT_MS 200
+#define SERVICE_WRM_MAX_PIGGYBACK_ACK_TIMEOUT_MS 1000
 
 /** Defines the timeout for expecting a subscribe response after sending a subscribe request.
  *  This is meant to be a gross timeout - the MESSAGE_RESPONSE_TIMEOUT_MS will usually trip first
@@ -75,8 +74,33 @@ using namespace ::nl::Weave::Profiles::DataManagement_Current;
  */
 #define SUBSCRIPTION_RESPONSE_TIMEOUT_MS 40000
 
-const nl::Weave::WRMPConfig gWRMPConfigService = { SERVICE_WRM_INITIAL_RETRANS_TIMEOUT_MS, SERVICE_WRM_ACTIVE_RETRANS_TIMEOUT_MS,
-                                                   SERVICE_WRM_PIGGYBACK_ACK_TIMEOUT_MS, SERVICE_WRM_MAX_RETRANS };
+/** Bounds for the retransmission timeout derived from measured service round trip times
+ *  (see RTTEstimator.h).  SERVICE_WRM_INITIAL_RETRANS_TIMEOUT_MS is used until the first
+ *  round trip has been measured.
+ */
+#define SERVICE_WRM_MIN_RETRANS_TIMEOUT_MS 1000
+
+#define SERVICE_WRM_MAX_RETRANS_TIMEOUT_MS 8000
+
+/** Minimum change in the derived retransmission timeout that is applied to the service
+ *  bindings, so that every sample does not rewrite the binding configuration.
+ */
+#define SERVICE_WRM_RETRANS_TIMEOUT_HYSTERESIS_MS 100
+
+/** Minimum time between round trip probes to the service.  A probe is a WRM-reliable echo
+ *  request on the service subscription binding, timed until its WRM ack arrives.  The ack is
+ *  sent by the receiver's exchange layer for any reliable message, before (and whether or not)
+ *  the message is dispatched to a profile handler, so the sample measures the network round
+ *  trip to the data management endpoint and does not depend on the endpoint implementing Echo.
+ *  Probes are only sent alongside other service traffic, while the device is polling quickly
+ *  anyway.
+ */
+#define SERVICE_RTT_PROBE_MIN_INTERVAL_MS (10 * 60 * 1000)
+
+/** Number of consecutive probes that the service may leave unacknowledged before probing
+ *  stops, and the configured retransmission timeout is kept, until the next reboot.
+ */
+#define SERVICE_RTT_PROBE_MAX_FAILURES 3
 
 WDMFeature WDMFeature::sWDMfeature;
 
@@ -87,7 +111,11 @@ SubscriptionEngine * SubscriptionEngine::GetInstance()
 
 int PublisherLock::Init()
 {
+#if configSUPPORT_STATIC_ALLOCATION
+    mRecursiveLock = xSemaphoreCreateRecursiveMutexStatic(&mRecursiveLockStruct);
+#else
     mRecursiveLock = xSemaphoreCreateRecursiveMutex();
+#endif
     return ((mRecursiveLock == NULL) ? NRF_ERROR_NULL : NRF_SUCCESS);
 }
 
@@ -116,9 +144,18 @@ WDMFeature::WDMFeature(void)
                                sizeof(mServiceSinkCatalogStore) / sizeof(mServiceSinkCatalogStore[0]))
     , mServiceSourceTraitCatalog(ResourceIdentifier(ResourceIdentifier::SELF_NODE_ID), mServiceSourceCatalogStore,
                                sizeof(mServiceSourceCatalogStore) / sizeof(mServiceSourceCatalogStore[0]))
+    , mSourceTraitCount(0)
+    , mSinkTraitCount(0)
     , mServiceSubClient(NULL)
     , mServiceCounterSubHandler(NULL)
     , mServiceSubBinding(NULL)
+    , mPublishStats()
+    , mAckStats()
+    , mRTTProbeSentMS(0)
+    , mRTTProbeRetransTimeoutMS(0)
+    , mRTTProbeEC(NULL)
+    , mRTTProbeFailures(0)
+    , mFirstDeferredChangeMS(0)
     , mIsSubToServiceEstablished(false)
     , mIsServiceCounterSubEstablished(false)
     , mIsSubToServiceActivated(false)
@@ -127,7 +164,113 @@ WDMFeature::WDMFeature(void)
 
 void WDMFeature::AsyncProcessChanges(intptr_t arg)
 {
+    if (sWDMfeature.mIsServiceCounterSubEstablished)
+    {
+        sWDMfeature.mPublishStats.Immediate++;
+    }
+    else
+    {
+        // Changes can only reach the service through its counter-subscription.  Until that
+        // is re-established the change stays dirty in the trait and is delivered with the
+        // subscription's initial notify.  The service only counter-subscribes after our own
+        // subscription to it succeeds, so if that is waiting out a resubscribe backoff, cut
+        // the backoff short.
+        sWDMfeature.mPublishStats.Deferred++;
+
+        if (sWDMfeature.mFirstDeferredChangeMS == 0)
+        {
+            sWDMfeature.mFirstDeferredChangeMS = System::Platform::Layer::GetClock_MonotonicMS();
+        }
+
+        if (sWDMfeature.mIsSubToServiceActivated && !sWDMfeature.mServiceSubClient->IsInProgressOrEstablished())
+        {
+            sWDMfeature.mServiceSubClient->ResetResubscribe();
+            sWDMfeature.mPublishStats.ResubscribeKicks++;
+        }
+    }
+
     sWDMfeature.mSubscriptionEngine.GetNotificationEngine()->Run();
+
+    sWDMfeature.ProbeServiceRTT();
+}
+
+void WDMFeature::ProbeServiceRTT(void)
+{
+    WEAVE_ERROR err       = WEAVE_NO_ERROR;
+    PacketBuffer * msgBuf = NULL;
+    ExchangeContext * ec  = NULL;
+    uint64_t now          = System::Platform::Layer::GetClock_MonotonicMS();
+
+    VerifyOrExit(mRTTProbeEC == NULL && mIsSubToServiceEstablished && mServiceSubBinding->IsReady(), err = WEAVE_NO_ERROR);
+    VerifyOrExit(mRTTProbeFailures < SERVICE_RTT_PROBE_MAX_FAILURES, err = WEAVE_NO_ERROR);
+    VerifyOrExit(mRTTProbeSentMS == 0 || now - mRTTProbeSentMS >= SERVICE_RTT_PROBE_MIN_INTERVAL_MS, err = WEAVE_NO_ERROR);
+
+    msgBuf = PacketBuffer::NewWithAvailableSize(0);
+    VerifyOrExit(msgBuf != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+    err = mServiceSubBinding->NewExchangeContext(ec);
+    SuccessOrExit(err);
+
+    // Only the WRM ack is of interest; any echo response is dropped with the exchange.
+    ec->AppState    = this;
+    ec->OnAckRcvd   = HandleRTTProbeAck;
+    ec->OnSendError = HandleRTTProbeSendError;
+
+    mRTTProbeEC               = ec;
+    mRTTProbeSentMS           = now;
+    mRTTProbeRetransTimeoutMS = mAppliedRetransTimeoutMS;
+
+    err    = ec->SendMessage(nl::Weave::Profiles::kWeaveProfile_Echo, nl::Weave::Profiles::kEchoMessageType_EchoRequest, msgBuf,
+                          ExchangeContext::kSendFlag_RequestAck);
+    msgBuf = NULL;
+    SuccessOrExit(err);
+
+exit:
+    if (err != WEAVE_NO_ERROR)
+    {
+        NRF_LOG_INFO("Failed to send service RTT probe: %s", NRF_LOG_PUSH(ErrorStr(err)));
+
+        if (ec != NULL)
+        {
+            ec->Abort();
+            mRTTProbeEC = NULL;
+        }
+    }
+    if (msgBuf != NULL)
+    {
+        PacketBuffer::Free(msgBuf);
+    }
+}
+
+void WDMFeature::HandleRTTProbeAck(ExchangeContext * aEC, void * aMsgCtxt)
+{
+    uint32_t rttMS = static_cast<uint32_t>(System::Platform::Layer::GetClock_MonotonicMS() - sWDMfeature.mRTTProbeSentMS);
+
+    // An ack that arrives after the retransmission timeout may be for a retransmission, so
+    // it is not used as a sample (Karn's algorithm).
+    if (rttMS < sWDMfeature.mRTTProbeRetransTimeoutMS)
+    {
+        sWDMfeature.AddServiceRTTSample(rttMS);
+    }
+
+    sWDMfeature.mRTTProbeFailures = 0;
+
+    aEC->Close();
+    sWDMfeature.mRTTProbeEC = NULL;
+}
+
+void WDMFeature::HandleRTTProbeSendError(ExchangeContext * aEC, WEAVE_ERROR aErr, void * aMsgCtxt)
+{
+    NRF_LOG_INFO("Service RTT probe failed: %s", NRF_LOG_PUSH(ErrorStr(aErr)));
+
+    if (aErr == WEAVE_ERROR_MESSAGE_NOT_ACKNOWLEDGED && ++sWDMfeature.mRTTProbeFailures == SERVICE_RTT_PROBE_MAX_FAILURES)
+    {
+        NRF_LOG_INFO("Service does not acknowledge RTT probes; keeping retransmission timeout %" PRIu32 " ms",
+                     sWDMfeature.mAppliedRetransTimeoutMS);
+    }
+
+    aEC->Abort();
+    sWDMfeature.mRTTProbeEC = NULL;
 }
 
 void WDMFeature::ProcessTraitChanges(void)
@@ -179,6 +322,24 @@ void WDMFeature::TearDownSubscriptions(void)
     }
 }
 
+void WDMFeature::RenegotiateLiveness(void)
+{
+    PlatformMgr().ScheduleWork(AsyncRenegotiateLiveness);
+}
+
+void WDMFeature::AsyncRenegotiateLiveness(intptr_t arg)
+{
+    // The liveness timeout is fixed when a subscription is established, so re-establish the
+    // service subscriptions (the service follows with a new counter-subscription).
+    if (sWDMfeature.mIsSubToServiceActivated && sWDMfeature.mServiceSubClient->IsInProgressOrEstablished())
+    {
+        NRF_LOG_INFO("Renegotiating service subscription liveness (%" PRIu32 " s)", GetLivenessPolicy().GetLivenessTimeout());
+
+        sWDMfeature.TearDownSubscriptions();
+        sWDMfeature.InitiateSubscriptionToService();
+    }
+}
+
 void WDMFeature::HandleServiceBindingEvent(void * appState, ::nl::Weave::Binding::EventType eventType,
                                            const ::nl::Weave::Binding::InEventParam & inParam,
                                            ::nl::Weave::Binding::OutEventParam & outParam)
@@ -191,18 +352,18 @@ void WDMFeature::HandleServiceBindingEvent(void * appState, ::nl::Weave::Binding
             outParam.PrepareRequested.PrepareError = binding->BeginConfiguration()
                                                          .Target_ServiceEndpoint(kServiceEndpoint_Data_Management)
                                                          .Transport_UDP_WRM()
-                                                         .Transport_DefaultWRMPConfig(gWRMPConfigService)
-                                                         .Exchange_ResponseTimeoutMsec(SERVICE_MESSAGE_RESPONSE_TIMEOUT_MS)
+                                                         .Transport_DefaultWRMPConfig(sWDMfeature.GetServiceWRMPConfig())
+                                                         .Exchange_ResponseTimeoutMsec(sWDMfeature.GetServiceResponseTimeout())
                                                          .Security_SharedCASESession()
                                                          .PrepareBinding();
             break;
 
         case Binding::kEvent_PrepareFailed:
-            NRF_LOG_INFO("Failed to prepare service subscription binding: %s", ErrorStr(inParam.PrepareFailed.Reason));
+            NRF_LOG_INFO("Failed to prepare service subscription binding: %s", NRF_LOG_PUSH(ErrorStr(inParam.PrepareFailed.Reason)));
             break;
 
         case Binding::kEvent_BindingFailed:
-            NRF_LOG_INFO("Service subscription binding failed: %s", ErrorStr(inParam.BindingFailed.Reason));
+            NRF_LOG_INFO("Service subscription binding failed: %s", NRF_LOG_PUSH(ErrorStr(inParam.BindingFailed.Reason)));
             break;
 
         case Binding::kEvent_BindingReady:
@@ -227,8 +388,11 @@ void WDMFeature::HandleInboundSubscriptionEvent(void * aAppState, SubscriptionHa
             if (inParam.mSubscribeRequestParsed.mIsSubscriptionIdValid &&
                 inParam.mSubscribeRequestParsed.mMsgInfo->SourceNodeId == kServiceEndpoint_Data_Management)
             {
-                NRF_LOG_INFO("Inbound service counter-subscription request received (sub id %016" PRIX64 ", path count %" PRId16 ")",
-                             inParam.mSubscribeRequestParsed.mSubscriptionId, inParam.mSubscribeRequestParsed.mNumTraitInstances);
+                char subIdStr[kFormatHex64StrSize];
+
+                FormatHex(subIdStr, sizeof(subIdStr), inParam.mSubscribeRequestParsed.mSubscriptionId, 16);
+                NRF_LOG_INFO("Inbound service counter-subscription request received (sub id %s, path count %" PRId16 ")",
+                             NRF_LOG_PUSH(subIdStr), inParam.mSubscribeRequestParsed.mNumTraitInstances);
 
                 sWDMfeature.mServiceCounterSubHandler = inParam.mSubscribeRequestParsed.mHandler;
             }
@@ -237,8 +401,8 @@ void WDMFeature::HandleInboundSubscriptionEvent(void * aAppState, SubscriptionHa
                 break;
             }
 
-            binding->SetDefaultResponseTimeout(SERVICE_MESSAGE_RESPONSE_TIMEOUT_MS);
-            binding->SetDefaultWRMPConfig(gWRMPConfigService);
+            binding->SetDefaultResponseTimeout(sWDMfeature.GetServiceResponseTimeout());
+            binding->SetDefaultWRMPConfig(sWDMfeature.GetServiceWRMPConfig());
 
             inParam.mSubscribeRequestParsed.mHandler->AcceptSubscribeRequest(inParam.mSubscribeRequestParsed.mTimeoutSecMin);
             break;
@@ -251,6 +415,23 @@ void WDMFeature::HandleInboundSubscriptionEvent(void * aAppState, SubscriptionHa
                 NRF_LOG_INFO("Inbound service counter-subscription established");
 
                 sWDMfeature.mIsServiceCounterSubEstablished = true;
+
+                if (sWDMfeature.mFirstDeferredChangeMS != 0)
+                {
+                    uint32_t recoveryMS = static_cast<uint32_t>(System::Platform::Layer::GetClock_MonotonicMS() -
+                                                                sWDMfeature.mFirstDeferredChangeMS);
+
+                    NRF_LOG_INFO("Deferred trait changes delivered after %" PRIu32 " ms", recoveryMS);
+
+                    sWDMfeature.mPublishStats.Recovered++;
+                    if (recoveryMS > sWDMfeature.mPublishStats.MaxRecoveryMS)
+                    {
+                        sWDMfeature.mPublishStats.MaxRecoveryMS = recoveryMS;
+                    }
+                    sWDMfeature.mFirstDeferredChangeMS = 0;
+                }
+
+                GetThreadPollingPolicy().EndActivity(ThreadPollingPolicy::kActivity_SubscriptionSetup);
             }
             break;
         }
@@ -263,7 +444,7 @@ void WDMFeature::HandleInboundSubscriptionEvent(void * aAppState, SubscriptionHa
 
             if (inParam.mSubscriptionTerminated.mHandler == sWDMfeature.mServiceCounterSubHandler)
             {
-                NRF_LOG_INFO("Inbound service counter-subscription terminated: %s", termDesc);
+                NRF_LOG_INFO("Inbound service counter-subscription terminated: %s", NRF_LOG_PUSH(termDesc));
 
                 sWDMfeature.mServiceCounterSubHandler       = NULL;
                 sWDMfeature.mIsServiceCounterSubEstablished = false;
@@ -286,34 +467,48 @@ void WDMFeature::HandleOutboundServiceSubscriptionEvent(void * appState, Subscri
         case SubscriptionClient::kEvent_OnSubscribeRequestPrepareNeeded:
         {
             outParam.mSubscribeRequestPrepareNeeded.mPathList                  = &(sWDMfeature.mServiceSinkTraitPaths[0]);
-            outParam.mSubscribeRequestPrepareNeeded.mPathListSize              = kSinkHandle_Max;
+            outParam.mSubscribeRequestPrepareNeeded.mPathListSize              = sWDMfeature.mSinkTraitCount;
             outParam.mSubscribeRequestPrepareNeeded.mVersionedPathList         = NULL;
             outParam.mSubscribeRequestPrepareNeeded.mNeedAllEvents             = false;
             outParam.mSubscribeRequestPrepareNeeded.mLastObservedEventList     = NULL;
             outParam.mSubscribeRequestPrepareNeeded.mLastObservedEventListSize = 0;
-            outParam.mSubscribeRequestPrepareNeeded.mTimeoutSecMin             = SERVICE_LIVENESS_TIMEOUT_SEC;
-            outParam.mSubscribeRequestPrepareNeeded.mTimeoutSecMax             = SERVICE_LIVENESS_TIMEOUT_SEC;
+            outParam.mSubscribeRequestPrepareNeeded.mTimeoutSecMin             = GetLivenessPolicy().GetLivenessTimeout();
+            outParam.mSubscribeRequestPrepareNeeded.mTimeoutSecMax             = GetLivenessPolicy().GetLivenessTimeout();
 
             NRF_LOG_INFO("Sending outbound service subscribe request (path count 1)");
 
+            // Poll quickly until the subscription and the service's counter-subscription are established.
+            GetThreadPollingPolicy().BeginActivity(ThreadPollingPolicy::kActivity_SubscriptionSetup);
+
             break;
         }
         case SubscriptionClient::kEvent_OnSubscriptionEstablished:
-            NRF_LOG_INFO("Outbound service subscription established (sub id %016" PRIX64 ")",
-                         inParam.mSubscriptionEstablished.mSubscriptionId);
+        {
+            char subIdStr[kFormatHex64StrSize];
+
+            FormatHex(subIdStr, sizeof(subIdStr), inParam.mSubscriptionEstablished.mSubscriptionId, 16);
+            NRF_LOG_INFO("Outbound service subscription established (sub id %s)", NRF_LOG_PUSH(subIdStr));
             sWDMfeature.mIsSubToServiceEstablished = true;
+
+            // The device is polling quickly while the subscriptions are set up, so this is a cheap
+            // time to measure the round trip.
+            sWDMfeature.ProbeServiceRTT();
             break;
+        }
 
         case SubscriptionClient::kEvent_OnSubscriptionTerminated:
         {
             NRF_LOG_INFO(
                 "Outbound service subscription terminated: %s",
-                (inParam.mSubscriptionTerminated.mIsStatusCodeValid)
-                    ? StatusReportStr(inParam.mSubscriptionTerminated.mStatusProfileId, inParam.mSubscriptionTerminated.mStatusCode)
-                    : ErrorStr(inParam.mSubscriptionTerminated.mReason));
+                NRF_LOG_PUSH(
+                    (inParam.mSubscriptionTerminated.mIsStatusCodeValid)
+                        ? StatusReportStr(inParam.mSubscriptionTerminated.mStatusProfileId, inParam.mSubscriptionTerminated.mStatusCode)
+                        : ErrorStr(inParam.mSubscriptionTerminated.mReason)));
 
             sWDMfeature.mIsSubToServiceEstablished = false;
 
+            GetThreadPollingPolicy().EndActivity(ThreadPollingPolicy::kActivity_SubscriptionSetup);
+
             if (inParam.mSubscriptionTerminated.mClient == sWDMfeature.mServiceSubClient)
             {
                 // This would happen when the service explicitly terminates the subscription
@@ -359,21 +554,29 @@ WEAVE_ERROR WDMFeature::Init()
     int ret;
     Binding * binding;
 
+    mServiceRTT.Init(SERVICE_WRM_INITIAL_RETRANS_TIMEOUT_MS, SERVICE_WRM_MIN_RETRANS_TIMEOUT_MS, SERVICE_WRM_MAX_RETRANS_TIMEOUT_MS);
+    mAppliedRetransTimeoutMS      = mServiceRTT.GetRetransTimeout();
+    mAppliedPiggybackAckTimeoutMS = GetPiggybackAckTimeout();
+
     ret = mPublisherLock.Init();
     VerifyOrExit(ret != NRF_ERROR_NULL, err = WEAVE_ERROR_NO_MEMORY);
 
     PlatformMgr().AddEventHandler(PlatformEventHandler);
 
-    mServiceSourceTraitCatalog.AddAt(0, &mBoltLockTraitSource, kSourceHandle_BoltLockTrait);
-    mServiceSourceTraitCatalog.AddAt(0, &mDeviceIdentityTraitSource, kSourceHandle_DeviceIdentityTrait);
-
-    mServiceSinkTraitCatalog.AddAt(0, &mBoltLockSettingsTraitSink, kSinkHandle_BoltLockSettingsTrait);
-
-    for (uint8_t handle = 0; handle < kSinkHandle_Max; handle++)
+    // Published traits.  Each actuator is published as its own BoltLockTrait instance, with the
+    // actuator index as instance id.
+    for (uint8_t i = 0; i < BOLT_LOCK_ACTUATOR_COUNT; i++)
     {
-        mServiceSinkTraitPaths[handle].mTraitDataHandle    = handle;
-        mServiceSinkTraitPaths[handle].mPropertyPathHandle = kRootPropertyPathHandle;
+        mBoltLockTraitSources[i].SetActuator(i);
+        err = RegisterSourceTrait(&mBoltLockTraitSources[i], i);
+        SuccessOrExit(err);
     }
+    err = RegisterSourceTrait(&mDeviceIdentityTraitSource, 0);
+    SuccessOrExit(err);
+
+    // Subscribed traits.
+    err = RegisterSinkTrait(&mBoltLockSettingsTraitSink, 0);
+    SuccessOrExit(err);
 
     err = mSubscriptionEngine.Init(&ExchangeMgr, this, HandleSubscriptionEngineEvent);
     SuccessOrExit(err);
@@ -395,3 +598,146 @@ WEAVE_ERROR WDMFeature::Init()
 exit:
     return err;
 }
+
+nl::Weave::WRMPConfig WDMFeature::GetServiceWRMPConfig(void) const
+{
+    nl::Weave::WRMPConfig config = { mAppliedRetransTimeoutMS, mAppliedRetransTimeoutMS, mAppliedPiggybackAckTimeoutMS,
+                                     SERVICE_WRM_MAX_RETRANS };
+
+    return config;
+}
+
+uint32_t WDMFeature::GetServiceResponseTimeout(void) const
+{
+    // Leave room for every retransmission of the request before giving up on the response.
+    uint32_t timeout = (SERVICE_WRM_MAX_RETRANS + 1) * mAppliedRetransTimeoutMS;
+
+    return (timeout > SERVICE_MESSAGE_RESPONSE_TIMEOUT_MS) ? timeout : SERVICE_MESSAGE_RESPONSE_TIMEOUT_MS;
+}
+
+uint32_t WDMFeature::GetPiggybackAckTimeout(void) const
+{
+    uint32_t timeout = GetThreadPollingPolicy().GetInactivePollingInterval();
+    uint32_t limit   = mAppliedRetransTimeoutMS / 2;
+
+    // Until the polling policy has run, the boot-time polling configuration applies.
+    if (timeout == 0)
+    {
+        timeout = THREAD_INACTIVE_POLLING_INTERVAL_MS;
+    }
+    if (limit > SERVICE_WRM_MAX_PIGGYBACK_ACK_TIMEOUT_MS)
+    {
+        limit = SERVICE_WRM_MAX_PIGGYBACK_ACK_TIMEOUT_MS;
+    }
+    if (timeout > limit)
+    {
+        timeout = limit;
+    }
+
+    return timeout;
+}
+
+void WDMFeature::AddServiceRTTSample(uint32_t aRTTMS)
+{
+    uint32_t timeout;
+    uint32_t change;
+
+    mServiceRTT.AddSample(aRTTMS);
+
+    timeout = mServiceRTT.GetRetransTimeout();
+    change  = (timeout > mAppliedRetransTimeoutMS) ? timeout - mAppliedRetransTimeoutMS : mAppliedRetransTimeoutMS - timeout;
+    if (change < SERVICE_WRM_RETRANS_TIMEOUT_HYSTERESIS_MS)
+    {
+        return;
+    }
+
+    mAppliedRetransTimeoutMS = timeout;
+
+    // The piggyback bound depends on the retransmission timeout.
+    mAppliedPiggybackAckTimeoutMS = GetPiggybackAckTimeout();
+
+    ApplyServiceWRMPConfig();
+}
+
+void WDMFeature::UpdatePiggybackAckTimeout(void)
+{
+    uint32_t timeout = GetPiggybackAckTimeout();
+
+    if (timeout == mAppliedPiggybackAckTimeoutMS)
+    {
+        return;
+    }
+
+    mAppliedPiggybackAckTimeoutMS = timeout;
+
+    ApplyServiceWRMPConfig();
+}
+
+void WDMFeature::ApplyServiceWRMPConfig(void)
+{
+    // New exchanges on the service bindings pick up the new configuration.
+    if (mServiceSubBinding != NULL)
+    {
+        mServiceSubBinding->SetDefaultWRMPConfig(GetServiceWRMPConfig());
+        mServiceSubBinding->SetDefaultResponseTimeout(GetServiceResponseTimeout());
+    }
+    if (mServiceCounterSubHandler != NULL)
+    {
+        mServiceCounterSubHandler->GetBinding()->SetDefaultWRMPConfig(GetServiceWRMPConfig());
+        mServiceCounterSubHandler->GetBinding()->SetDefaultResponseTimeout(GetServiceResponseTimeout());
+    }
+}
+
+void WDMFeature::RecordCommandAck(const ExchangeContext * aEC)
+{
+    // Called just before the response to a command is sent.  If the ack for the command is
+    // still pending it goes out with the response; otherwise the piggyback timer has already
+    // fired and WRM sent it on its own.
+    if (aEC == NULL || !aEC->HasPeerRequestedAck())
+    {
+        return;
+    }
+
+    if (aEC->IsAckPending())
+    {
+        mAckStats.Piggybacked++;
+    }
+    else
+    {
+        mAckStats.Standalone++;
+    }
+}
+
+WEAVE_ERROR WDMFeature::RegisterSourceTrait(TraitDataSource * aSource, uint64_t aInstanceId)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit(mSourceTraitCount < WDM_MAX_SOURCE_TRAITS, err = WEAVE_ERROR_NO_MEMORY);
+
+    err = mServiceSourceTraitCatalog.AddAt(aInstanceId, aSource, mSourceTraitCount);
+    SuccessOrExit(err);
+
+    mSourceTraitCount++;
+
+exit:
+    return err;
+}
+
+WEAVE_ERROR WDMFeature::RegisterSinkTrait(TraitDataSink * aSink, uint64_t aInstanceId)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit(mSinkTraitCount < WDM_MAX_SINK_TRAITS, err = WEAVE_ERROR_NO_MEMORY);
+
+    err = mServiceSinkTraitCatalog.AddAt(aInstanceId, aSink, mSinkTraitCount);
+    SuccessOrExit(err);
+
+    // Subscribe to the whole of each sink trait.
+    mServiceSinkTraitPaths[mSinkTraitCount].mTraitDataHandle    = mSinkTraitCount;
+    mServiceSinkTraitPaths[mSinkTraitCount].mPropertyPathHandle = kRootPropertyPathHandle;
+
+    mSinkTraitCount++;
+
+exit:
+    return err;
+}
@@ -30,6 +30,7 @@ struct AppEvent
         kEventType_Timer,
         kEventType_Lock,
         kEventType_Install,
+        kEventType_BLE,
     };
 
     uint16_t Type;
@@ -47,9 +48,32 @@ struct AppEvent
         } TimerEvent;
         struct
         {
+            uint8_t Actuator;
             uint8_t Action;
             int32_t Actor;
+            uint8_t CommandSource;           // BoltLockTraitDataSource::CommandSource of the command.
+            int64_t CommandInitiationTimeUS; // Initiation time stamped by the sender (UTC); 0 if none.
         } LockEvent;
+        struct
+        {
+            uint16_t Id; // SoftDevice BLE event id.
+            uint16_t ConnHandle;
+            union
+            {
+                uint32_t RxBytes; // BLE_GAP_EVT_DISCONNECTED: bytes written by the central.
+                struct
+                {
+                    uint8_t TxPhy;
+                    uint8_t RxPhy;
+                    uint8_t Status;
+                } PhyUpdate;
+                struct
+                {
+                    uint16_t ConnInterval; // In units of 1.25 ms.
+                    uint16_t SlaveLatency;
+                } ConnParamUpdate;
+            };
+        } BLEEvent;
     };
 
     EventHandler Handler;
@@ -36,16 +36,20 @@ public:
     int StartAppTask();
     static void AppTaskMain(void * pvParameter);
 
-    void PostLockActionRequest(int32_t aActor, BoltLockManager::Action_t aAction);
+    void PostLockActionRequest(uint8_t aActuator, int32_t aActor, BoltLockManager::Action_t aAction, uint8_t aCommandSource,
+                               int64_t aCommandInitiationTimeUS);
     void PostEvent(const AppEvent * event);
+    void PostEventFromISR(const AppEvent * event);
 
 private:
     friend AppTask & GetAppTask(void);
 
     int Init();
 
-    static void ActionInitiated(BoltLockManager::Action_t aAction, int32_t aActor);
-    static void ActionCompleted(BoltLockManager::Action_t aAction);
+    static void ActionInitiated(BoltLockManager & aLock, BoltLockManager::Action_t aAction, int32_t aActor);
+    static void ActionCompleted(BoltLockManager & aLock, BoltLockManager::Action_t aAction);
+    static bool AreAllLocksLocked(void);
+    static bool IsAnyLockActionInProgress(void);
 
     void CancelTimer(void);
 
@@ -0,0 +1,117 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          BLE connection parameter policy for WoBLE provisioning.
+ *
+ *          Pairing and provisioning over WoBLE move certificates and CASE/PASE messages
+ *          through a single GATT connection, so the time they take depends mostly on
+ *          the connection interval and PHY chosen by the central.  MTU and data length
+ *          are already negotiated up to NRF_SDH_BLE_GATT_MAX_MTU_SIZE and
+ *          NRF_SDH_BLE_GAP_DATA_LENGTH by the GATT module; nothing asks for a faster
+ *          interval or for the 2M PHY.
+ *
+ *          While the device is not fully provisioned, the policy requests the 2M PHY and
+ *          a short connection interval (BLE_CONN_FAST_*) as soon as a central connects.
+ *          Once provisioning completes, or for connections made after the device has
+ *          been provisioned, it requests a relaxed interval (BLE_CONN_SLOW_*) with
+ *          slave latency to reduce the energy spent holding the connection open.  The
+ *          2M PHY is kept, since it is also the cheaper PHY per byte.
+ *
+ *          SoftDevice events arrive in interrupt context; the policy counts the bytes
+ *          written by the central there and hands every other event to the application
+ *          task, where the connection state is kept and the SoftDevice requests are made.
+ *          The GATT module's data length and MTU procedures run right after a connection
+ *          is made, so a request refused as busy is retried when a procedure completes.
+ *
+ *          For each connection the policy records its duration, the number of bytes
+ *          written by the central and, if the device became provisioned during the
+ *          connection, the time from connection to provisioning.
+ */
+
+#ifndef BLE_CONNECTION_POLICY_H
+#define BLE_CONNECTION_POLICY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "AppEvent.h"
+
+#include "ble.h"
+#include "sdk_errors.h"
+
+#include <Weave/DeviceLayer/WeaveDeviceLayer.h>
+
+/**
+ * Counters describing WoBLE connections.  The "Last" values refer to the most recent
+ * connection that has ended.
+ */
+struct BLEConnectionStats
+{
+    uint32_t Connections;        // Connections accepted.
+    uint32_t Provisioned;        // Connections during which the device became fully provisioned.
+    uint32_t LastDurationMS;     // Duration of the last connection.
+    uint32_t LastRxBytes;        // Bytes written by the central during the last connection.
+    uint32_t LastProvisioningMS; // Time from connection to provisioning, for the last provisioning connection.
+    uint32_t MaxProvisioningMS;  // Longest such time.
+};
+
+class BLEConnectionPolicy
+{
+public:
+    ret_code_t Init(void);
+
+    void GetStats(BLEConnectionStats & aStats) const;
+
+    static void SoftDeviceEventHandler(const ble_evt_t * aEvent, void * aContext);
+
+private:
+    friend BLEConnectionPolicy & GetBLEConnectionPolicy(void);
+
+    enum
+    {
+        kRequest_PhyUpdate       = 0x01,
+        kRequest_ConnParamUpdate = 0x02,
+    };
+
+    uint16_t mConnHandle;
+    volatile bool mIsProvisioned;
+    bool mIsRelaxed;
+    uint8_t mPendingRequests; // Requests refused by the SoftDevice as busy, to be sent again.
+    uint64_t mConnectedMS;
+    volatile uint32_t mRxBytes; // Bytes written by the central; updated in interrupt context.
+    BLEConnectionStats mStats;
+
+    void RequestFastConnection(void);
+    void RequestRelaxedConnection(void);
+    void SendPendingRequests(void);
+
+    static void BLEEventHandler(AppEvent * aEvent);
+    static void ProvisioningEventHandler(AppEvent * aEvent);
+    static void PlatformEventHandler(const ::nl::Weave::DeviceLayer::WeaveDeviceEvent * event, intptr_t arg);
+
+    static BLEConnectionPolicy sBLEConnectionPolicy;
+};
+
+inline BLEConnectionPolicy & GetBLEConnectionPolicy(void)
+{
+    return BLEConnectionPolicy::sBLEConnectionPolicy;
+}
+
+#endif // BLE_CONNECTION_POLICY_H
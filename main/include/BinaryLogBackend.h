@@ -0,0 +1,64 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Binary nrf_log backend.
+ *
+ *          When the application is built with LOG_FORMAT=binary, log entries are not
+ *          formatted on the device.  Instead, when the deferred log buffer is processed
+ *          (from the idle task), each entry is written to RTT as a compact binary record
+ *          carrying the address of its format string and its raw arguments.  String
+ *          arguments are copied into the record, since they may not be present in the
+ *          application image (e.g. strings pushed with NRF_LOG_PUSH).
+ *
+ *          The records are decoded on the host by tools/binlog_decode.py, which resolves
+ *          format strings and module names against the application ELF file.
+ *
+ *          Record format (little endian):
+ *
+ *              uint8_t  Magic                  (0xB1)
+ *              uint8_t  Type                   (1 = log message, 2 = hex dump)
+ *              uint16_t Length                 Length of the rest of the record
+ *              uint32_t Timestamp
+ *              uint32_t ModuleName             Address of the module name string
+ *              uint16_t Dropped                Number of entries dropped before this one
+ *              uint8_t  Severity
+ *              uint8_t  NumArgs                (log message) / reserved (hex dump)
+ *
+ *          followed, for a log message, by the address of the format string (uint32_t)
+ *          and the arguments in order: 32-bit values for numeric conversions, and a length
+ *          byte followed by the characters for %s conversions; or, for a hex dump, by the
+ *          data bytes.
+ */
+
+#ifndef BINARY_LOG_BACKEND_H
+#define BINARY_LOG_BACKEND_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Registers and enables the binary backend, in place of NRF_LOG_DEFAULT_BACKENDS_INIT().
+void BinaryLogBackendInit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BINARY_LOG_BACKEND_H
@@ -23,7 +23,16 @@
 #include <stdbool.h>
 
 #include "AppEvent.h"
+#include "app_config.h"
+#include "app_timer.h"
 
+/**
+ * Controls a single bolt lock actuator.
+ *
+ * The device drives BOLT_LOCK_ACTUATOR_COUNT actuators, each represented by its own
+ * BoltLockManager instance with its own movement / auto-relock timer.  Instances are
+ * accessed by actuator index through BoltLockMgr().
+ */
 class BoltLockManager
 {
 public:
@@ -43,20 +52,22 @@ public:
         kState_UnlockingCompleted,
     } State;
 
-    int Init();
+    int Init(uint8_t aIndex);
+    uint8_t GetIndex(void) const;
     bool IsUnlocked();
     void EnableAutoRelock(bool aOn);
     void SetAutoLockDuration(uint32_t aDurationInSecs);
     bool IsActionInProgress();
     bool InitiateAction(int32_t aActor, Action_t aAction);
 
-    typedef void (*Callback_fn_initiated)(Action_t, int32_t aActor);
-    typedef void (*Callback_fn_completed)(Action_t);
+    typedef void (*Callback_fn_initiated)(BoltLockManager & aLock, Action_t, int32_t aActor);
+    typedef void (*Callback_fn_completed)(BoltLockManager & aLock, Action_t);
     void SetCallbacks(Callback_fn_initiated aActionInitiated_CB, Callback_fn_completed aActionCompleted_CB);
 
 private:
-    friend BoltLockManager & BoltLockMgr(void);
+    friend BoltLockManager & BoltLockMgr(uint8_t aIndex);
     State_t mState;
+    uint8_t mIndex;
 
     Callback_fn_initiated mActionInitiated_CB;
     Callback_fn_completed mActionCompleted_CB;
@@ -65,6 +76,9 @@ private:
     uint32_t mAutoLockDuration;
     bool mAutoLockTimerArmed;
 
+    app_timer_t mTimerData;
+    app_timer_id_t mTimer;
+
     void CancelTimer(void);
     void StartTimer(uint32_t aTimeoutMs);
 
@@ -72,12 +86,17 @@ private:
     static void AutoReLockTimerEventHandler(AppEvent * aEvent);
     static void ActuatorMovementTimerEventHandler(AppEvent *aEvent);
 
-    static BoltLockManager sLock;
+    static BoltLockManager sLocks[BOLT_LOCK_ACTUATOR_COUNT];
 };
 
-inline BoltLockManager & BoltLockMgr(void)
+inline BoltLockManager & BoltLockMgr(uint8_t aIndex = 0)
+{
+    return BoltLockManager::sLocks[aIndex];
+}
+
+inline uint8_t BoltLockManager::GetIndex(void) const
 {
-    return BoltLockManager::sLock;
+    return mIndex;
 }
 
 #endif // LOCK_MANAGER_H
@@ -0,0 +1,40 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Boot-time benchmark of the cryptographic primitives used by the application
+ *          and by Weave.
+ *
+ *          When CRYPTO_BENCHMARK_ENABLED is set, RunCryptoBenchmark() measures (with the
+ *          DWT cycle counter) the cost of SHA-256 in mbedTLS and in the backend selected
+ *          with the CRYPTO_BACKEND make option (see PersistentSHA256.h), in cycles per
+ *          byte, and the cost of the operations that Weave performs in software mbedTLS
+ *          whatever the backend: an AES-128 block encryption, in cycles per byte, and a
+ *          P-256 ECDH shared secret computation (the scalar multiplication that dominates
+ *          CASE session establishment), in cycles per operation.  Comparing builds with
+ *          CRYPTO_BACKEND=software and CRYPTO_BACKEND=cc310 shows the gain from the
+ *          CryptoCell.
+ */
+
+#ifndef CRYPTO_BENCHMARK_H
+#define CRYPTO_BENCHMARK_H
+
+void RunCryptoBenchmark(void);
+
+#endif // CRYPTO_BENCHMARK_H
@@ -0,0 +1,169 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Streaming applier for binary delta (patch) software update images.
+ *
+ *          A delta image reconstructs a new firmware image from the image currently
+ *          running on the device.  The format follows bsdiff: a fixed header followed by
+ *          a sequence of commands, each consisting of a control entry and its data:
+ *
+ *              Header (80 bytes, little-endian):
+ *                  uint32  Magic           'WDLT'
+ *                  uint16  Version         1
+ *                  uint16  Reserved
+ *                  uint32  SourceLen       Length of the running image the patch applies to
+ *                  uint32  TargetLen       Length of the reconstructed image
+ *                  uint8   SourceHash[32]  SHA-256 of the running image
+ *                  uint8   TargetHash[32]  SHA-256 of the reconstructed image
+ *
+ *              Command:
+ *                  uint32  DiffLen         Number of bytes derived from the source image
+ *                  uint32  ExtraLen        Number of literal bytes
+ *                  int32   Seek            Source position adjustment after the command
+ *                  <diff runs>             Encoding of DiffLen bytes (see below)
+ *                  <ExtraLen literal bytes>
+ *
+ *          The diff bytes are run-length encoded, since most of them are zero when the
+ *          two images are similar.  Each run starts with a token byte: if bit 7 is set,
+ *          the next (token & 0x7F) + 1 bytes are copied unchanged from the source;
+ *          otherwise (token + 1) delta bytes follow, each added (mod 256) to the
+ *          corresponding source byte.
+ *
+ *          The applier processes its input in arbitrarily sized pieces, holds no more
+ *          than a single control entry in RAM, and its complete state can be captured
+ *          with SaveState() so that a reconstruction can be resumed after a reset.
+ *
+ *          Patches are generated with tools/delta_patch.py.
+ */
+
+#ifndef DELTA_PATCHER_H
+#define DELTA_PATCHER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <Weave/DeviceLayer/WeaveDeviceLayer.h>
+
+class DeltaPatcher
+{
+public:
+    enum
+    {
+        kMagic      = 0x544C4457, // 'WDLT'
+        kVersion    = 1,
+        kHashLength = 32,
+    };
+
+    struct Header
+    {
+        uint32_t Magic;
+        uint16_t Version;
+        uint16_t Reserved;
+        uint32_t SourceLen;
+        uint32_t TargetLen;
+        uint8_t SourceHash[kHashLength];
+        uint8_t TargetHash[kHashLength];
+    };
+
+    void Init(const uint8_t * aSource, uint32_t aSourceSize);
+    void Begin(void);
+
+    // Consumes patch bytes from aIn and writes reconstructed image bytes to aOut, stopping when
+    // either the input is exhausted or the output buffer is full.
+    WEAVE_ERROR Apply(const uint8_t * aIn, uint32_t aInLen, uint32_t & aConsumed, uint8_t * aOut, uint32_t aOutLen,
+                      uint32_t & aProduced);
+
+    bool HaveHeader(void) const;
+    bool IsComplete(void) const;
+    const Header & GetHeader(void) const;
+
+    static bool IsDeltaImage(const uint8_t * aData, uint32_t aDataLen);
+
+private:
+    enum Phase
+    {
+        kPhase_Header = 0,
+        kPhase_Control,
+        kPhase_DiffToken,
+        kPhase_DiffCopy,
+        kPhase_DiffAdd,
+        kPhase_Extra,
+        kPhase_Done,
+    };
+
+    enum
+    {
+        kControlLength = 12,
+    };
+
+    struct State
+    {
+        uint8_t Phase;
+        uint8_t FieldLen; // Bytes of the header or control entry accumulated so far.
+        uint16_t Reserved;
+        uint32_t SourcePos;
+        uint32_t TargetPos;
+        uint32_t DiffRemaining;
+        uint32_t RunRemaining;
+        uint32_t ExtraRemaining;
+        int32_t Seek;
+        uint8_t Control[kControlLength];
+        Header Hdr;
+    };
+
+public:
+    enum
+    {
+        kStateLength = sizeof(State),
+    };
+
+    // Copies the applier state into aStateBuf, which must be kStateLength bytes.
+    void SaveState(uint8_t * aStateBuf) const;
+
+    // Resumes patching from a state previously captured with SaveState().
+    void RestoreState(const uint8_t * aStateBuf);
+
+private:
+    State mState;
+    const uint8_t * mSource;
+    uint32_t mSourceSize;
+
+    WEAVE_ERROR ParseHeader(void);
+    WEAVE_ERROR ParseControl(void);
+    WEAVE_ERROR EndCommand(void);
+    void NextDiffPhase(void);
+};
+
+inline bool DeltaPatcher::HaveHeader(void) const
+{
+    return mState.Phase != kPhase_Header;
+}
+
+inline bool DeltaPatcher::IsComplete(void) const
+{
+    return mState.Phase == kPhase_Done;
+}
+
+inline const DeltaPatcher::Header & DeltaPatcher::GetHeader(void) const
+{
+    return mState.Hdr;
+}
+
+#endif // DELTA_PATCHER_H
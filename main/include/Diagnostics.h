@@ -0,0 +1,69 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Periodic device health reporting.
+ *
+ *          At a fixed interval the Diagnostics module takes a snapshot of system
+ *          resource usage, writes it to the device log and records it as a Weave debug
+ *          event, which is offloaded to the service along with the other device events.
+ */
+
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <stdint.h>
+
+#include "AppEvent.h"
+
+#include "sdk_errors.h"
+
+class Diagnostics
+{
+public:
+    ret_code_t Init(void);
+    void Report(void);
+
+private:
+    friend Diagnostics & GetDiagnostics(void);
+
+    void ReportHeap(void);
+    void ReportPools(void);
+    void ReportMemManager(void);
+    void ReportStacks(void);
+    void ReportRunTime(void);
+    void ReportSleep(void);
+    void ReportPublish(void);
+    void ReportServiceRTT(void);
+    void ReportServiceSession(void);
+    void ReportCommands(void);
+    void ReportBLE(void);
+
+    static void TimerEventHandler(void * p_context);
+    static void ReportEventHandler(AppEvent * aEvent);
+
+    static Diagnostics sDiagnostics;
+};
+
+inline Diagnostics & GetDiagnostics(void)
+{
+    return Diagnostics::sDiagnostics;
+}
+
+#endif // DIAGNOSTICS_H
@@ -0,0 +1,91 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Radio-aware scheduling and accounting for software update image downloads.
+ *
+ *          While an image is being transferred the device switches to a fast Thread
+ *          polling interval (see ThreadPollingPolicy.h), so that each BDX block
+ *          request/response round trip is not stretched out to the sleepy polling
+ *          period.  Normal polling is restored once the transfer ends.
+ *
+ *          The scheduler also keeps throughput and energy-proxy counters for the
+ *          transfer and rate-limits per-block progress logging.
+ *
+ *          All methods must be called with the Weave stack lock held (e.g. from the
+ *          SoftwareUpdateManager event callback).
+ */
+
+#ifndef DOWNLOAD_SCHEDULER_H
+#define DOWNLOAD_SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+class DownloadScheduler
+{
+public:
+    struct Stats
+    {
+        uint32_t BytesReceived;       // Image bytes received during the current/last transfer.
+        uint32_t BlocksReceived;      // Number of image blocks received.
+        uint32_t MaxBlockLen;         // Largest block delivered by the transport.
+        uint32_t ElapsedMS;           // Duration of the transfer.
+        uint32_t StoreTimeMS;         // Time spent committing blocks to flash.
+        uint32_t EstimatedPolls;      // Estimated number of Thread data polls (energy proxy).
+        uint32_t SuppressedLogs;      // Per-block progress logs suppressed by rate limiting.
+    };
+
+    void OnDownloadStart(uint32_t aResumeOffset);
+    void OnBlockStored(uint32_t aBlockLen, uint32_t aImageLen, uint32_t aStoreTimeMS);
+    void OnDownloadEnd(void);
+
+    bool IsDownloadActive(void) const;
+    uint32_t GetThroughput(void) const;
+    const Stats & GetStats(void) const;
+
+private:
+    friend DownloadScheduler & GetDownloadScheduler(void);
+
+    Stats mStats;
+    uint64_t mStartTimeMS;
+    uint32_t mNextLogOffset;
+    bool mDownloadActive;
+
+    void UpdateElapsed(void);
+
+    static DownloadScheduler sDownloadScheduler;
+};
+
+inline DownloadScheduler & GetDownloadScheduler(void)
+{
+    return DownloadScheduler::sDownloadScheduler;
+}
+
+inline bool DownloadScheduler::IsDownloadActive(void) const
+{
+    return mDownloadActive;
+}
+
+inline const DownloadScheduler::Stats & DownloadScheduler::GetStats(void) const
+{
+    return mStats;
+}
+
+#endif // DOWNLOAD_SCHEDULER_H
@@ -0,0 +1,35 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Boot-time benchmark of the formatting helpers against the generic printf engine.
+ *
+ *          When FORMAT_BENCHMARK_ENABLED is set, RunFormatBenchmark() formats a 32-bit
+ *          decimal, a 64-bit hexadecimal identifier and a date with the helpers of
+ *          FormatUtils.h and with snprintf() (the AltPrintf engine), and logs for each the
+ *          cycles per call (measured with the DWT cycle counter) and the peak stack use
+ *          (measured by painting the stack below the caller).
+ */
+
+#ifndef FORMAT_BENCHMARK_H
+#define FORMAT_BENCHMARK_H
+
+void RunFormatBenchmark(void);
+
+#endif // FORMAT_BENCHMARK_H
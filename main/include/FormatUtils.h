@@ -0,0 +1,54 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Allocation-free formatting of integers and dates.
+ *
+ *          These routines cover the handful of fixed formats the application produces
+ *          itself (zero-padded decimals, 64-bit hexadecimal identifiers and ISO 8601
+ *          dates) without going through the generic printf engine.  They use a few
+ *          bytes of stack, never touch the heap, and avoid the format string parsing
+ *          and varargs handling of vsnprintf().
+ *
+ *          They also provide the way to log 64-bit values: nrf_log passes every
+ *          argument as a 32-bit word, so a 64-bit argument must be formatted into a
+ *          string and passed with NRF_LOG_PUSH().
+ *
+ *          Each function writes a NUL-terminated string and returns its length.  If the
+ *          result does not fit in the supplied buffer, nothing is written beyond an
+ *          empty string and 0 is returned.
+ */
+
+#ifndef FORMAT_UTILS_H
+#define FORMAT_UTILS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum
+{
+    kFormatHex64StrSize = 16 + 1, // 16 hex digits plus terminator.
+    kFormatDateStrSize  = 10 + 1, // YYYY-MM-DD plus terminator.
+};
+
+size_t FormatDecimal(char * aBuf, size_t aBufSize, uint32_t aValue, uint8_t aMinWidth = 0);
+size_t FormatHex(char * aBuf, size_t aBufSize, uint64_t aValue, uint8_t aMinWidth = 0);
+size_t FormatDate(char * aBuf, size_t aBufSize, uint16_t aYear, uint8_t aMonth, uint8_t aDayOfMonth);
+
+#endif // FORMAT_UTILS_H
@@ -48,7 +48,13 @@
 #define configCPU_CLOCK_HZ                                                        ( SystemCoreClock )
 #define configTICK_RATE_HZ                                                        1024
 #define configMAX_PRIORITIES                                                      ( 3 )
+#if NRF_LOG_ENABLED && NRF_LOG_DEFERRED
+/* The idle task also formats and writes the deferred log entries (see configUSE_IDLE_HOOK).
+ * Size checked against the IDLE entry of the stack report (see StackMonitor.h). */
+#define configMINIMAL_STACK_SIZE                                                  ( 256 )
+#else
 #define configMINIMAL_STACK_SIZE                                                  ( 100 )
+#endif
 #define configTOTAL_HEAP_SIZE                                                     0 /* FreeRTOS heap functions mapped to malloc/free (heap_3.c) */
 #define configMAX_TASK_NAME_LEN                                                   ( 8 )
 #define configUSE_16_BIT_TICKS                                                    0
@@ -64,13 +70,26 @@
 #define configENABLE_BACKWARD_COMPATIBILITY                                       1
 
 /* Hook function related definitions. */
-#define configUSE_IDLE_HOOK                                                       0
+#define configUSE_IDLE_HOOK                                                       (NRF_LOG_ENABLED && NRF_LOG_DEFERRED) /* See DeferredLogSupport.c */
 #define configUSE_TICK_HOOK                                                       0
+#if BUILD_RELEASE
 #define configCHECK_FOR_STACK_OVERFLOW                                            0
+#else
+#define configCHECK_FOR_STACK_OVERFLOW                                            2 /* See vApplicationStackOverflowHook in StackMonitor.c */
+#endif
 #define configUSE_MALLOC_FAILED_HOOK                                              0
 
-/* Run time and task stats gathering related definitions. */
-#define configGENERATE_RUN_TIME_STATS                                             0
+/* Run time and task stats gathering related definitions.  See RunTimeStats.h. */
+#ifndef RUN_TIME_STATS_ENABLED
+#define RUN_TIME_STATS_ENABLED                                                    (!BUILD_RELEASE)
+#endif
+#define configGENERATE_RUN_TIME_STATS                                             RUN_TIME_STATS_ENABLED
+#if configGENERATE_RUN_TIME_STATS
+#include "RunTimeStats.h"
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()                                  ConfigureRunTimeStatsTimer()
+#define portGET_RUN_TIME_COUNTER_VALUE()                                          GetRunTimeCounterValue()
+#define traceTASK_SWITCHED_IN()                                                   pxCurrentTCB->uxTaskNumber = RunTimeStatsTaskSwitchedIn(pxCurrentTCB->uxTaskNumber)
+#endif
 #define configUSE_STATS_FORMATTING_FUNCTIONS                                      0
 
 /* Co-routine definitions. */
@@ -86,14 +105,29 @@
 /* Tickless Idle configuration. */
 #define configEXPECTED_IDLE_TIME_BEFORE_SLEEP                                     2
 
-/* Tickless idle/low power functionality. */
+/* Tickless idle/low power functionality.  See SleepProfiler.h. */
+#ifndef SLEEP_PROFILER_ENABLED
+#define SLEEP_PROFILER_ENABLED                                                    1
+#endif
+#if SLEEP_PROFILER_ENABLED
+#include "SleepProfiler.h"
+#define configPRE_SLEEP_PROCESSING(xExpectedIdleTime)                             SleepProfilerPreSleep()
+#define configPOST_SLEEP_PROCESSING(xExpectedIdleTime)                            SleepProfilerPostSleep()
+#endif
 
-/* */
+/* Memory allocation related definitions.  Static allocation is used for the application's own
+ * RTOS objects (and the idle and timer tasks) when the build sets USE_STATIC_RTOS_OBJECTS=1.
+ * Dynamic allocation remains available for objects created by the Weave and OpenThread stacks. */
+#ifndef USE_STATIC_RTOS_OBJECTS
+#define USE_STATIC_RTOS_OBJECTS                                                   0
+#endif
+#define configSUPPORT_STATIC_ALLOCATION                                           USE_STATIC_RTOS_OBJECTS
 #define configSUPPORT_DYNAMIC_ALLOCATION                                          1
 
 /* Debugging support. */
 #define configINCLUDE_FREERTOS_TASK_C_ADDITIONS_H                                 1
 #define configUSE_TRACE_FACILITY                                                  1
+#define configRECORD_STACK_HIGH_ADDRESS                                           1 /* Needed to report stack sizes (see StackMonitor.h) */
 
 /* Define to trap errors during development. */
 #if defined(DEBUG_NRF) || defined(DEBUG_NRF_USER)
@@ -115,6 +149,7 @@
 #define INCLUDE_xTaskGetCurrentTaskHandle                                         1
 #define INCLUDE_uxTaskGetStackHighWaterMark                                       1
 #define INCLUDE_xTaskGetIdleTaskHandle                                            1
+#define INCLUDE_xSemaphoreGetMutexHolder                                          1
 #define INCLUDE_xTimerGetTimerDaemonTaskHandle                                    0
 #define INCLUDE_pcTaskGetTaskName                                                 1
 #define INCLUDE_eTaskGetState                                                     1
@@ -0,0 +1,89 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Heap usage monitoring for the newlib system heap.
+ *
+ *          The application is linked with -Wl,--wrap for malloc(), calloc(), realloc()
+ *          and free(), routing every heap allocation through the wrappers in
+ *          HeapMonitor.c.  The wrappers maintain running totals, peak usage and failure
+ *          counts, and (when HEAP_MONITOR_CALL_SITE_TAGS is enabled) attribute each live
+ *          allocation to the code address that requested it.
+ */
+
+#ifndef HEAP_MONITOR_H
+#define HEAP_MONITOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    uint32_t TotalSize;             // Size of the heap region, in bytes.
+    uint32_t InUse;                 // Bytes currently allocated (including allocator overhead).
+    uint32_t PeakInUse;             // High-water mark of InUse.
+    uint32_t FreeTotal;             // Bytes on the free list plus not yet claimed from sbrk.
+    uint32_t LargestFree;           // Estimate of the largest satisfiable allocation.
+    uint32_t FragmentationPermille; // 1000 * (1 - LargestFree / FreeTotal).
+    uint32_t AllocCount;            // Number of successful allocations since boot.
+    uint32_t FailCount;             // Number of failed allocations since boot.
+} HeapStats;
+
+typedef struct
+{
+    uintptr_t CallSite;             // Return address of the allocating call; 0 for untracked allocations.
+    uint32_t LiveCount;
+    uint32_t LiveBytes;
+    uint32_t PeakBytes;
+    uint32_t FailCount;
+} HeapCallSiteStats;
+
+typedef struct
+{
+    uint32_t LockCount;             // Number of outermost heap lock acquisitions.
+    uint32_t ContentionCount;       // Acquisitions that had to wait for another task.
+    uint32_t MaxHoldCycles;         // Longest time the lock was held, in CPU cycles.
+    uint64_t TotalHoldCycles;       // Total time the lock was held, in CPU cycles.
+    uint8_t InterruptsMasked;       // Non-zero if the heap lock masks interrupts while held.
+} HeapLockStats;
+
+void GetHeapStats(HeapStats * stats);
+
+// Implemented alongside the heap lock in FreeRTOSNewlibLockSupport.c.  All values are zero
+// unless HEAP_LOCK_STATS_ENABLED is set.
+void GetHeapLockStats(HeapLockStats * stats);
+
+// Implemented alongside the heap lock.  Returns false if the heap must not be used by the
+// calling task: the scheduler is suspended while another task holds the heap lock.
+bool HeapLockAvailable(void);
+
+// Copies the statistics of up to maxSites call sites, ordered by live bytes (largest first),
+// and returns the number of entries written.
+size_t GetHeapCallSiteStats(HeapCallSiteStats * sites, size_t maxSites);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HEAP_MONITOR_H
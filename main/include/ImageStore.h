@@ -0,0 +1,150 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Flash-backed storage for software update images.
+ *
+ *          Image blocks are written page-by-page into a secondary flash slot reserved
+ *          by the linker script.  Download progress is recorded as a sequence of small
+ *          records in a separate image state page, allowing an interrupted download to
+ *          be resumed after a reset.
+ *
+ *          The image hash is computed incrementally as pages are committed, and the
+ *          intermediate hash state is checkpointed to the state page at regular
+ *          intervals, so computing the final image integrity never requires
+ *          re-downloading (or re-reading) the whole image.
+ *
+ *          Delta images (see DeltaPatcher.h) are applied as they are downloaded: the
+ *          reconstructed image is written to the slot while the hash covers the
+ *          downloaded patch, and the patch applier state is checkpointed along with it.
+ *          The reconstructed image is verified against the target hash carried in the
+ *          patch before it is offered for installation.
+ *
+ *          This example has no bootloader, so a verified image is not installed.  The
+ *          secondary slot is sized to hold any image that fits the application area.
+ */
+
+#ifndef IMAGE_STORE_H
+#define IMAGE_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <Weave/DeviceLayer/WeaveDeviceLayer.h>
+
+#include "nrf_fstorage.h"
+
+#include "PersistentSHA256.h"
+#include "DeltaPatcher.h"
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+class ImageStore
+{
+public:
+    enum
+    {
+        kPageSize   = 4096, // Must match FLASH_PAGE_SIZE in the linker script.
+        kHashLength = 32,
+    };
+
+    WEAVE_ERROR Init(void);
+
+    WEAVE_ERROR PrepareImage(const char * aURI);
+    uint32_t GetPartialImageLength(const char * aURI);
+    WEAVE_ERROR StoreBlock(const uint8_t * aData, uint32_t aDataLen);
+    WEAVE_ERROR ComputeIntegrity(uint8_t * aHashBuf, uint32_t aHashBufLen);
+    WEAVE_ERROR Reset(void);
+
+    uint32_t GetImageLength(void) const;
+
+private:
+    friend ImageStore & GetImageStore(void);
+
+    enum RecordType
+    {
+        kRecordType_ImageInfo       = 0x0001,
+        kRecordType_Progress        = 0x0002,
+        kRecordType_HashCheckpoint  = 0x0004,
+        kRecordType_PatchCheckpoint = 0x0005,
+
+        kRecordType_Erased          = 0xFFFF,
+    };
+
+    struct RecordHeader
+    {
+        uint16_t Type;
+        uint16_t Length; // Length of the record body; always a multiple of 4.
+        uint16_t CRC;    // CRC-16 of the record body.
+        uint16_t Reserved;
+    };
+
+    uint32_t mSlotStart;
+    uint32_t mSlotSize;
+    uint32_t mStateStart;
+    uint32_t mStateWriteOffset;
+
+    uint32_t mImageLen;     // Number of image bytes committed to the slot.
+    uint32_t mPageBufLen;   // Number of image bytes waiting in mPageBuf.
+    uint32_t mPatchLen;     // Number of delta image bytes consumed by mPatcher.
+    bool mIsDelta;
+    bool mHaveImageInfo;
+    bool mHaveDigest;
+
+    PersistentSHA256 mSHA256;
+    DeltaPatcher mPatcher;
+    uint8_t mDigest[kHashLength];
+    uint32_t mPageBuf[kPageSize / sizeof(uint32_t)];
+
+    SemaphoreHandle_t mFlashOpSem;
+#if configSUPPORT_STATIC_ALLOCATION
+    StaticSemaphore_t mFlashOpSemStruct;
+#endif
+    volatile ret_code_t mFlashOpResult;
+
+    WEAVE_ERROR LoadState(void);
+    WEAVE_ERROR RestoreHashState(const RecordHeader * aCheckpoint);
+    WEAVE_ERROR StorePatchBlock(const uint8_t * aData, uint32_t aDataLen);
+    WEAVE_ERROR VerifyPatchedImage(void);
+    WEAVE_ERROR FlushPage(void);
+    bool HaveRoomForCheckpoint(void) const;
+    WEAVE_ERROR AppendRecord(uint16_t aType, const void * aBody, uint16_t aBodyLen);
+    const RecordHeader * FindRecord(uint16_t aType) const;
+
+    WEAVE_ERROR EraseFlash(uint32_t aAddr, uint32_t aNumPages);
+    WEAVE_ERROR WriteFlash(uint32_t aAddr, const void * aData, uint32_t aDataLen);
+
+    static void FStorageEventHandler(nrf_fstorage_evt_t * aEvent);
+
+    static nrf_fstorage_t sFStorage;
+    static ImageStore sImageStore;
+};
+
+inline ImageStore & GetImageStore(void)
+{
+    return ImageStore::sImageStore;
+}
+
+inline uint32_t ImageStore::GetImageLength(void) const
+{
+    return mImageLen + mPageBufLen;
+}
+
+#endif // IMAGE_STORE_H
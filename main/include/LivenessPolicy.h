@@ -0,0 +1,109 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Service subscription liveness policy.
+ *
+ *          The device and the service keep each other's subscriptions alive by sending an
+ *          empty notify whenever a subscription's liveness timeout passes without other
+ *          traffic, so the liveness timeout sets the rate of idle keep-alive exchanges.
+ *          A short timeout detects a lost subscription quickly, but on a battery powered
+ *          sleepy device every keep-alive costs a radio exchange.
+ *
+ *          The policy selects the liveness timeout from the power state:
+ *
+ *          - External power:  LIVENESS_TIMEOUT_EXTERNAL_POWER_SEC
+ *          - Battery:         LIVENESS_TIMEOUT_BATTERY_SEC
+ *          - Low battery:     LIVENESS_TIMEOUT_LOW_BATTERY_SEC
+ *
+ *          The power state is sampled every LIVENESS_POLICY_UPDATE_INTERVAL_MS.  When it
+ *          changes, WDMFeature re-establishes the service subscriptions so that the new
+ *          timeout takes effect.  Hysteresis on the low battery threshold keeps supply
+ *          voltage noise from causing repeated renegotiation.
+ *
+ *          tools/liveness_sim.py estimates the daily keep-alive message count of each
+ *          policy setting.
+ */
+
+#ifndef LIVENESS_POLICY_H
+#define LIVENESS_POLICY_H
+
+#include <stdint.h>
+
+#include "AppEvent.h"
+#include "app_config.h"
+
+#include "sdk_errors.h"
+
+class LivenessPolicy
+{
+public:
+    enum PowerState
+    {
+        kPowerState_External = 0,
+        kPowerState_Battery,
+        kPowerState_LowBattery,
+
+        kPowerState_Count
+    };
+
+    ret_code_t Init(void);
+
+    uint32_t GetLivenessTimeout(void) const;
+    PowerState GetPowerState(void) const;
+    uint32_t GetSupplyVoltage(void) const;
+
+    static const char * GetPowerStateName(PowerState aState);
+
+private:
+    friend LivenessPolicy & GetLivenessPolicy(void);
+
+    volatile PowerState mPowerState;
+    volatile uint32_t mSupplyMV;
+
+    bool Update(void);
+
+    static void TimerEventHandler(void * p_context);
+    static void UpdateEventHandler(AppEvent * aEvent);
+
+    static const uint32_t sLivenessTimeoutSec[kPowerState_Count];
+    static LivenessPolicy sLivenessPolicy;
+};
+
+inline LivenessPolicy & GetLivenessPolicy(void)
+{
+    return LivenessPolicy::sLivenessPolicy;
+}
+
+inline uint32_t LivenessPolicy::GetLivenessTimeout(void) const
+{
+    return sLivenessTimeoutSec[mPowerState];
+}
+
+inline LivenessPolicy::PowerState LivenessPolicy::GetPowerState(void) const
+{
+    return mPowerState;
+}
+
+inline uint32_t LivenessPolicy::GetSupplyVoltage(void) const
+{
+    return mSupplyMV;
+}
+
+#endif // LIVENESS_POLICY_H
@@ -0,0 +1,45 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Boot-time benchmark of the cost of logging.
+ *
+ *          When LOG_BENCHMARK_ENABLED is set, RunLogBenchmark() measures (with the DWT
+ *          cycle counter) the average number of CPU cycles spent in the calling context by
+ *          a log call with numeric arguments and by a log call with a pushed string, and
+ *          the cycles spent processing each entry.  With NRF_LOG_DEFERRED disabled entries
+ *          are processed within the call itself.  Comparing the results of builds with
+ *          LOG_FORMAT=text and LOG_FORMAT=binary, and with NRF_LOG_DEFERRED set to 0 and 1,
+ *          shows the cost of each logging configuration.
+ */
+
+#ifndef LOG_BENCHMARK_H
+#define LOG_BENCHMARK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void RunLogBenchmark(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOG_BENCHMARK_H
@@ -0,0 +1,73 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Demand monitoring for the nRF5 SDK mem_manager block pools.
+ *
+ *          The application is linked with -Wl,--wrap for nrf_malloc(), nrf_calloc(),
+ *          nrf_realloc() and nrf_free().  For each of the configured size classes
+ *          (MEMORY_MANAGER_*_BLOCK_SIZE/COUNT in app_config.h) the wrappers record
+ *          demand and pool occupancy separately.  Demand (requests, peak demand, the
+ *          largest request size and failed requests) is charged to the smallest class a
+ *          request fits in.  Occupancy is charged to the pool that actually served the
+ *          request, found from the block address, since mem_manager falls back to a
+ *          larger pool when the best-fit pool is empty.
+ *
+ *          When MEM_MANAGER_MONITOR_TRACE is enabled every request is also logged, in
+ *          a form that can be fed to tools/mem_pool_sizing.py.
+ */
+
+#ifndef MEM_MANAGER_MONITOR_H
+#define MEM_MANAGER_MONITOR_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum
+{
+    kMemManagerClassCount = 3,
+};
+
+typedef struct
+{
+    uint32_t BlockSize;
+    uint32_t BlockCount;
+    uint32_t Outstanding;       // Blocks currently allocated from this pool.
+    uint32_t PeakOutstanding;   // High-water mark of Outstanding.
+    uint32_t Demand;            // Live requests whose size maps to this class, from any pool.
+    uint32_t PeakDemand;        // High-water mark of Demand, including failed requests.
+    uint32_t MaxRequestSize;    // Largest request attributed to this class.
+    uint32_t RequestCount;
+    uint32_t FailCount;
+    uint32_t FallbackCount;     // Requests of this class served from a larger pool.
+} MemManagerClassStats;
+
+void GetMemManagerClassStats(uint8_t classIndex, MemManagerClassStats * stats);
+
+// Recommended number of blocks for a class, based on the demand observed since boot.
+uint32_t GetMemManagerRecommendedBlockCount(const MemManagerClassStats * stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MEM_MANAGER_MONITOR_H
@@ -0,0 +1,102 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          An incremental SHA-256 hash whose intermediate state can be saved to,
+ *          and later restored from, persistent storage.
+ *
+ *          Unlike nl::Weave::Platform::Security::SHA256, which keeps its context
+ *          private, this class exposes the running hash state as an opaque blob so
+ *          that a long-running computation (e.g. over a software update image) can
+ *          survive a reset.
+ *
+ *          The hash is computed in software by mbedTLS, or by the nRF52840 CryptoCell
+ *          (CC310) when the application is built with CRYPTO_BACKEND=cc310.  Saved state
+ *          is tagged with the backend and a format version, so that state written by a
+ *          build with a different backend or context layout is rejected on restore
+ *          rather than silently producing a wrong hash.
+ */
+
+#ifndef PERSISTENT_SHA256_H
+#define PERSISTENT_SHA256_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <Weave/DeviceLayer/WeaveDeviceLayer.h>
+
+#include "app_config.h"
+
+#if APP_CRYPTO_BACKEND_CC310
+#include "nrf_crypto_hash.h"
+#else
+#include <mbedtls/sha256.h>
+#endif
+
+class PersistentSHA256
+{
+#if APP_CRYPTO_BACKEND_CC310
+    typedef nrf_crypto_hash_context_t Context;
+#else
+    typedef mbedtls_sha256_context Context;
+#endif
+
+    struct StateHeader
+    {
+        uint8_t Backend;
+        uint8_t Version;
+        uint16_t ContextLen;
+    };
+
+public:
+    enum
+    {
+        kHashLength  = 32,
+        kStateLength = sizeof(StateHeader) + sizeof(Context),
+    };
+
+    PersistentSHA256(void);
+
+    void Begin(void);
+    void AddData(const uint8_t * aData, uint32_t aDataLen);
+    void Finish(uint8_t * aHashBuf);
+
+    // Copies the intermediate hash state into aStateBuf, which must be kStateLength bytes.
+    // Fails if no hash is in progress.
+    WEAVE_ERROR SaveState(uint8_t * aStateBuf) const;
+
+    // Resumes hashing from a state previously captured with SaveState().  Fails, leaving
+    // no hash in progress, if the state was saved by a different backend or format.
+    WEAVE_ERROR RestoreState(const uint8_t * aStateBuf);
+
+private:
+    enum
+    {
+        kBackend_Software = 1,
+        kBackend_CC310    = 2,
+
+        // Increment whenever the layout of the saved state changes.
+        kStateVersion = 1,
+    };
+
+    Context mCtx;
+    bool mActive;
+};
+
+#endif // PERSISTENT_SHA256_H
@@ -0,0 +1,120 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Fixed-block pool allocators for short-lived mbedTLS allocations.
+ *
+ *          mbedTLS makes a large number of small, short-lived allocations during the
+ *          CASE key exchange (primarily bignum limb arrays and ECP points).  Serving these
+ *          from a handful of size-class pools keeps them out of the system heap, which
+ *          reduces heap fragmentation and avoids taking the heap lock on every call.
+ *
+ *          Each pool keeps its free blocks on a lock-free singly-linked list (LDREX/STREX
+ *          compare-and-swap on a tagged list head), so allocation and release are O(1)
+ *          and never mask interrupts.  Requests that are larger than the largest class,
+ *          or that arrive when the matching pools are exhausted, fall back to the heap.
+ */
+
+#ifndef POOL_ALLOCATOR_H
+#define POOL_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+class BlockPool
+{
+public:
+    void Init(uint8_t * aStorage, uint16_t aBlockSize, uint16_t aBlockCount);
+
+    void * Alloc(void);
+    void Free(void * aBlock);
+    bool Contains(const void * aPtr) const;
+
+    uint16_t GetBlockSize(void) const { return mBlockSize; }
+    uint16_t GetBlockCount(void) const { return mBlockCount; }
+    uint16_t GetInUse(void) const { return mInUse; }
+    uint16_t GetPeakInUse(void) const { return mPeakInUse; }
+    uint32_t GetExhaustedCount(void) const { return mExhaustedCount; }
+
+private:
+    enum
+    {
+        kEndOfList = 0xFFFF,
+    };
+
+    uint8_t * mStorage;
+    volatile uint32_t mHead; // Index of the first free block in the low 16 bits; ABA tag in the high 16 bits.
+    uint16_t mBlockSize;
+    uint16_t mBlockCount;
+    volatile uint16_t mInUse;
+    volatile uint16_t mPeakInUse;
+    volatile uint32_t mExhaustedCount;
+
+    volatile uint16_t & Link(uint16_t aIndex) const;
+};
+
+class PoolAllocator
+{
+public:
+    enum
+    {
+        kPoolCount = 3,
+    };
+
+    void Init(void);
+
+    const BlockPool & GetPool(uint8_t aPool) const;
+    uint32_t GetHeapFallbackCount(void) const;
+
+    // calloc()/free() compatible entry points, suitable for mbedtls_platform_set_calloc_free().
+    static void * Calloc(size_t aCount, size_t aSize);
+    static void Free(void * aPtr);
+
+private:
+    friend PoolAllocator & GetPoolAllocator(void);
+
+    BlockPool mPools[kPoolCount];
+    volatile uint32_t mHeapFallbackCount;
+
+    static PoolAllocator sPoolAllocator;
+};
+
+inline PoolAllocator & GetPoolAllocator(void)
+{
+    return PoolAllocator::sPoolAllocator;
+}
+
+inline const BlockPool & PoolAllocator::GetPool(uint8_t aPool) const
+{
+    return mPools[aPool];
+}
+
+inline uint32_t PoolAllocator::GetHeapFallbackCount(void) const
+{
+    return mHeapFallbackCount;
+}
+
+inline bool BlockPool::Contains(const void * aPtr) const
+{
+    const uint8_t * p = static_cast<const uint8_t *>(aPtr);
+    return p >= mStorage && p < mStorage + static_cast<uint32_t>(mBlockSize) * mBlockCount;
+}
+
+#endif // POOL_ALLOCATOR_H
@@ -0,0 +1,57 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Power source detection and supply voltage measurement.
+ *
+ *          The power source is read from the USB regulator status: the device is taken to
+ *          be externally powered whenever VBUS is present, and battery powered otherwise.
+ *
+ *          The supply voltage is measured with a single blocking SAADC conversion of the
+ *          internal VDD input, or of VDDH/5 when the chip is supplied through VDDH (high
+ *          voltage mode), in which case VDD is regulated and says nothing about the
+ *          battery.  The conversion takes a few tens of microseconds and must not be
+ *          issued concurrently from more than one task.
+ */
+
+#ifndef POWER_MONITOR_H
+#define POWER_MONITOR_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    kPowerSource_Battery = 0,
+    kPowerSource_External,
+} PowerSource;
+
+PowerSource GetPowerSource(void);
+
+// Returns the supply (battery) voltage in millivolts.
+uint32_t MeasureSupplyVoltage(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // POWER_MONITOR_H
@@ -0,0 +1,85 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Round trip time estimation for WRM retransmission timeouts.
+ *
+ *          Implements the smoothed RTT / RTT variance estimator of RFC 6298: each sample R
+ *          updates
+ *
+ *              RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|
+ *              SRTT   = 7/8 SRTT + 1/8 R
+ *
+ *          (the first sample sets SRTT = R, RTTVAR = R/2), and the retransmission timeout
+ *          is SRTT + 4 RTTVAR, clamped to [aMinTimeoutMS, aMaxTimeoutMS].  Until the
+ *          first sample arrives the initial timeout is used.  SRTT and RTTVAR are held
+ *          in fixed point, scaled by 8 and 4 respectively.
+ *
+ *          Samples should only be taken from exchanges whose request was not
+ *          retransmitted (Karn's algorithm), since the response to a retransmitted
+ *          request cannot be attributed to a particular transmission.
+ */
+
+#ifndef RTT_ESTIMATOR_H
+#define RTT_ESTIMATOR_H
+
+#include <stdint.h>
+
+class RTTEstimator
+{
+public:
+    void Init(uint32_t aInitialTimeoutMS, uint32_t aMinTimeoutMS, uint32_t aMaxTimeoutMS);
+
+    void AddSample(uint32_t aRTTMS);
+
+    uint32_t GetRetransTimeout(void) const;
+    uint32_t GetSmoothedRTT(void) const;
+    uint32_t GetRTTVariance(void) const;
+    uint32_t GetSampleCount(void) const;
+
+private:
+    uint32_t mScaledSRTT;   // SRTT * 8, in ms.
+    uint32_t mScaledRTTVar; // RTTVAR * 4, in ms.
+    uint32_t mTimeoutMS;
+    uint32_t mMinTimeoutMS;
+    uint32_t mMaxTimeoutMS;
+    uint32_t mSampleCount;
+};
+
+inline uint32_t RTTEstimator::GetRetransTimeout(void) const
+{
+    return mTimeoutMS;
+}
+
+inline uint32_t RTTEstimator::GetSmoothedRTT(void) const
+{
+    return mScaledSRTT >> 3;
+}
+
+inline uint32_t RTTEstimator::GetRTTVariance(void) const
+{
+    return mScaledRTTVar >> 2;
+}
+
+inline uint32_t RTTEstimator::GetSampleCount(void) const
+{
+    return mSampleCount;
+}
+
+#endif // RTT_ESTIMATOR_H
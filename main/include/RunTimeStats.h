@@ -0,0 +1,76 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          FreeRTOS run-time statistics support.
+ *
+ *          When RUN_TIME_STATS_ENABLED is set (the default for development builds),
+ *          FreeRTOS accounts the time each task spends running using a microsecond
+ *          counter derived from the DWT cycle counter.  The cycle counter only advances
+ *          while the CPU is clocked, so the figures describe CPU time: time the device
+ *          spends asleep in tickless idle is not attributed to any task.
+ *
+ *          In addition, each time a task is switched in, a per-task wakeup counter is
+ *          incremented (via the traceTASK_SWITCHED_IN hook).  Tasks are assigned a
+ *          counter slot the first time they run, which is stored in the task's
+ *          uxTaskNumber field.
+ *
+ *          GetTaskRunTimeStats() reports CPU usage and wakeups for each task over the
+ *          interval since it was last called.
+ */
+
+#ifndef RUN_TIME_STATS_H
+#define RUN_TIME_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    const char * Name;          // Task name; points into the task control block.
+    uint32_t RunTimeUS;         // CPU time used by the task during the interval, in microseconds.
+    uint32_t CPUPermille;       // Share of the CPU time used during the interval, in 1/1000ths.
+    uint32_t Wakeups;           // Number of times the task was switched in during the interval.
+} TaskRunTimeStats;
+
+typedef struct
+{
+    uint32_t IntervalMS;        // Wall clock length of the interval.
+    uint32_t CPUTimeUS;         // Total CPU time (all tasks, including idle) during the interval.
+    uint32_t DutyCyclePermille; // Share of the interval the CPU was running, in 1/1000ths.
+} RunTimeSummary;
+
+// Fills in the run-time statistics of up to maxTasks tasks for the interval since the previous
+// call and returns the number of entries written.  summary may be NULL.
+size_t GetTaskRunTimeStats(TaskRunTimeStats * stats, size_t maxTasks, RunTimeSummary * summary);
+
+// FreeRTOS hooks (see FreeRTOSConfig.h).
+void ConfigureRunTimeStatsTimer(void);
+uint32_t GetRunTimeCounterValue(void);
+uint32_t RunTimeStatsTaskSwitchedIn(uint32_t taskNumber);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RUN_TIME_STATS_H
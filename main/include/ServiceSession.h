@@ -0,0 +1,98 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Pre-establishment of the shared CASE session with the service.
+ *
+ *          Service bindings use the shared CASE session, which is kept in the fabric
+ *          state only for as long as some binding holds it.  When the subscription
+ *          bindings are reset (after a Thread reattach, or a subscription failure) the
+ *          session can be released, and the next exchange with the service pays for a
+ *          full CASE handshake, on software crypto, before it can proceed.
+ *
+ *          ServiceSession holds an anchor binding on the shared session, so that the
+ *          session survives the subscriptions being torn down and re-established.  The
+ *          anchor binding is prepared as soon as service connectivity is available,
+ *          rather than on first use, and is re-prepared whenever connectivity returns
+ *          after the session has been lost.
+ *
+ *          The time from service connectivity to a ready session is recorded, to compare
+ *          reconnects with and without SERVICE_SESSION_PREESTABLISH.
+ */
+
+#ifndef SERVICE_SESSION_H
+#define SERVICE_SESSION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <Weave/DeviceLayer/WeaveDeviceLayer.h>
+
+/**
+ * Counters describing the shared CASE session with the service.
+ */
+struct ServiceSessionStats
+{
+    uint32_t Established;  // Times the anchor binding became ready.
+    uint32_t Failed;       // Failed preparations or lost sessions.
+    uint32_t LastSetupMS;  // Time from service connectivity to a ready session, for the last reconnect.
+    uint32_t MaxSetupMS;   // Longest such time.
+};
+
+class ServiceSession
+{
+public:
+    WEAVE_ERROR Init(void);
+
+    bool IsReady(void) const;
+    void GetStats(ServiceSessionStats & aStats) const;
+
+private:
+    friend ServiceSession & GetServiceSession(void);
+
+    nl::Weave::Binding * mBinding;
+    uint64_t mConnectivityMS; // When service connectivity was gained; 0 once the session is ready.
+    ServiceSessionStats mStats;
+
+    void Prepare(void);
+
+    static void PlatformEventHandler(const ::nl::Weave::DeviceLayer::WeaveDeviceEvent * event, intptr_t arg);
+    static void HandleBindingEvent(void * appState, ::nl::Weave::Binding::EventType eventType,
+                                   const ::nl::Weave::Binding::InEventParam & inParam,
+                                   ::nl::Weave::Binding::OutEventParam & outParam);
+
+    static ServiceSession sServiceSession;
+};
+
+inline ServiceSession & GetServiceSession(void)
+{
+    return ServiceSession::sServiceSession;
+}
+
+inline bool ServiceSession::IsReady(void) const
+{
+    return mBinding != NULL && mBinding->IsReady();
+}
+
+inline void ServiceSession::GetStats(ServiceSessionStats & aStats) const
+{
+    aStats = mStats;
+}
+
+#endif // SERVICE_SESSION_H
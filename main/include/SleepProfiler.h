@@ -0,0 +1,88 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Sleep residency profiling for FreeRTOS tickless idle.
+ *
+ *          The sleep profiler is invoked from the configPRE_SLEEP_PROCESSING and
+ *          configPOST_SLEEP_PROCESSING hooks of vPortSuppressTicksAndSleep().  For every
+ *          period the CPU actually sleeps it records the sleep duration (measured on the
+ *          RTC that drives the FreeRTOS tick) in a log2 histogram, and classifies what
+ *          woke the device by inspecting the pending interrupts on wakeup:
+ *
+ *            Tick   - the FreeRTOS tick RTC, i.e. a task timeout or software timer
+ *                     expiry (this includes the application event queue poll and
+ *                     app_timer timers).
+ *            Timer  - another RTC or TIMER peripheral (e.g. the OpenThread alarm).
+ *            Radio  - the radio, or a SoftDevice event.
+ *            GPIO   - a GPIOTE event (buttons).
+ *            Other  - any other interrupt.
+ *
+ *          The profile accumulates from boot (or the last reset of the profile) and can
+ *          be read at any time with GetSleepProfile().
+ */
+
+#ifndef SLEEP_PROFILER_H
+#define SLEEP_PROFILER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum
+{
+    kSleepHistogramBuckets = 12, // Bucket n counts sleeps of [2^n, 2^(n+1)) ticks; the last bucket is open-ended.
+};
+
+typedef enum
+{
+    kWakeReason_Tick = 0,
+    kWakeReason_Timer,
+    kWakeReason_Radio,
+    kWakeReason_GPIO,
+    kWakeReason_Other,
+
+    kWakeReason_Count
+} WakeReason;
+
+typedef struct
+{
+    uint32_t SleepCount;                                // Number of periods spent asleep.
+    uint32_t SleepTicks;                                // Total time spent asleep, in RTOS ticks.
+    uint32_t BucketCount[kSleepHistogramBuckets];       // Number of sleeps per duration bucket.
+    uint32_t BucketTicks[kSleepHistogramBuckets];       // Time spent asleep per duration bucket.
+    uint32_t WakeCount[kWakeReason_Count];              // Number of wakeups per reason.
+} SleepProfile;
+
+void GetSleepProfile(SleepProfile * profile);
+void ResetSleepProfile(void);
+
+const char * GetWakeReasonName(WakeReason reason);
+
+// FreeRTOS hooks (see FreeRTOSConfig.h).  Called with interrupts disabled.
+void SleepProfilerPreSleep(void);
+void SleepProfilerPostSleep(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SLEEP_PROFILER_H
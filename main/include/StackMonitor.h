@@ -0,0 +1,61 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Stack usage monitoring for FreeRTOS tasks.
+ *
+ *          FreeRTOS fills each task stack with a known value when the task is created
+ *          (configUSE_TRACE_FACILITY), so the deepest point reached by a task can be
+ *          determined at any time by scanning for the first overwritten word.  The
+ *          monitor samples this high-water mark for every task in the system, along
+ *          with the allocated stack size (recorded by configRECORD_STACK_HIGH_ADDRESS),
+ *          and recommends a stack size for each task based on the usage observed since
+ *          boot.  The recommendations are meant to be aggregated over a representative
+ *          set of runs with tools/stack_sizing.py before stack sizes are changed.
+ *
+ *          In development builds configCHECK_FOR_STACK_OVERFLOW is set to 2, and
+ *          vApplicationStackOverflowHook() reports the offending task before halting.
+ */
+
+#ifndef STACK_MONITOR_H
+#define STACK_MONITOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    const char * Name;          // Task name; points into the task control block.
+    uint32_t StackSize;         // Allocated stack size, in bytes.
+    uint32_t PeakUsed;          // Deepest stack usage observed since the task was created, in bytes.
+    uint32_t Recommended;       // Recommended stack size, in bytes.
+} TaskStackStats;
+
+// Fills in the stack statistics for up to maxTasks tasks and returns the number of entries written.
+size_t GetTaskStackStats(TaskStackStats * stats, size_t maxTasks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STACK_MONITOR_H
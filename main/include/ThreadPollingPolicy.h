@@ -0,0 +1,131 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Adaptive Thread polling policy for the sleepy end device.
+ *
+ *          As a sleepy end device the lock only receives messages when it polls its
+ *          parent, so the polling interval trades command latency against energy.  The
+ *          policy selects the interval from what the application is currently doing:
+ *
+ *          - While an activity that expects downlink traffic is in flight (a lock command
+ *            exchange, service subscription setup or a software update download), the
+ *            device polls at the fast interval configured for that activity.  Activities
+ *            linger briefly after they end, to catch follow-up messages, and lapse
+ *            automatically after a maximum duration should their end never be signalled.
+ *
+ *          - When idle, the inactive polling interval backs off exponentially from
+ *            THREAD_INACTIVE_POLLING_INTERVAL_MS up to THREAD_POLLING_MAX_INACTIVE_INTERVAL_MS.
+ *
+ *          - Backoff is suspended during learned user-activity windows.  The day is divided
+ *            into THREAD_POLLING_WINDOW_COUNT windows, each with a score that is raised
+ *            whenever the user operates the lock in that window and decays daily, so that
+ *            times at which the lock is habitually used are served with a short interval.
+ *            The device has no wall clock, so windows are aligned to the time since boot.
+ *
+ *          The policy is applied via ConnectivityMgr().SetThreadPollingConfig() from the
+ *          context of the application task.  The activity methods may be called from any
+ *          task.  Rather than re-evaluating periodically, the policy arms a one-shot timer
+ *          for the next activity deadline, backoff step or window boundary.
+ *
+ *          tools/polling_sim.py models the same policy, to compare its average current and
+ *          command latency against other settings for recorded traffic traces.
+ */
+
+#ifndef THREAD_POLLING_POLICY_H
+#define THREAD_POLLING_POLICY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "AppEvent.h"
+#include "app_config.h"
+
+#include "sdk_errors.h"
+
+class ThreadPollingPolicy
+{
+public:
+    enum Activity
+    {
+        kActivity_LockCommand = 0,
+        kActivity_SubscriptionSetup,
+        kActivity_SoftwareUpdate,
+
+        kActivity_Count
+    };
+
+    ret_code_t Init(void);
+
+    void BeginActivity(Activity aActivity);
+    void EndActivity(Activity aActivity);
+    void RecordUserActivity(void);
+
+    uint32_t GetActivePollingInterval(void) const;
+    uint32_t GetInactivePollingInterval(void) const;
+
+private:
+    friend ThreadPollingPolicy & GetThreadPollingPolicy(void);
+
+    struct ActivityConfig
+    {
+        uint32_t PollingIntervalMS;   // Polling interval while the activity is in flight.
+        uint32_t LingerMS;            // Time to keep polling fast after the activity ends.
+        uint32_t MaxDurationMS;       // Time after which the activity lapses if not ended (0 = never).
+    };
+
+    uint64_t mDeadlineMS[kActivity_Count]; // Time at which each activity lapses (0 = never).
+    uint64_t mIdleSinceMS;
+    uint32_t mActivePollingIntervalMS;
+    uint32_t mInactivePollingIntervalMS;
+    uint8_t mActivityMask;
+    uint8_t mCurrentWindow;
+    uint8_t mWindowScore[THREAD_POLLING_WINDOW_COUNT];
+    volatile bool mUpdatePending;
+
+    void RequestUpdate(void);
+    void Update(void);
+    void ScheduleUpdate(uint64_t aNowMS, uint8_t aActivityMask, uint64_t aIdleSinceMS, uint32_t aInactiveIntervalMS);
+    void UpdateWindow(uint64_t aNowMS);
+    bool IsInActivityWindow(void) const;
+
+    static uint8_t GetWindow(uint64_t aNowMS);
+    static void TimerEventHandler(void * p_context);
+    static void UpdateEventHandler(AppEvent * aEvent);
+
+    static const ActivityConfig sActivityConfig[kActivity_Count];
+    static ThreadPollingPolicy sThreadPollingPolicy;
+};
+
+inline ThreadPollingPolicy & GetThreadPollingPolicy(void)
+{
+    return ThreadPollingPolicy::sThreadPollingPolicy;
+}
+
+inline uint32_t ThreadPollingPolicy::GetActivePollingInterval(void) const
+{
+    return mActivePollingIntervalMS;
+}
+
+inline uint32_t ThreadPollingPolicy::GetInactivePollingInterval(void) const
+{
+    return mInactivePollingIntervalMS;
+}
+
+#endif // THREAD_POLLING_POLICY_H
@@ -26,9 +26,18 @@
 #include "traits/include/DeviceIdentityTraitDataSource.h"
 #include "traits/include/BoltLockSettingsTraitDataSink.h"
 
+#include "app_config.h"
+#include "RTTEstimator.h"
+
 #include "FreeRTOS.h"
 #include "semphr.h"
 
+/**
+ * Service endpoint of the core Weave data management protocol.  Service bindings target it,
+ * and service-originated WDM messages carry it as their source node id.
+ */
+const uint64_t kServiceEndpoint_Data_Management = 0x18B4300200000003ull;
+
 class PublisherLock : public nl::Weave::Profiles::DataManagement::IWeavePublisherLock
 {
 public:
@@ -43,6 +52,31 @@ public:
 
 private:
     SemaphoreHandle_t mRecursiveLock;
+#if configSUPPORT_STATIC_ALLOCATION
+    StaticSemaphore_t mRecursiveLockStruct;
+#endif
+};
+
+/**
+ * Counts of how trait changes reached (or were held back from) the service.
+ */
+struct PublishStats
+{
+    uint32_t Immediate;        // Changes delivered by the established service counter-subscription.
+    uint32_t Deferred;         // Changes made while the counter-subscription was down.
+    uint32_t Recovered;        // Counter-subscriptions established with deferred changes outstanding.
+    uint32_t ResubscribeKicks; // Times a deferred change cut the resubscribe backoff short.
+    uint32_t MaxRecoveryMS;    // Longest time from the first deferred change to its delivery.
+};
+
+/**
+ * WRM acknowledgments of commands received from the service, classified by the state of the
+ * command exchange when the response (or error) was sent.
+ */
+struct AckStats
+{
+    uint32_t Piggybacked; // The ack was still pending, and rode on the response.
+    uint32_t Standalone;  // WRM had already sent the ack on its own.
 };
 
 class WDMFeature
@@ -61,40 +95,48 @@ public:
     WEAVE_ERROR Init(void);
     void ProcessTraitChanges(void);
     void TearDownSubscriptions(void);
+    void RenegotiateLiveness(void);
 
     bool AreServiceSubscriptionsEstablished(void);
+    void GetPublishStats(PublishStats & aStats) const;
 
-    BoltLockTraitDataSource & GetBoltLockTraitDataSource(void);
-
-    nl::Weave::Profiles::DataManagement::SubscriptionEngine mSubscriptionEngine;
+    const RTTEstimator & GetServiceRTT(void) const;
 
-private:
-    friend WDMFeature & WdmFeature(void);
+    void UpdatePiggybackAckTimeout(void);
+    void RecordCommandAck(const nl::Weave::ExchangeContext * aEC);
+    void GetAckStats(AckStats & aStats) const;
+    uint32_t GetAppliedPiggybackAckTimeout(void) const;
 
-    enum SourceTraitHandle
-    {
-        kSourceHandle_BoltLockTrait = 0,
-        kSourceHandle_DeviceIdentityTrait,
+    nl::Weave::WRMPConfig GetServiceWRMPConfig(void) const;
+    uint32_t GetServiceResponseTimeout(void) const;
 
-        kSourceHandle_Max
-    };
+    BoltLockTraitDataSource & GetBoltLockTraitDataSource(uint8_t aActuator);
 
-    enum SinkTraitHandle
-    {
-        kSinkHandle_BoltLockSettingsTrait = 0,
+    nl::Weave::Profiles::DataManagement::SubscriptionEngine mSubscriptionEngine;
 
-        kSinkHandle_Max
-    };
+private:
+    friend WDMFeature & WdmFeature(void);
 
     // Published Traits
-    BoltLockTraitDataSource mBoltLockTraitSource;
+    BoltLockTraitDataSource mBoltLockTraitSources[BOLT_LOCK_ACTUATOR_COUNT];
     DeviceIdentityTraitDataSource mDeviceIdentityTraitSource;
 
     // Subscribed Traits
     BoltLockSettingsTraitDataSink mBoltLockSettingsTraitSink;
 
+    uint32_t GetPiggybackAckTimeout(void) const;
+    void ApplyServiceWRMPConfig(void);
+
+    WEAVE_ERROR RegisterSourceTrait(TraitDataSource * aSource, uint64_t aInstanceId);
+    WEAVE_ERROR RegisterSinkTrait(TraitDataSink * aSink, uint64_t aInstanceId);
+
     void InitiateSubscriptionToService(void);
+    void ProbeServiceRTT(void);
+    void AddServiceRTTSample(uint32_t aRTTMS);
     static void AsyncProcessChanges(intptr_t arg);
+    static void AsyncRenegotiateLiveness(intptr_t arg);
+    static void HandleRTTProbeAck(nl::Weave::ExchangeContext * aEC, void * aMsgCtxt);
+    static void HandleRTTProbeSendError(nl::Weave::ExchangeContext * aEC, WEAVE_ERROR aErr, void * aMsgCtxt);
 
     static void PlatformEventHandler(const ::nl::Weave::DeviceLayer::WeaveDeviceEvent * event, intptr_t arg);
     static void HandleSubscriptionEngineEvent(void * appState, SubscriptionEngine::EventID eventType,
@@ -111,15 +153,19 @@ private:
                                                SubscriptionHandler::OutEventParam & outParam);
 
     // Sink Catalog
-    nl::Weave::Profiles::DataManagement::SingleResourceSinkTraitCatalog::CatalogItem mServiceSinkCatalogStore[kSinkHandle_Max];
+    nl::Weave::Profiles::DataManagement::SingleResourceSinkTraitCatalog::CatalogItem mServiceSinkCatalogStore[WDM_MAX_SINK_TRAITS];
     nl::Weave::Profiles::DataManagement::SingleResourceSinkTraitCatalog mServiceSinkTraitCatalog;
 
     // Source Catalog
     nl::Weave::Profiles::DataManagement::SingleResourceSourceTraitCatalog mServiceSourceTraitCatalog;
     nl::Weave::Profiles::DataManagement::SingleResourceSourceTraitCatalog::CatalogItem
-        mServiceSourceCatalogStore[kSourceHandle_Max];
+        mServiceSourceCatalogStore[WDM_MAX_SOURCE_TRAITS];
 
-    nl::Weave::Profiles::DataManagement::TraitPath mServiceSinkTraitPaths[kSinkHandle_Max];
+    nl::Weave::Profiles::DataManagement::TraitPath mServiceSinkTraitPaths[WDM_MAX_SINK_TRAITS];
+
+    // Number of registered traits; also the trait data handle of the next trait to be registered.
+    uint8_t mSourceTraitCount;
+    uint8_t mSinkTraitCount;
 
     // Subscription Clients
     nl::Weave::Profiles::DataManagement::SubscriptionClient * mServiceSubClient;
@@ -133,6 +179,17 @@ private:
     static WDMFeature sWDMfeature;
     PublisherLock mPublisherLock;
 
+    PublishStats mPublishStats;
+    AckStats mAckStats;
+    RTTEstimator mServiceRTT;
+    uint32_t mAppliedRetransTimeoutMS;      // Retransmission timeout currently configured on the service bindings.
+    uint32_t mAppliedPiggybackAckTimeoutMS; // Piggyback ack timeout currently configured on the service bindings.
+    uint64_t mRTTProbeSentMS;               // Time the last round trip probe was sent; 0 if none.
+    uint32_t mRTTProbeRetransTimeoutMS;     // Retransmission timeout in effect when the probe was sent.
+    nl::Weave::ExchangeContext * mRTTProbeEC; // Exchange of the outstanding round trip probe; NULL if none.
+    uint8_t mRTTProbeFailures;              // Consecutive round trip probes left unacknowledged.
+    uint64_t mFirstDeferredChangeMS; // 0 if no change is waiting for the counter-subscription.
+
     bool mIsSubToServiceEstablished;
     bool mIsServiceCounterSubEstablished;
     bool mIsSubToServiceActivated;
@@ -143,9 +200,29 @@ inline WDMFeature & WdmFeature(void)
     return WDMFeature::sWDMfeature;
 }
 
-inline BoltLockTraitDataSource & WDMFeature::GetBoltLockTraitDataSource(void)
+inline void WDMFeature::GetPublishStats(PublishStats & aStats) const
+{
+    aStats = mPublishStats;
+}
+
+inline const RTTEstimator & WDMFeature::GetServiceRTT(void) const
+{
+    return mServiceRTT;
+}
+
+inline void WDMFeature::GetAckStats(AckStats & aStats) const
+{
+    aStats = mAckStats;
+}
+
+inline uint32_t WDMFeature::GetAppliedPiggybackAckTimeout(void) const
+{
+    return mAppliedPiggybackAckTimeoutMS;
+}
+
+inline BoltLockTraitDataSource & WDMFeature::GetBoltLockTraitDataSource(uint8_t aActuator)
 {
-    return mBoltLockTraitSource;
+    return mBoltLockTraitSources[aActuator];
 }
 
 #endif // WDM_FEATURE_H
@@ -125,6 +125,18 @@
  */
 #define WEAVE_CONFIG_MAX_BINDINGS 8
 
+/**
+ * WEAVE_CONFIG_WRMP_DEFAULT_ACK_TIMEOUT
+ *
+ * Time, in milliseconds, a WRM ack is held back waiting for a message to piggyback on, on
+ * exchanges that use the default WRMP configuration.  These include the unsolicited exchanges
+ * on which commands arrive from the service, which do not pick up the configuration of the
+ * service bindings (see WDMFeature::GetPiggybackAckTimeout()).  Matches the boot-time
+ * inactive Thread polling interval (THREAD_INACTIVE_POLLING_INTERVAL_MS, 1 s), which is also
+ * the upper bound applied on the service bindings.
+ */
+#define WEAVE_CONFIG_WRMP_DEFAULT_ACK_TIMEOUT 1000
+
 /**
  * WEAVE_CONFIG_EVENT_LOGGING_WDM_OFFLOAD
  *
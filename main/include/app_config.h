@@ -29,10 +29,32 @@
 #define MEMORY_MANAGER_LARGE_BLOCK_COUNT 1
 #define MEMORY_MANAGER_LARGE_BLOCK_SIZE 1024
 
+// Log every mem_manager request for offline pool sizing (see tools/mem_pool_sizing.py).
+#ifndef MEM_MANAGER_MONITOR_TRACE
+#define MEM_MANAGER_MONITOR_TRACE 0
+#endif
+
 // ----- Crypto Config -----
 
+// APP_CRYPTO_BACKEND_CC310 is set by the CRYPTO_BACKEND make option.
+#if APP_CRYPTO_BACKEND_CC310
+
+#define NRF_CRYPTO_ENABLED 1
+#define NRF_CRYPTO_BACKEND_CC310_ENABLED 1
+#define NRF_CRYPTO_BACKEND_CC310_HASH_SHA256_ENABLED 1
+#define NRF_CRYPTO_BACKEND_CC310_INTERRUPTS_ENABLED 0
+
+#else // APP_CRYPTO_BACKEND_CC310
+
 #define NRF_CRYPTO_ENABLED 0
 
+#endif // APP_CRYPTO_BACKEND_CC310
+
+// Measure the cost of the crypto primitives at boot (see CryptoBenchmark.cpp).
+#ifndef CRYPTO_BENCHMARK_ENABLED
+#define CRYPTO_BENCHMARK_ENABLED 0
+#endif
+
 // ----- Soft Device Config -----
 
 #define SOFTDEVICE_PRESENT 1
@@ -59,12 +81,44 @@
 
 #define NRF_LOG_ENABLED 1
 #define NRF_LOG_DEFAULT_LEVEL 4
-#define NRF_LOG_DEFERRED 0
-#define NRF_LOG_STR_PUSH_BUFFER_SIZE 16
 #define NRF_LOG_USES_TIMESTAMP 1
 #define NRF_LOG_STR_FORMATTER_TIMESTAMP_FORMAT_ENABLED 0
 
-#define NRF_LOG_BACKEND_RTT_ENABLED 1
+// Log entries are queued by the caller and processed by the idle task (see
+// DeferredLogSupport.c), so logging does not format or write to the backend in the
+// calling context.  String arguments that do not outlive the call must be pushed into
+// the log buffer with NRF_LOG_PUSH.
+#ifndef NRF_LOG_DEFERRED
+#define NRF_LOG_DEFERRED 1
+#endif
+
+// The log buffer must hold the largest burst logged between two idle periods, which is
+// the Diagnostics report (up to about 1.5 KB of entries); further entries overwrite the
+// oldest ones.  Pushed strings are short error and ID strings.  Both sizes must be powers
+// of two.
+#define NRF_LOG_BUFSIZE 2048
+#define NRF_LOG_STR_PUSH_BUFFER_SIZE 256
+
+// Emit binary log records, decoded on the host, instead of formatted text (see
+// BinaryLogBackend.h).  Selected with the LOG_FORMAT build option.
+#ifndef BINARY_LOG_ENABLED
+#define BINARY_LOG_ENABLED 0
+#endif
+
+// Largest binary log record; longer records are truncated.
+#define BINARY_LOG_MAX_RECORD_SIZE 256
+
+// Measure the cost of logging at boot (see LogBenchmark.c).
+#ifndef LOG_BENCHMARK_ENABLED
+#define LOG_BENCHMARK_ENABLED 0
+#endif
+
+// Measure the formatting helpers against snprintf() at boot (see FormatBenchmark.cpp).
+#ifndef FORMAT_BENCHMARK_ENABLED
+#define FORMAT_BENCHMARK_ENABLED 0
+#endif
+
+#define NRF_LOG_BACKEND_RTT_ENABLED (!BINARY_LOG_ENABLED)
 #define NRF_LOG_BACKEND_UART_ENABLED 0
 
 #if NRF_LOG_BACKEND_UART_ENABLED
@@ -81,7 +135,7 @@
 
 #endif // NRF_LOG_BACKEND_UART_ENABLED
 
-#if NRF_LOG_BACKEND_RTT_ENABLED
+#if NRF_LOG_BACKEND_RTT_ENABLED || BINARY_LOG_ENABLED
 
 #define SEGGER_RTT_CONFIG_BUFFER_SIZE_UP 4096
 #define SEGGER_RTT_CONFIG_MAX_NUM_UP_BUFFERS 1
@@ -97,7 +151,7 @@
 #define NRF_LOG_BACKEND_RTT_TX_RETRY_DELAY_MS 1
 #define NRF_LOG_BACKEND_RTT_TX_RETRY_CNT 3
 
-#endif // NRF_LOG_BACKEND_RTT_ENABLED
+#endif // NRF_LOG_BACKEND_RTT_ENABLED || BINARY_LOG_ENABLED
 
 // ----- Misc Config -----
 
@@ -130,12 +184,145 @@
 // state to another.
 #define ACTUATOR_MOVEMENT_PERIOS_MS             2000
 
+// Number of bolt lock actuators (e.g. a deadbolt and latch pair) driven by the
+// device.  Each actuator is published as a separate BoltLockTrait instance, with
+// instance ids 0 to BOLT_LOCK_ACTUATOR_COUNT - 1.
+#ifndef BOLT_LOCK_ACTUATOR_COUNT
+#define BOLT_LOCK_ACTUATOR_COUNT                1
+#endif
+
+// Capacity of the WDM source (published) and sink (subscribed) trait catalogs.
+// Traits are registered with WDMFeature at init and assigned trait data handles
+// in registration order.
+#ifndef WDM_MAX_SOURCE_TRAITS
+#define WDM_MAX_SOURCE_TRAITS                   (BOLT_LOCK_ACTUATOR_COUNT + 1)
+#endif
+#ifndef WDM_MAX_SINK_TRAITS
+#define WDM_MAX_SINK_TRAITS                     1
+#endif
+
 // ---- Lock Example SWU Config ----
 #define SWU_INTERVAl_WINDOW_MIN_MS				(23*60*60*1000) // 23 hours
 #define SWU_INTERVAl_WINDOW_MAX_MS				(24*60*60*1000) // 24 hours
 
+// Number of image pages between persisted checkpoints of the image hash state.
+#define SWU_HASH_CHECKPOINT_INTERVAL_PAGES      8
+
+// Thread polling interval used while an image download is in progress.
+#define SWU_DOWNLOAD_POLLING_INTERVAL_MS        50
+
+// Minimum number of image bytes between download progress log messages.
+#define SWU_PROGRESS_LOG_INTERVAL_BYTES         (16*1024)
+
+// ---- Diagnostics Config ----
+
+// Interval between periodic diagnostics reports.
+#if BUILD_RELEASE
+#define DIAGNOSTICS_REPORT_INTERVAL_MS          (60*60*1000) // 1 hour
+#else
+#define DIAGNOSTICS_REPORT_INTERVAL_MS          (5*60*1000)  // 5 minutes
+#endif
+
+// Number of heap call sites included in each diagnostics report.
+#define DIAGNOSTICS_REPORT_MAX_CALL_SITES       4
+
+// Number of distinct allocation call sites tracked by the heap monitor.
+#define HEAP_MONITOR_MAX_CALL_SITES             24
+
+// Attribute each live heap allocation to its call site.  This adds an 8 byte tag
+// to every allocation, so it is only enabled for development builds by default.
+#ifndef HEAP_MONITOR_CALL_SITE_TAGS
+#define HEAP_MONITOR_CALL_SITE_TAGS             (!BUILD_RELEASE)
+#endif
+
+// Measure how long the heap lock is held (using the DWT cycle counter).
+#ifndef HEAP_LOCK_STATS_ENABLED
+#define HEAP_LOCK_STATS_ENABLED                 (!BUILD_RELEASE)
+#endif
+
+// Maximum number of tasks included in stack usage reports.
+#define STACK_MONITOR_MAX_TASKS                 10
+
+// Headroom added to the observed peak stack usage when recommending a stack size:
+// the larger of a percentage of the peak and a fixed number of bytes.
+#define STACK_MONITOR_HEADROOM_PERCENT          25
+#define STACK_MONITOR_MIN_HEADROOM_BYTES        256
+
+// Maximum number of tasks tracked by the run-time statistics (see RunTimeStats.h).
+#define RUN_TIME_STATS_MAX_TASKS                10
+
+// ---- mbedTLS Pool Allocator Config ----
+
+// Size classes used to serve mbedTLS allocations (see PoolAllocator.h).  The small and
+// medium classes hold bignum limb arrays for P-224/P-256 operands and products; the
+// large class holds ECP points and other per-operation contexts.
+#define POOL_ALLOCATOR_SMALL_BLOCK_SIZE         40
+#define POOL_ALLOCATOR_SMALL_BLOCK_COUNT        32
+#define POOL_ALLOCATOR_MEDIUM_BLOCK_SIZE        80
+#define POOL_ALLOCATOR_MEDIUM_BLOCK_COUNT       24
+#define POOL_ALLOCATOR_LARGE_BLOCK_SIZE         160
+#define POOL_ALLOCATOR_LARGE_BLOCK_COUNT        8
+
 // ---- Thread Polling Config ----
 #define THREAD_ACTIVE_POLLING_INTERVAL_MS       100
 #define THREAD_INACTIVE_POLLING_INTERVAL_MS     1000
 
+// Upper limit for the inactive polling interval when backing off while idle.  Messages
+// from the service wait in the parent for up to this long, so it must stay well within
+// the service's message response timeouts.
+#define THREAD_POLLING_MAX_INACTIVE_INTERVAL_MS 4000
+
+// Idle time after which the inactive polling interval is doubled.
+#define THREAD_POLLING_BACKOFF_STEP_MS          (60*1000)
+
+// Time to keep polling fast after a lock command or subscription setup ends, and the
+// time after which such an activity lapses if its end is never signalled.
+#define THREAD_POLLING_ACTIVITY_LINGER_MS       5000
+#define THREAD_POLLING_ACTIVITY_MAX_DURATION_MS (60*1000)
+
+// Learned user-activity windows: number of windows per day, score added for each lock
+// operation in a window, score at which a window is considered active, and the fraction
+// (1/n) of its score a window loses each day.
+#define THREAD_POLLING_WINDOW_COUNT             48
+#define THREAD_POLLING_WINDOW_SCORE_INCREMENT   64
+#define THREAD_POLLING_WINDOW_SCORE_THRESHOLD   96
+#define THREAD_POLLING_WINDOW_DECAY_DIVISOR     4
+
+// ---- Service Liveness Config ----
+
+// Service subscription liveness timeouts by power state (see LivenessPolicy.h).
+#define LIVENESS_TIMEOUT_EXTERNAL_POWER_SEC     60          // 1 minute
+#define LIVENESS_TIMEOUT_BATTERY_SEC            (15*60)     // 15 minutes
+#define LIVENESS_TIMEOUT_LOW_BATTERY_SEC        (60*60)     // 1 hour
+
+// Supply voltage below which the battery is considered low, and the margin above it
+// the voltage must recover by before the battery is considered good again.
+#define LIVENESS_LOW_BATTERY_MV                 2500
+#define LIVENESS_LOW_BATTERY_HYSTERESIS_MV      100
+
+// Interval at which the power state is sampled.
+#define LIVENESS_POLICY_UPDATE_INTERVAL_MS      (10*60*1000) // 10 minutes
+
+// ---- Service Session Config ----
+
+// Establish the shared CASE session with the service as soon as service connectivity is
+// available, and hold it across subscription resets (see ServiceSession.h).
+#ifndef SERVICE_SESSION_PREESTABLISH
+#define SERVICE_SESSION_PREESTABLISH            1
+#endif
+
+// ---- BLE Connection Config ----
+
+// Connection parameters requested while provisioning over WoBLE (see BLEConnectionPolicy.h).
+// The interval range follows the Apple accessory guidelines (min >= 15 ms, max >= min + 15 ms).
+#define BLE_CONN_FAST_MIN_INTERVAL_MS           15
+#define BLE_CONN_FAST_MAX_INTERVAL_MS           30
+#define BLE_CONN_FAST_SUPERVISION_TIMEOUT_MS    4000
+
+// Connection parameters requested once the device is provisioned.
+#define BLE_CONN_SLOW_MIN_INTERVAL_MS           100
+#define BLE_CONN_SLOW_MAX_INTERVAL_MS           200
+#define BLE_CONN_SLOW_SLAVE_LATENCY             4
+#define BLE_CONN_SLOW_SUPERVISION_TIMEOUT_MS    6000
+
 #endif //APP_CONFIG_H
@@ -72,5 +72,16 @@ const uint8_t FreeRTOSDebugConfig[] __attribute__((section(".rodata"))) =
     0 /* padding */
 };
 
+/*
+ * Returns the size of a task's stack, in words.  Used by the application stack
+ * monitor (see StackMonitor.h) to compute stack usage from the high-water mark.
+ */
+UBaseType_t uxTaskGetStackDepth(TaskHandle_t xTask)
+{
+    TCB_t * pxTCB = prvGetTCBFromHandle(xTask);
+
+    /* pxEndOfStack is recorded for stacks that grow down when configRECORD_STACK_HIGH_ADDRESS is set. */
+    return (UBaseType_t) (pxTCB->pxEndOfStack - pxTCB->pxStack) + 1;
+}
 
 #endif /* FREERTOS_TASKS_C_ADDITIONS_H */
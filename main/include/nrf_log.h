@@ -0,0 +1,37 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Wrapper header file for nrf_log.h supplied by the Nordic nRF5 SDK.
+ */
+
+
+
+// Include the version of nrf_log.h supplied by the nRF5 SDK.
+#include_next "nrf_log.h"
+
+// With deferred logging, string arguments are only read when the log entry is processed,
+// so strings that do not outlive the call (local buffers, or the shared buffer returned by
+// nl::ErrorStr()) must be copied into the log buffer with NRF_LOG_PUSH.  nrf_log_push()
+// takes a non-const pointer, although it does not modify the string; override the
+// NRF_LOG_PUSH define so that it also accepts const strings.
+#if NRF_LOG_ENABLED
+#undef NRF_LOG_PUSH
+#define NRF_LOG_PUSH(_str) NRF_LOG_INTERNAL_LOG_PUSH((char *) (_str))
+#endif // NRF_LOG_ENABLED
@@ -64,6 +64,11 @@ extern "C" {
 #include <Weave/DeviceLayer/internal/testing/SystemClockUnitTest.h>
 
 #include <AppTask.h>
+#include <BinaryLogBackend.h>
+#include <LogBenchmark.h>
+#include <CryptoBenchmark.h>
+#include <FormatBenchmark.h>
+#include <PoolAllocator.h>
 
 using namespace ::nl;
 using namespace ::nl::Inet;
@@ -163,7 +168,19 @@ int main(void)
     APP_ERROR_CHECK(ret);
 
     // Initialize logging backends
+#if BINARY_LOG_ENABLED
+    BinaryLogBackendInit();
+#else
     NRF_LOG_DEFAULT_BACKENDS_INIT();
+#endif
+
+#if LOG_BENCHMARK_ENABLED
+    RunLogBenchmark();
+#endif
+
+#if FORMAT_BENCHMARK_ENABLED
+    RunFormatBenchmark();
+#endif
 
 #endif
 
@@ -214,6 +231,10 @@ int main(void)
     }
 #endif
 
+#if CRYPTO_BENCHMARK_ENABLED
+    RunCryptoBenchmark();
+#endif
+
 #if defined(SOFTDEVICE_PRESENT) && SOFTDEVICE_PRESENT
 
     {
@@ -255,7 +276,7 @@ int main(void)
         APP_ERROR_HANDLER(ret);
     }
 
-    // Reconfigure mbedTLS to use regular calloc and free.
+    // Reconfigure mbedTLS to use the system heap.
     //
     // By default, OpenThread configures mbedTLS to use its private heap at initialization time.  However,
     // the OpenThread heap is not thread-safe, effectively preventing other threads from using mbedTLS
@@ -266,7 +287,11 @@ int main(void)
     // RTOS.  It also requires the heap to be provisioned with enough storage to accommodate OpenThread's
     // needs.
     //
-    mbedtls_platform_set_calloc_free(calloc, free);
+    // Small allocations are served from fixed-block pools, falling back to calloc and free for
+    // larger requests or when the pools are exhausted.
+    //
+    GetPoolAllocator().Init();
+    mbedtls_platform_set_calloc_free(PoolAllocator::Calloc, PoolAllocator::Free);
 
     // Configure device to operate as a Thread sleepy end-device.
     ret = ConnectivityMgr().SetThreadDeviceType(ConnectivityManager::kThreadDeviceType_SleepyEndDevice);
@@ -276,7 +301,8 @@ int main(void)
         APP_ERROR_HANDLER(ret);
     }
 
-    // Configure the Thread polling behavior for the device.
+    // Configure the initial Thread polling behavior for the device.  The ThreadPollingPolicy
+    // adjusts it once the app task is running.
     {
         ConnectivityManager::ThreadPollingConfig pollingConfig;
         pollingConfig.Clear();
@@ -0,0 +1,240 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Implementation of the binary nrf_log backend (see BinaryLogBackend.h).
+ */
+
+#include "BinaryLogBackend.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "nrf_assert.h"
+#include "nrf_log_backend_interface.h"
+#include "nrf_log_ctrl.h"
+#include "nrf_log_internal.h"
+#include "nrf_memobj.h"
+#include "SEGGER_RTT.h"
+
+#if BINARY_LOG_ENABLED
+
+enum
+{
+    kRecordMagic        = 0xB1,
+    kRecordType_Message = 1,
+    kRecordType_HexDump = 2,
+    kRecordHeaderLength = 4,
+    kRTTChannel         = 0,
+};
+
+typedef struct
+{
+    uint8_t * Buf;
+    uint16_t Length;
+    uint16_t Capacity;
+} RecordWriter;
+
+static void PutBytes(RecordWriter * writer, const void * data, uint16_t len)
+{
+    if (len > writer->Capacity - writer->Length)
+    {
+        len = writer->Capacity - writer->Length;
+    }
+    memcpy(writer->Buf + writer->Length, data, len);
+    writer->Length += len;
+}
+
+static void Put8(RecordWriter * writer, uint8_t value)
+{
+    PutBytes(writer, &value, sizeof(value));
+}
+
+static void Put16(RecordWriter * writer, uint16_t value)
+{
+    PutBytes(writer, &value, sizeof(value));
+}
+
+static void Put32(RecordWriter * writer, uint32_t value)
+{
+    PutBytes(writer, &value, sizeof(value));
+}
+
+static void PutString(RecordWriter * writer, const char * str)
+{
+    size_t len = (str != NULL) ? strlen(str) : 0;
+
+    if (len > UINT8_MAX)
+    {
+        len = UINT8_MAX;
+    }
+    Put8(writer, (uint8_t) len);
+    PutBytes(writer, str, (uint16_t) len);
+}
+
+// Returns the conversion character of the next conversion in a format string, and advances
+// the format pointer past it, or returns 0 at the end of the string.
+static char NextConversion(const char ** fmt)
+{
+    const char * p = *fmt;
+    char conv      = 0;
+
+    while (*p != 0 && conv == 0)
+    {
+        if (*p++ != '%')
+        {
+            continue;
+        }
+        if (*p == '%')
+        {
+            p++;
+            continue;
+        }
+        // Skip flags, width, precision and length modifiers.
+        while (*p != 0 && strchr("-+ #0123456789.hlLjzt", *p) != NULL)
+        {
+            p++;
+        }
+        if (*p != 0)
+        {
+            conv = *p++;
+        }
+    }
+
+    *fmt = p;
+    return conv;
+}
+
+// With deferred logging, entries are processed one at a time from the idle hook (see
+// DeferredLogSupport.c), so the record buffers are kept off the idle task stack.  Without it,
+// entries are written in the context of the logging task and the buffers stay on its stack.
+#if NRF_LOG_DEFERRED
+#define BINARY_LOG_BUF_STORAGE static
+#else
+#define BINARY_LOG_BUF_STORAGE
+#endif
+
+static void BinaryLogPut(nrf_log_backend_t const * p_backend, nrf_log_entry_t * p_msg)
+{
+    BINARY_LOG_BUF_STORAGE uint8_t buf[BINARY_LOG_MAX_RECORD_SIZE];
+    RecordWriter writer = { buf, kRecordHeaderLength, sizeof(buf) };
+    nrf_log_header_t header;
+    size_t memobjOffset = HEADER_SIZE * sizeof(uint32_t);
+    uint8_t type;
+    uint16_t length;
+
+    nrf_memobj_get(p_msg);
+
+    nrf_memobj_read(p_msg, &header, HEADER_SIZE * sizeof(uint32_t), 0);
+
+#if NRF_LOG_USES_TIMESTAMP
+    Put32(&writer, header.timestamp);
+#else
+    Put32(&writer, 0);
+#endif
+    Put32(&writer, (uint32_t) nrf_log_module_name_get(header.module_id, false));
+    Put16(&writer, header.dropped);
+
+    if (header.base.generic.type == HEADER_TYPE_STD)
+    {
+        const char * fmt = (const char *) ((uint32_t) header.base.std.addr);
+        uint32_t nargs   = header.base.std.nargs;
+        BINARY_LOG_BUF_STORAGE uint32_t args[NRF_LOG_MAX_NUM_OF_ARGS];
+
+        nrf_memobj_read(p_msg, args, nargs * sizeof(uint32_t), memobjOffset);
+
+        type = kRecordType_Message;
+        Put8(&writer, header.base.std.severity);
+        Put8(&writer, nargs);
+        Put32(&writer, (uint32_t) fmt);
+
+        for (uint32_t i = 0; i < nargs; i++)
+        {
+            if (NextConversion(&fmt) == 's')
+            {
+                PutString(&writer, (const char *) args[i]);
+            }
+            else
+            {
+                Put32(&writer, args[i]);
+            }
+        }
+    }
+    else
+    {
+        uint32_t dataLen = header.base.hexdump.len;
+
+        type = kRecordType_HexDump;
+        Put8(&writer, header.base.hexdump.severity);
+        Put8(&writer, 0);
+
+        if (dataLen > (uint32_t) (writer.Capacity - writer.Length))
+        {
+            dataLen = writer.Capacity - writer.Length;
+        }
+        nrf_memobj_read(p_msg, writer.Buf + writer.Length, dataLen, memobjOffset);
+        writer.Length += dataLen;
+    }
+
+    nrf_memobj_put(p_msg);
+
+    length = writer.Length - kRecordHeaderLength;
+    buf[0] = kRecordMagic;
+    buf[1] = type;
+    memcpy(&buf[2], &length, sizeof(length));
+
+    // The RTT buffer is in skip mode, so a record is either written in full or not at all.
+    SEGGER_RTT_Write(kRTTChannel, buf, writer.Length);
+}
+
+static void BinaryLogPanicSet(nrf_log_backend_t const * p_backend)
+{
+    // Block rather than drop records once the system has failed, so that the final
+    // messages reach the host.
+    SEGGER_RTT_SetFlagsUpBuffer(kRTTChannel, SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL);
+}
+
+static void BinaryLogFlush(nrf_log_backend_t const * p_backend)
+{
+}
+
+static const nrf_log_backend_api_t sBinaryLogBackendApi = {
+    .put       = BinaryLogPut,
+    .panic_set = BinaryLogPanicSet,
+    .flush     = BinaryLogFlush,
+};
+
+NRF_LOG_BACKEND_DEF(sBinaryLogBackend, sBinaryLogBackendApi, NULL);
+
+void BinaryLogBackendInit(void)
+{
+    int32_t backendId;
+
+    SEGGER_RTT_Init();
+    SEGGER_RTT_SetFlagsUpBuffer(kRTTChannel, SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+
+    backendId = nrf_log_backend_add(&sBinaryLogBackend, NRF_LOG_SEVERITY_DEBUG);
+    ASSERT(backendId >= 0);
+    (void) backendId;
+
+    nrf_log_backend_enable(&sBinaryLogBackend);
+}
+
+#endif /* BINARY_LOG_ENABLED */
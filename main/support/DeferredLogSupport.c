@@ -0,0 +1,52 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Processing of deferred log entries.
+ *
+ *          With NRF_LOG_DEFERRED enabled, log entries are queued by the calling context and
+ *          formatted (or, with the binary backend, encoded) and written to the backends from
+ *          the FreeRTOS idle hook, i.e. only when no other task has work to do.
+ */
+
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "app_util_platform.h"
+#include "nrf_log_ctrl.h"
+
+#if configUSE_IDLE_HOOK
+
+void vApplicationIdleHook(void)
+{
+    bool more;
+
+    // Process the queued entries one at a time, serialized with any concurrent NRF_LOG_FLUSH
+    // (see nrf_log_ctrl_internal.h).
+    do
+    {
+        CRITICAL_REGION_ENTER();
+        more = NRF_LOG_PROCESS();
+        CRITICAL_REGION_EXIT();
+    } while (more);
+}
+
+#endif /* configUSE_IDLE_HOOK */
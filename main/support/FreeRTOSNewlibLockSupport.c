@@ -24,9 +24,15 @@
  */
 
 #include <sys/lock.h>
+#include <stdlib.h>
+#include <string.h>
 #include "FreeRTOS.h"
 #include "semphr.h"
 #include "task.h"
+#include "nrf.h"
+
+#include "app_config.h"
+#include "HeapMonitor.h"
 
 /*
  * Global mutex objects used by newlib.
@@ -56,6 +62,7 @@ static void InitNewlibMutexes(void)
     static StaticSemaphore_t sSemBuf_sfp_recursive_mutex;
     static StaticSemaphore_t sSemBuf_atexit_recursive_mutex;
     static StaticSemaphore_t sSemBuf_at_quick_exit_mutex;
+    static StaticSemaphore_t sSemBuf_malloc_recursive_mutex;
     static StaticSemaphore_t sSemBuf_env_recursive_mutex;
     static StaticSemaphore_t sSemBuf_tz_mutex;
     static StaticSemaphore_t sSemBuf_dd_hash_mutex;
@@ -65,6 +72,7 @@ static void InitNewlibMutexes(void)
     __lock___sfp_recursive_mutex    = xSemaphoreCreateRecursiveMutexStatic(&sSemBuf_sfp_recursive_mutex);
     __lock___atexit_recursive_mutex = xSemaphoreCreateRecursiveMutexStatic(&sSemBuf_atexit_recursive_mutex);
     __lock___at_quick_exit_mutex    = xSemaphoreCreateMutexStatic(&sSemBuf_at_quick_exit_mutex);
+    __lock___malloc_recursive_mutex = xSemaphoreCreateRecursiveMutexStatic(&sSemBuf_malloc_recursive_mutex);
     __lock___env_recursive_mutex    = xSemaphoreCreateRecursiveMutexStatic(&sSemBuf_env_recursive_mutex);
     __lock___tz_mutex               = xSemaphoreCreateMutexStatic(&sSemBuf_tz_mutex);
     __lock___dd_hash_mutex          = xSemaphoreCreateMutexStatic(&sSemBuf_dd_hash_mutex);
@@ -76,12 +84,21 @@ static void InitNewlibMutexes(void)
     __lock___sfp_recursive_mutex    = xSemaphoreCreateRecursiveMutex();
     __lock___atexit_recursive_mutex = xSemaphoreCreateRecursiveMutex();
     __lock___at_quick_exit_mutex    = xSemaphoreCreateMutex();
+    __lock___malloc_recursive_mutex = xSemaphoreCreateRecursiveMutex();
     __lock___env_recursive_mutex    = xSemaphoreCreateRecursiveMutex();
     __lock___tz_mutex               = xSemaphoreCreateMutex();
     __lock___dd_hash_mutex          = xSemaphoreCreateMutex();
     __lock___arc4random_mutex       = xSemaphoreCreateMutex();
 
 #endif /* USE_STATIC_NEWLIB_MUTEXES */
+
+#if HEAP_LOCK_STATS_ENABLED
+
+    // Enable the DWT cycle counter used to time heap lock hold periods.
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+#endif /* HEAP_LOCK_STATS_ENABLED */
 }
 
 /*
@@ -140,6 +157,181 @@ void __retarget_lock_release_recursive(_LOCK_T lock)
     xSemaphoreGiveRecursive((SemaphoreHandle_t)lock);
 }
 
+/*
+ * Heap lock instrumentation.
+ *
+ * Records how long the heap lock is held for, measured in CPU cycles from the outermost
+ * acquisition to the matching release.  When the lock is implemented as a critical section
+ * this is the time spent with interrupts masked; with the mutex it is the time other tasks
+ * are kept out of the heap, during which interrupts remain enabled.  These variables are only modified by the
+ * holder of the heap lock.
+ */
+
+#if HEAP_LOCK_STATS_ENABLED
+
+static HeapLockStats sHeapLockStats;
+static uint32_t sHeapLockDepth;
+static uint32_t sHeapLockStartCycles;
+
+static inline void StartHeapLockTiming(void)
+{
+    if (sHeapLockDepth++ == 0)
+    {
+        sHeapLockStartCycles = DWT->CYCCNT;
+    }
+}
+
+static inline void StopHeapLockTiming(void)
+{
+    if (--sHeapLockDepth == 0)
+    {
+        uint32_t cycles = DWT->CYCCNT - sHeapLockStartCycles;
+
+        sHeapLockStats.LockCount++;
+        sHeapLockStats.TotalHoldCycles += cycles;
+        if (cycles > sHeapLockStats.MaxHoldCycles)
+        {
+            sHeapLockStats.MaxHoldCycles = cycles;
+        }
+    }
+}
+
+#else /* HEAP_LOCK_STATS_ENABLED */
+
+static inline void StartHeapLockTiming(void) { }
+static inline void StopHeapLockTiming(void) { }
+
+#endif /* HEAP_LOCK_STATS_ENABLED */
+
+void GetHeapLockStats(HeapLockStats * stats)
+{
+#if HEAP_LOCK_STATS_ENABLED
+    taskENTER_CRITICAL();
+    *stats = sHeapLockStats;
+    taskEXIT_CRITICAL();
+#else
+    memset(stats, 0, sizeof(*stats));
+#endif
+    stats->InterruptsMasked = !USE_MALLOC_MUTEX;
+}
+
+#if USE_MALLOC_MUTEX
+
+/*
+ * Overrides for newlib's malloc locking functions.
+ *
+ * Once the scheduler is running the heap is protected by a recursive mutex, so that
+ * lengthy allocations and frees (e.g. during crypto operations) never delay interrupt
+ * handling.  Before the scheduler starts there is only a single thread of execution and
+ * no locking is required.  While the scheduler is suspended the caller cannot block on
+ * the mutex, but no other task can run either, so the mutex is taken without waiting.  If
+ * another task was preempted while holding it, the heap is mid-update and must not be
+ * touched: that is an error, and the heap monitor wrappers refuse the call (see
+ * HeapLockAvailable()).
+ *
+ * The heap must not be used from interrupt context.
+ */
+
+bool HeapLockAvailable(void)
+{
+    TaskHandle_t holder;
+
+    if (xTaskGetSchedulerState() != taskSCHEDULER_SUSPENDED)
+    {
+        return true;
+    }
+
+    holder = xSemaphoreGetMutexHolder(__lock___malloc_recursive_mutex);
+    return (holder == NULL || holder == xTaskGetCurrentTaskHandle());
+}
+
+void __malloc_lock(struct _reent * r)
+{
+    BaseType_t schedulerState = xTaskGetSchedulerState();
+    BaseType_t contended      = pdFALSE;
+
+    if (schedulerState == taskSCHEDULER_NOT_STARTED)
+    {
+        return;
+    }
+
+    configASSERT(__get_IPSR() == 0);
+
+    if (schedulerState == taskSCHEDULER_SUSPENDED)
+    {
+        // Never wait with the scheduler suspended; the holder could not run to release the lock.
+        BaseType_t taken = xSemaphoreTakeRecursive(__lock___malloc_recursive_mutex, 0);
+        configASSERT(taken == pdTRUE);
+        (void)taken;
+    }
+    else if (xSemaphoreTakeRecursive(__lock___malloc_recursive_mutex, 0) != pdTRUE)
+    {
+        contended = pdTRUE;
+
+        // The idle task must never block, so it yields until the holder releases the lock.
+        if (xTaskGetCurrentTaskHandle() == xTaskGetIdleTaskHandle())
+        {
+            while (xSemaphoreTakeRecursive(__lock___malloc_recursive_mutex, 0) != pdTRUE)
+            {
+                taskYIELD();
+            }
+        }
+        else
+        {
+            xSemaphoreTakeRecursive(__lock___malloc_recursive_mutex, portMAX_DELAY);
+        }
+    }
+
+    StartHeapLockTiming();
+
+#if HEAP_LOCK_STATS_ENABLED
+    if (contended)
+    {
+        sHeapLockStats.ContentionCount++;
+    }
+#else
+    (void)contended;
+#endif
+}
+
+void __malloc_unlock(struct _reent * r)
+{
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)
+    {
+        return;
+    }
+
+    StopHeapLockTiming();
+
+    xSemaphoreGiveRecursive(__lock___malloc_recursive_mutex);
+}
+
+/*
+ * FreeRTOS heap functions.
+ *
+ * These replace heap_3.c, which suspends the scheduler around every call to malloc() and
+ * free().  With the heap protected by a mutex that is unnecessary, and would make it
+ * impossible to wait for the mutex.
+ */
+
+void * pvPortMalloc(size_t xWantedSize)
+{
+    void * pvReturn = malloc(xWantedSize);
+    traceMALLOC(pvReturn, xWantedSize);
+    return pvReturn;
+}
+
+void vPortFree(void * pv)
+{
+    if (pv != NULL)
+    {
+        free(pv);
+        traceFREE(pv, 0);
+    }
+}
+
+#else /* USE_MALLOC_MUTEX */
+
 /*
  * Overrides for newlib's malloc locking functions.
  *
@@ -147,13 +339,22 @@ void __retarget_lock_release_recursive(_LOCK_T lock)
  * to improve speed.
  */
 
+bool HeapLockAvailable(void)
+{
+    // A critical section can always be entered.
+    return true;
+}
+
 void __malloc_lock(struct _reent * r)
 {
     taskENTER_CRITICAL();
+    StartHeapLockTiming();
 }
 
 void __malloc_unlock(struct _reent * r)
 {
+    StopHeapLockTiming();
     taskEXIT_CRITICAL();
 }
 
+#endif /* USE_MALLOC_MUTEX */
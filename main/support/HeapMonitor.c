@@ -0,0 +1,391 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Heap usage monitoring for the newlib system heap.
+ *
+ *          See HeapMonitor.h.  The wrapped functions are enabled by the -Wl,--wrap
+ *          linker options in the Makefile.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <reent.h>
+
+#include "app_config.h"
+#include "HeapMonitor.h"
+
+#include "FreeRTOS.h"
+
+extern size_t GetHeapTotalSize(void);
+extern size_t GetHeapFreeSize(void);
+
+extern void * __real_malloc(size_t size);
+extern void * __real_realloc(void * ptr, size_t size);
+extern void __real_free(void * ptr);
+
+/*
+ * Layout of a free chunk in the newlib-nano allocator (see nano-mallocr.c).
+ */
+typedef struct HeapChunk
+{
+    long Size;
+    struct HeapChunk * Next;
+} HeapChunk;
+
+extern HeapChunk * __malloc_free_list;
+
+#define HEAP_CHUNK_OVERHEAD 8
+
+#if HEAP_MONITOR_CALL_SITE_TAGS
+
+/*
+ * Tag prepended to each allocation to record its call site.  The tag is 8 bytes so that
+ * the alignment of the returned pointer is preserved.  The check word lets free() recognize
+ * blocks that were allocated without a tag (e.g. by newlib internally via _malloc_r()).
+ */
+typedef struct
+{
+    uint32_t Check;
+    uint32_t Site;
+} AllocTag;
+
+#define ALLOC_TAG_MAGIC 0x48544147
+#define ALLOC_TAG_CHECK(tag, site) (ALLOC_TAG_MAGIC ^ (uint32_t)(uintptr_t)(tag) ^ (uint32_t)(site))
+
+#endif // HEAP_MONITOR_CALL_SITE_TAGS
+
+static HeapCallSiteStats sCallSites[HEAP_MONITOR_MAX_CALL_SITES];
+static uint32_t sInUse;
+static uint32_t sPeakInUse;
+static uint32_t sAllocCount;
+static uint32_t sFailCount;
+
+static uint32_t LookupCallSite(uintptr_t callSite)
+{
+    uint32_t i;
+
+    // Entry 0 collects untracked allocations and call sites that do not fit in the table.
+    for (i = 1; i < HEAP_MONITOR_MAX_CALL_SITES; i++)
+    {
+        if (sCallSites[i].CallSite == callSite)
+        {
+            return i;
+        }
+        if (sCallSites[i].CallSite == 0)
+        {
+            sCallSites[i].CallSite = callSite;
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+static void RecordAlloc(uint32_t site, size_t size)
+{
+    HeapCallSiteStats * stats = &sCallSites[site];
+
+    sAllocCount++;
+    sInUse += size;
+    if (sInUse > sPeakInUse)
+    {
+        sPeakInUse = sInUse;
+    }
+
+    stats->LiveCount++;
+    stats->LiveBytes += size;
+    if (stats->LiveBytes > stats->PeakBytes)
+    {
+        stats->PeakBytes = stats->LiveBytes;
+    }
+}
+
+static void RecordFree(uint32_t site, size_t size)
+{
+    HeapCallSiteStats * stats = &sCallSites[site];
+
+    // Blocks allocated outside the wrappers were never counted; don't let them drive the
+    // totals negative.
+    sInUse -= (size < sInUse) ? size : sInUse;
+    if (stats->LiveCount > 0)
+    {
+        stats->LiveCount--;
+    }
+    stats->LiveBytes -= (size < stats->LiveBytes) ? size : stats->LiveBytes;
+}
+
+static void * MonitoredAlloc(size_t size, uintptr_t callSite)
+{
+    void * ptr;
+    uint32_t site;
+
+    // Refuse rather than enter a heap that another task is part way through updating.
+    if (!HeapLockAvailable())
+    {
+        configASSERT(0);
+        sFailCount++;
+        return NULL;
+    }
+
+    __malloc_lock(_REENT);
+
+    site = LookupCallSite(callSite);
+
+#if HEAP_MONITOR_CALL_SITE_TAGS
+    ptr = (size <= SIZE_MAX - sizeof(AllocTag)) ? __real_malloc(size + sizeof(AllocTag)) : NULL;
+#else
+    ptr = __real_malloc(size);
+#endif
+
+    if (ptr != NULL)
+    {
+        RecordAlloc(site, malloc_usable_size(ptr));
+
+#if HEAP_MONITOR_CALL_SITE_TAGS
+        ((AllocTag *)ptr)->Site  = site;
+        ((AllocTag *)ptr)->Check = ALLOC_TAG_CHECK(ptr, site);
+        ptr                      = (AllocTag *)ptr + 1;
+#endif
+    }
+    else
+    {
+        sFailCount++;
+        sCallSites[site].FailCount++;
+    }
+
+    __malloc_unlock(_REENT);
+
+    return ptr;
+}
+
+// Returns the underlying heap block for ptr, and the call site it is attributed to.
+static void * FindBlock(void * ptr, uint32_t * site)
+{
+#if HEAP_MONITOR_CALL_SITE_TAGS
+    AllocTag * tag = (AllocTag *)ptr - 1;
+
+    if (tag->Site < HEAP_MONITOR_MAX_CALL_SITES && tag->Check == ALLOC_TAG_CHECK(tag, tag->Site))
+    {
+        *site = tag->Site;
+        return tag;
+    }
+#endif
+
+    *site = 0;
+    return ptr;
+}
+
+void * __wrap_malloc(size_t size)
+{
+    return MonitoredAlloc(size, (uintptr_t)__builtin_return_address(0));
+}
+
+void * __wrap_calloc(size_t count, size_t size)
+{
+    void * ptr;
+
+    if (size != 0 && count > SIZE_MAX / size)
+    {
+        return NULL;
+    }
+
+    ptr = MonitoredAlloc(count * size, (uintptr_t)__builtin_return_address(0));
+    if (ptr != NULL)
+    {
+        memset(ptr, 0, count * size);
+    }
+
+    return ptr;
+}
+
+void * __wrap_realloc(void * ptr, size_t size)
+{
+    void * block;
+    void * newBlock;
+    uint32_t site;
+    size_t oldSize;
+
+    if (ptr == NULL)
+    {
+        return MonitoredAlloc(size, (uintptr_t)__builtin_return_address(0));
+    }
+
+    if (!HeapLockAvailable())
+    {
+        configASSERT(0);
+        sFailCount++;
+        return NULL;
+    }
+
+    __malloc_lock(_REENT);
+
+    block   = FindBlock(ptr, &site);
+    oldSize = malloc_usable_size(block);
+
+#if HEAP_MONITOR_CALL_SITE_TAGS
+    if (block != ptr)
+    {
+        newBlock = (size <= SIZE_MAX - sizeof(AllocTag)) ? __real_realloc(block, size + sizeof(AllocTag)) : NULL;
+    }
+    else
+#endif
+    {
+        newBlock = __real_realloc(block, size);
+    }
+
+    // A resized block stays attributed to the site that originally allocated it.
+    if (newBlock != NULL)
+    {
+        RecordFree(site, oldSize);
+        RecordAlloc(site, malloc_usable_size(newBlock));
+
+#if HEAP_MONITOR_CALL_SITE_TAGS
+        if (block != ptr)
+        {
+            ((AllocTag *)newBlock)->Check = ALLOC_TAG_CHECK(newBlock, site);
+            newBlock                      = (AllocTag *)newBlock + 1;
+        }
+#endif
+    }
+    else if (size != 0)
+    {
+        sFailCount++;
+        sCallSites[site].FailCount++;
+    }
+
+    __malloc_unlock(_REENT);
+
+    return newBlock;
+}
+
+void __wrap_free(void * ptr)
+{
+    void * block;
+    uint32_t site;
+
+    if (ptr == NULL)
+    {
+        return;
+    }
+
+    // The block is leaked rather than freed into a heap that another task is updating.
+    if (!HeapLockAvailable())
+    {
+        configASSERT(0);
+        return;
+    }
+
+    __malloc_lock(_REENT);
+
+    block = FindBlock(ptr, &site);
+    RecordFree(site, malloc_usable_size(block));
+
+#if HEAP_MONITOR_CALL_SITE_TAGS
+    // Invalidate the tag so that a stale copy is never mistaken for a live allocation.
+    if (block != ptr)
+    {
+        ((AllocTag *)block)->Check = 0;
+    }
+#endif
+
+    __real_free(block);
+
+    __malloc_unlock(_REENT);
+}
+
+void GetHeapStats(HeapStats * stats)
+{
+    const HeapChunk * chunk;
+    uint32_t freeListTotal = 0;
+    uint32_t largestChunk  = 0;
+    uint32_t sbrkFree;
+
+    __malloc_lock(_REENT);
+
+    // Walk the allocator's free list.  The list is short in practice, and this is only done
+    // when a diagnostic snapshot is taken.
+    for (chunk = __malloc_free_list; chunk != NULL; chunk = chunk->Next)
+    {
+        freeListTotal += (uint32_t)chunk->Size;
+        if ((uint32_t)chunk->Size > largestChunk)
+        {
+            largestChunk = (uint32_t)chunk->Size;
+        }
+    }
+
+    sbrkFree = (uint32_t)GetHeapFreeSize();
+
+    stats->TotalSize   = (uint32_t)GetHeapTotalSize();
+    stats->InUse       = sInUse;
+    stats->PeakInUse   = sPeakInUse;
+    stats->FreeTotal   = freeListTotal + sbrkFree;
+    stats->LargestFree = (largestChunk > HEAP_CHUNK_OVERHEAD) ? largestChunk - HEAP_CHUNK_OVERHEAD : 0;
+    if (sbrkFree > stats->LargestFree)
+    {
+        stats->LargestFree = sbrkFree;
+    }
+    stats->FragmentationPermille =
+        (stats->FreeTotal != 0) ? 1000 - (uint32_t)(((uint64_t)stats->LargestFree * 1000) / stats->FreeTotal) : 0;
+    stats->AllocCount = sAllocCount;
+    stats->FailCount  = sFailCount;
+
+    __malloc_unlock(_REENT);
+}
+
+size_t GetHeapCallSiteStats(HeapCallSiteStats * sites, size_t maxSites)
+{
+    size_t count = 0;
+    size_t i, j;
+
+    __malloc_lock(_REENT);
+
+    // Insertion sort into the caller's buffer, keeping the largest consumers.
+    for (i = 0; i < HEAP_MONITOR_MAX_CALL_SITES; i++)
+    {
+        const HeapCallSiteStats * site = &sCallSites[i];
+
+        if (site->LiveBytes == 0 && site->FailCount == 0)
+        {
+            continue;
+        }
+
+        for (j = count; j > 0 && sites[j - 1].LiveBytes < site->LiveBytes; j--)
+        {
+            if (j < maxSites)
+            {
+                sites[j] = sites[j - 1];
+            }
+        }
+
+        if (j < maxSites)
+        {
+            sites[j] = *site;
+            if (count < maxSites)
+            {
+                count++;
+            }
+        }
+    }
+
+    __malloc_unlock(_REENT);
+
+    return count;
+}
@@ -0,0 +1,86 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Implementation of the logging benchmark (see LogBenchmark.h).
+ */
+
+#include "LogBenchmark.h"
+
+#include <inttypes.h>
+
+#include "app_config.h"
+#include "nrf.h"
+#include "nrf_log.h"
+#include "nrf_log_ctrl.h"
+
+#if LOG_BENCHMARK_ENABLED
+
+#define LOG_BENCHMARK_ITERATIONS 32
+
+static uint32_t DrainLog(void)
+{
+    uint32_t start = DWT->CYCCNT;
+
+    while (NRF_LOG_PROCESS())
+    {
+    }
+
+    return DWT->CYCCNT - start;
+}
+
+void RunLogBenchmark(void)
+{
+    char str[] = "benchmark";
+    uint32_t start;
+    uint32_t callCycles;
+    uint32_t pushCycles;
+    uint32_t processCycles;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    DrainLog();
+
+    start = DWT->CYCCNT;
+    for (uint32_t i = 0; i < LOG_BENCHMARK_ITERATIONS; i++)
+    {
+        NRF_LOG_INFO("Log benchmark %" PRIu32 ": 0x%08" PRIX32 " %" PRIu32, i, start, LOG_BENCHMARK_ITERATIONS);
+    }
+    callCycles = DWT->CYCCNT - start;
+
+    processCycles = DrainLog();
+
+    start = DWT->CYCCNT;
+    for (uint32_t i = 0; i < LOG_BENCHMARK_ITERATIONS; i++)
+    {
+        NRF_LOG_INFO("Log benchmark %" PRIu32 ": %s", i, NRF_LOG_PUSH(str));
+    }
+    pushCycles = DWT->CYCCNT - start;
+
+    processCycles += DrainLog();
+
+    NRF_LOG_INFO("Log benchmark (%s, %s): call %" PRIu32 " cycles, push call %" PRIu32 " cycles, processing %" PRIu32
+                 " cycles per entry",
+                 (uint32_t) (NRF_LOG_DEFERRED ? "deferred" : "immediate"), (uint32_t) (BINARY_LOG_ENABLED ? "binary" : "text"),
+                 callCycles / LOG_BENCHMARK_ITERATIONS, pushCycles / LOG_BENCHMARK_ITERATIONS,
+                 processCycles / (2 * LOG_BENCHMARK_ITERATIONS));
+}
+
+#endif /* LOG_BENCHMARK_ENABLED */
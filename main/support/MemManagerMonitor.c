@@ -0,0 +1,311 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Demand monitoring for the nRF5 SDK mem_manager block pools.
+ *
+ *          See MemManagerMonitor.h.  The wrapped functions are enabled by the -Wl,--wrap
+ *          linker options in the Makefile.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "app_config.h"
+#include "app_util_platform.h"
+#include "mem_manager.h"
+#include "nrf_log.h"
+
+#include "MemManagerMonitor.h"
+
+extern uint32_t __real_nrf_mem_init(void);
+extern void * __real_nrf_malloc(uint32_t size);
+extern void * __real_nrf_calloc(uint32_t count, uint32_t size);
+extern void * __real_nrf_realloc(void * p_buffer, uint32_t size);
+extern void __real_nrf_free(void * p_buffer);
+
+#define MEM_MANAGER_TOTAL_BLOCK_COUNT \
+    (MEMORY_MANAGER_SMALL_BLOCK_COUNT + MEMORY_MANAGER_MEDIUM_BLOCK_COUNT + MEMORY_MANAGER_LARGE_BLOCK_COUNT)
+
+static const uint32_t sClassBlockSize[kMemManagerClassCount] = {
+    MEMORY_MANAGER_SMALL_BLOCK_SIZE,
+    MEMORY_MANAGER_MEDIUM_BLOCK_SIZE,
+    MEMORY_MANAGER_LARGE_BLOCK_SIZE,
+};
+
+static const uint32_t sClassBlockCount[kMemManagerClassCount] = {
+    MEMORY_MANAGER_SMALL_BLOCK_COUNT,
+    MEMORY_MANAGER_MEDIUM_BLOCK_COUNT,
+    MEMORY_MANAGER_LARGE_BLOCK_COUNT,
+};
+
+/*
+ * Live allocations, needed to attribute nrf_free() calls.  Each records the class its
+ * requested size maps to and the pool that actually served it.  The pools can never hold
+ * more than MEM_MANAGER_TOTAL_BLOCK_COUNT blocks, so this table cannot overflow.
+ */
+typedef struct
+{
+    void * Block;
+    uint8_t ClassIndex;
+    uint8_t PoolIndex;
+} LiveBlock;
+
+static LiveBlock sLiveBlocks[MEM_MANAGER_TOTAL_BLOCK_COUNT];
+static MemManagerClassStats sClassStats[kMemManagerClassCount];
+
+/*
+ * Start address of each pool.  mem_manager lays its pools out back to back, smallest
+ * first, in a single static array; the base is found by allocating one block from the
+ * empty pools at init.
+ */
+static uintptr_t sPoolStart[kMemManagerClassCount + 1];
+
+static void InitPoolRanges(void)
+{
+    uint8_t first = 0;
+    void * probe;
+
+    while (first < kMemManagerClassCount && sClassBlockCount[first] == 0)
+    {
+        first++;
+    }
+
+    memset(sPoolStart, 0, sizeof(sPoolStart));
+    if (first == kMemManagerClassCount)
+    {
+        return;
+    }
+
+    // With every block free, the smallest request is served by the first block of the
+    // first non-empty pool.
+    probe = __real_nrf_malloc(1);
+    if (probe == NULL)
+    {
+        return;
+    }
+    __real_nrf_free(probe);
+
+    for (uint8_t i = 0; i <= kMemManagerClassCount; i++)
+    {
+        if (i <= first)
+        {
+            sPoolStart[i] = (uintptr_t)probe;
+        }
+        else
+        {
+            sPoolStart[i] = sPoolStart[i - 1] + sClassBlockSize[i - 1] * sClassBlockCount[i - 1];
+        }
+    }
+}
+
+static uint8_t ClassForSize(uint32_t size)
+{
+    uint8_t i;
+
+    for (i = 0; i < kMemManagerClassCount - 1; i++)
+    {
+        if (size <= sClassBlockSize[i])
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+static uint8_t PoolForBlock(const void * block)
+{
+    uintptr_t addr = (uintptr_t)block;
+
+    for (uint8_t i = 0; i < kMemManagerClassCount; i++)
+    {
+        if (addr >= sPoolStart[i] && addr < sPoolStart[i + 1])
+        {
+            return i;
+        }
+    }
+
+    // Pool ranges unknown; fall back to the class of the request.
+    return kMemManagerClassCount;
+}
+
+static void RecordRequest(void * block, uint32_t size)
+{
+    uint8_t classIndex           = ClassForSize(size);
+    MemManagerClassStats * stats = &sClassStats[classIndex];
+
+    CRITICAL_REGION_ENTER();
+
+    stats->RequestCount++;
+    if (size > stats->MaxRequestSize)
+    {
+        stats->MaxRequestSize = size;
+    }
+
+    if (block != NULL)
+    {
+        uint8_t poolIndex = PoolForBlock(block);
+        MemManagerClassStats * pool;
+
+        if (poolIndex == kMemManagerClassCount)
+        {
+            poolIndex = classIndex;
+        }
+        pool = &sClassStats[poolIndex];
+
+        for (uint32_t i = 0; i < MEM_MANAGER_TOTAL_BLOCK_COUNT; i++)
+        {
+            if (sLiveBlocks[i].Block == NULL)
+            {
+                sLiveBlocks[i].Block      = block;
+                sLiveBlocks[i].ClassIndex = classIndex;
+                sLiveBlocks[i].PoolIndex  = poolIndex;
+                break;
+            }
+        }
+
+        // Demand is charged to the class of the request, occupancy to the pool that served it.
+        if (poolIndex != classIndex)
+        {
+            stats->FallbackCount++;
+        }
+
+        stats->Demand++;
+        if (stats->Demand > stats->PeakDemand)
+        {
+            stats->PeakDemand = stats->Demand;
+        }
+
+        pool->Outstanding++;
+        if (pool->Outstanding > pool->PeakOutstanding)
+        {
+            pool->PeakOutstanding = pool->Outstanding;
+        }
+    }
+    else
+    {
+        // Had the request succeeded, this is how many requests of the class would have been live.
+        stats->FailCount++;
+        if (stats->Demand + 1 > stats->PeakDemand)
+        {
+            stats->PeakDemand = stats->Demand + 1;
+        }
+    }
+
+    CRITICAL_REGION_EXIT();
+
+#if MEM_MANAGER_MONITOR_TRACE
+    NRF_LOG_INFO("memtrace a %" PRIu32 " 0x%08" PRIX32, size, (uint32_t)block);
+#endif
+}
+
+static void RecordRelease(void * block)
+{
+    CRITICAL_REGION_ENTER();
+
+    for (uint32_t i = 0; i < MEM_MANAGER_TOTAL_BLOCK_COUNT; i++)
+    {
+        if (sLiveBlocks[i].Block == block)
+        {
+            sClassStats[sLiveBlocks[i].ClassIndex].Demand--;
+            sClassStats[sLiveBlocks[i].PoolIndex].Outstanding--;
+            sLiveBlocks[i].Block = NULL;
+            break;
+        }
+    }
+
+    CRITICAL_REGION_EXIT();
+
+#if MEM_MANAGER_MONITOR_TRACE
+    NRF_LOG_INFO("memtrace f 0x%08" PRIX32, (uint32_t)block);
+#endif
+}
+
+uint32_t __wrap_nrf_mem_init(void)
+{
+    uint32_t ret;
+
+    memset(sLiveBlocks, 0, sizeof(sLiveBlocks));
+    memset(sClassStats, 0, sizeof(sClassStats));
+
+    ret = __real_nrf_mem_init();
+    if (ret == NRF_SUCCESS)
+    {
+        InitPoolRanges();
+    }
+
+    return ret;
+}
+
+void * __wrap_nrf_malloc(uint32_t size)
+{
+    void * block = __real_nrf_malloc(size);
+    RecordRequest(block, size);
+    return block;
+}
+
+void * __wrap_nrf_calloc(uint32_t count, uint32_t size)
+{
+    void * block = __real_nrf_calloc(count, size);
+    RecordRequest(block, count * size);
+    return block;
+}
+
+void * __wrap_nrf_realloc(void * p_buffer, uint32_t size)
+{
+    void * block = __real_nrf_realloc(p_buffer, size);
+
+    // A successful reallocation is accounted as a release followed by a new request.
+    if (block != NULL && p_buffer != NULL)
+    {
+        RecordRelease(p_buffer);
+    }
+    RecordRequest(block, size);
+
+    return block;
+}
+
+void __wrap_nrf_free(void * p_buffer)
+{
+    if (p_buffer != NULL)
+    {
+        RecordRelease(p_buffer);
+    }
+
+    __real_nrf_free(p_buffer);
+}
+
+void GetMemManagerClassStats(uint8_t classIndex, MemManagerClassStats * stats)
+{
+    CRITICAL_REGION_ENTER();
+    *stats = sClassStats[classIndex];
+    CRITICAL_REGION_EXIT();
+
+    stats->BlockSize  = sClassBlockSize[classIndex];
+    stats->BlockCount = sClassBlockCount[classIndex];
+}
+
+uint32_t GetMemManagerRecommendedBlockCount(const MemManagerClassStats * stats)
+{
+    // Size for the peak demand of the class seen so far (not the occupancy of its pool, which
+    // includes requests that fell back from smaller classes), plus one block of headroom if
+    // requests have failed.
+    return stats->PeakDemand + ((stats->FailCount != 0) ? 1 : 0);
+}
@@ -0,0 +1,94 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Implementation of power source detection and supply voltage measurement
+ *          (see PowerMonitor.h).
+ */
+
+#include "PowerMonitor.h"
+
+#include <stdbool.h>
+
+#include "nrf.h"
+#include "nrf_soc.h"
+
+// Full scale of a 12-bit conversion with gain 1/6 and the internal 0.6 V reference.
+#define SAADC_FULL_SCALE_MV     3600
+#define SAADC_FULL_SCALE_COUNTS 4096
+
+// Input divider applied by the SAADC to the VDDH input.
+#define SAADC_VDDH_DIVIDER      5
+
+PowerSource GetPowerSource(void)
+{
+    uint32_t usbRegStatus = 0;
+
+    // The POWER peripheral belongs to the SoftDevice; read its status through the SoftDevice API.
+    if (sd_power_usbregstatus_get(&usbRegStatus) != NRF_SUCCESS)
+    {
+        usbRegStatus = 0;
+    }
+
+    return (usbRegStatus & POWER_USBREGSTATUS_VBUSDETECT_Msk) ? kPowerSource_External : kPowerSource_Battery;
+}
+
+uint32_t MeasureSupplyVoltage(void)
+{
+    volatile int16_t sample = 0;
+    bool highVoltageMode    = (NRF_POWER->MAINREGSTATUS & POWER_MAINREGSTATUS_MAINREGSTATUS_Msk) != 0;
+    uint32_t millivolts;
+
+    NRF_SAADC->ENABLE      = SAADC_ENABLE_ENABLE_Enabled << SAADC_ENABLE_ENABLE_Pos;
+    NRF_SAADC->RESOLUTION  = SAADC_RESOLUTION_VAL_12bit << SAADC_RESOLUTION_VAL_Pos;
+    NRF_SAADC->OVERSAMPLE  = SAADC_OVERSAMPLE_OVERSAMPLE_Bypass << SAADC_OVERSAMPLE_OVERSAMPLE_Pos;
+    NRF_SAADC->CH[0].CONFIG = (SAADC_CH_CONFIG_GAIN_Gain1_6 << SAADC_CH_CONFIG_GAIN_Pos) |
+        (SAADC_CH_CONFIG_REFSEL_Internal << SAADC_CH_CONFIG_REFSEL_Pos) | (SAADC_CH_CONFIG_TACQ_10us << SAADC_CH_CONFIG_TACQ_Pos) |
+        (SAADC_CH_CONFIG_MODE_SE << SAADC_CH_CONFIG_MODE_Pos);
+    NRF_SAADC->CH[0].PSELN = SAADC_CH_PSELN_PSELN_NC << SAADC_CH_PSELN_PSELN_Pos;
+    NRF_SAADC->CH[0].PSELP = (highVoltageMode ? SAADC_CH_PSELP_PSELP_VDDHDIV5 : SAADC_CH_PSELP_PSELP_VDD)
+        << SAADC_CH_PSELP_PSELP_Pos;
+    NRF_SAADC->RESULT.PTR    = (uint32_t) &sample;
+    NRF_SAADC->RESULT.MAXCNT = 1;
+
+    NRF_SAADC->EVENTS_STARTED = 0;
+    NRF_SAADC->TASKS_START    = 1;
+    while (NRF_SAADC->EVENTS_STARTED == 0)
+    {
+    }
+
+    NRF_SAADC->EVENTS_END   = 0;
+    NRF_SAADC->TASKS_SAMPLE = 1;
+    while (NRF_SAADC->EVENTS_END == 0)
+    {
+    }
+
+    NRF_SAADC->EVENTS_STOPPED = 0;
+    NRF_SAADC->TASKS_STOP     = 1;
+    while (NRF_SAADC->EVENTS_STOPPED == 0)
+    {
+    }
+
+    NRF_SAADC->CH[0].PSELP = SAADC_CH_PSELP_PSELP_NC << SAADC_CH_PSELP_PSELP_Pos;
+    NRF_SAADC->ENABLE      = SAADC_ENABLE_ENABLE_Disabled << SAADC_ENABLE_ENABLE_Pos;
+
+    millivolts = (sample > 0) ? ((uint32_t) sample * SAADC_FULL_SCALE_MV) / SAADC_FULL_SCALE_COUNTS : 0;
+
+    return highVoltageMode ? millivolts * SAADC_VDDH_DIVIDER : millivolts;
+}
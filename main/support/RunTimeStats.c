@@ -0,0 +1,171 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Implementation of FreeRTOS run-time statistics support (see RunTimeStats.h).
+ */
+
+#include "RunTimeStats.h"
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "nrf.h"
+#include "app_util_platform.h"
+
+#include "app_config.h"
+
+#if configGENERATE_RUN_TIME_STATS
+
+static uint32_t sLastCycles;
+static uint32_t sCycleRemainder;
+static uint32_t sCounterUS;
+
+static uint32_t sWakeupCount[RUN_TIME_STATS_MAX_TASKS];
+static uint32_t sNextTaskSlot;
+
+static uint32_t sPrevRunTime[RUN_TIME_STATS_MAX_TASKS];
+static uint32_t sPrevWakeups[RUN_TIME_STATS_MAX_TASKS];
+static uint32_t sPrevCounterUS;
+static TickType_t sPrevTicks;
+
+void ConfigureRunTimeStatsTimer(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    sLastCycles = DWT->CYCCNT;
+}
+
+uint32_t GetRunTimeCounterValue(void)
+{
+    uint32_t cyclesPerUS = SystemCoreClock / 1000000;
+    uint32_t cycles;
+    uint32_t counterUS;
+
+    // The counter is read both from the context switch and from task level (e.g. by
+    // uxTaskGetSystemState()), so extend it in a critical region.  This masks application
+    // interrupts only, leaving the SoftDevice's high-priority interrupts running.  The
+    // cycle counter wraps after ~67 seconds of CPU time; the counter is read at every
+    // context switch, far more often than that.
+    CRITICAL_REGION_ENTER();
+
+    cycles      = DWT->CYCCNT;
+    sCycleRemainder += cycles - sLastCycles;
+    sLastCycles = cycles;
+
+    sCounterUS += sCycleRemainder / cyclesPerUS;
+    sCycleRemainder %= cyclesPerUS;
+    counterUS = sCounterUS;
+
+    CRITICAL_REGION_EXIT();
+
+    return counterUS;
+}
+
+uint32_t RunTimeStatsTaskSwitchedIn(uint32_t taskNumber)
+{
+    // Called from the context switch with interrupts masked.
+    if (taskNumber == 0 && sNextTaskSlot < RUN_TIME_STATS_MAX_TASKS)
+    {
+        taskNumber = ++sNextTaskSlot;
+    }
+
+    if (taskNumber != 0 && taskNumber <= RUN_TIME_STATS_MAX_TASKS)
+    {
+        sWakeupCount[taskNumber - 1]++;
+    }
+
+    return taskNumber;
+}
+
+size_t GetTaskRunTimeStats(TaskRunTimeStats * stats, size_t maxTasks, RunTimeSummary * summary)
+{
+    TaskStatus_t tasks[RUN_TIME_STATS_MAX_TASKS];
+    UBaseType_t taskCount;
+    uint32_t counterUS;
+    uint32_t totalUS;
+    TickType_t ticks;
+    uint32_t intervalMS;
+    size_t count = 0;
+
+    taskCount = uxTaskGetSystemState(tasks, RUN_TIME_STATS_MAX_TASKS, NULL);
+    counterUS = GetRunTimeCounterValue();
+    ticks     = xTaskGetTickCount();
+
+    totalUS    = counterUS - sPrevCounterUS;
+    intervalMS = (uint32_t) (((uint64_t) (ticks - sPrevTicks) * 1000) / configTICK_RATE_HZ);
+
+    for (UBaseType_t i = 0; i < taskCount; i++)
+    {
+        // The slot is kept in the task's uxTaskNumber by the switch-in hook.  This is not
+        // TaskStatus_t::xTaskNumber, which reports the creation-order uxTCBNumber.
+        uint32_t slot = uxTaskGetTaskNumber(tasks[i].xHandle);
+        uint32_t runTime;
+        uint32_t wakeups;
+
+        // Tasks that have never run have not been assigned a slot yet.
+        if (slot == 0 || slot > RUN_TIME_STATS_MAX_TASKS)
+        {
+            continue;
+        }
+        slot--;
+
+        runTime             = tasks[i].ulRunTimeCounter - sPrevRunTime[slot];
+        wakeups             = sWakeupCount[slot] - sPrevWakeups[slot];
+        sPrevRunTime[slot]  = tasks[i].ulRunTimeCounter;
+        sPrevWakeups[slot] += wakeups;
+
+        if (count < maxTasks)
+        {
+            stats[count].Name        = tasks[i].pcTaskName;
+            stats[count].RunTimeUS   = runTime;
+            stats[count].CPUPermille = (totalUS != 0) ? (uint32_t) (((uint64_t) runTime * 1000) / totalUS) : 0;
+            stats[count].Wakeups     = wakeups;
+            count++;
+        }
+    }
+
+    if (summary != NULL)
+    {
+        summary->IntervalMS        = intervalMS;
+        summary->CPUTimeUS         = totalUS;
+        summary->DutyCyclePermille = (intervalMS != 0) ? (uint32_t) ((uint64_t) totalUS / intervalMS) : 0;
+    }
+
+    sPrevCounterUS = counterUS;
+    sPrevTicks     = ticks;
+
+    return count;
+}
+
+#else /* configGENERATE_RUN_TIME_STATS */
+
+size_t GetTaskRunTimeStats(TaskRunTimeStats * stats, size_t maxTasks, RunTimeSummary * summary)
+{
+    if (summary != NULL)
+    {
+        memset(summary, 0, sizeof(*summary));
+    }
+
+    return 0;
+}
+
+#endif /* configGENERATE_RUN_TIME_STATS */
@@ -0,0 +1,147 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Implementation of sleep residency profiling (see SleepProfiler.h).
+ */
+
+#include "SleepProfiler.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "nrf.h"
+
+#if SLEEP_PROFILER_ENABLED
+
+// RTC instance that drives the FreeRTOS tick (see portmacro_cmsis.h).  Its counter runs
+// at configTICK_RATE_HZ and is 24 bits wide.
+#define SLEEP_PROFILER_RTC          NRF_RTC1
+#define SLEEP_PROFILER_RTC_IRQn     RTC1_IRQn
+#define SLEEP_PROFILER_RTC_MASK     0x00FFFFFFUL
+
+// Interrupt used by the SoftDevice to signal events to the application (SD_EVT_IRQn).
+#define SLEEP_PROFILER_SD_EVT_IRQn  SWI2_EGU2_IRQn
+
+static SleepProfile sProfile;
+static uint32_t sSleepStartCounter;
+
+static bool IsPending(IRQn_Type irq)
+{
+    return (NVIC->ISPR[((uint32_t) irq) >> 5] & (1UL << (((uint32_t) irq) & 0x1F))) != 0;
+}
+
+static WakeReason GetWakeReason(void)
+{
+    // Classify the wakeup by the highest priority source among the pending interrupts.
+    if (IsPending(RADIO_IRQn) || IsPending(SLEEP_PROFILER_SD_EVT_IRQn))
+    {
+        return kWakeReason_Radio;
+    }
+    if (IsPending(GPIOTE_IRQn))
+    {
+        return kWakeReason_GPIO;
+    }
+    if (IsPending(SLEEP_PROFILER_RTC_IRQn))
+    {
+        return kWakeReason_Tick;
+    }
+    if (IsPending(RTC2_IRQn) || IsPending(TIMER0_IRQn) || IsPending(TIMER1_IRQn) || IsPending(TIMER2_IRQn) ||
+        IsPending(TIMER3_IRQn) || IsPending(TIMER4_IRQn))
+    {
+        return kWakeReason_Timer;
+    }
+    return kWakeReason_Other;
+}
+
+static uint8_t GetBucket(uint32_t ticks)
+{
+    uint8_t bucket = 0;
+
+    while (ticks > 1 && bucket < kSleepHistogramBuckets - 1)
+    {
+        ticks >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+void SleepProfilerPreSleep(void)
+{
+    sSleepStartCounter = SLEEP_PROFILER_RTC->COUNTER;
+}
+
+void SleepProfilerPostSleep(void)
+{
+    uint32_t ticks = (SLEEP_PROFILER_RTC->COUNTER - sSleepStartCounter) & SLEEP_PROFILER_RTC_MASK;
+    uint8_t bucket = GetBucket(ticks);
+
+    sProfile.SleepCount++;
+    sProfile.SleepTicks += ticks;
+    sProfile.BucketCount[bucket]++;
+    sProfile.BucketTicks[bucket] += ticks;
+    sProfile.WakeCount[GetWakeReason()]++;
+}
+
+void GetSleepProfile(SleepProfile * profile)
+{
+    taskENTER_CRITICAL();
+    *profile = sProfile;
+    taskEXIT_CRITICAL();
+}
+
+void ResetSleepProfile(void)
+{
+    taskENTER_CRITICAL();
+    memset(&sProfile, 0, sizeof(sProfile));
+    taskEXIT_CRITICAL();
+}
+
+#else /* SLEEP_PROFILER_ENABLED */
+
+void GetSleepProfile(SleepProfile * profile)
+{
+    memset(profile, 0, sizeof(*profile));
+}
+
+void ResetSleepProfile(void)
+{
+}
+
+#endif /* SLEEP_PROFILER_ENABLED */
+
+const char * GetWakeReasonName(WakeReason reason)
+{
+    switch (reason)
+    {
+        case kWakeReason_Tick:
+            return "tick";
+        case kWakeReason_Timer:
+            return "timer";
+        case kWakeReason_Radio:
+            return "radio";
+        case kWakeReason_GPIO:
+            return "gpio";
+        default:
+            return "other";
+    }
+}
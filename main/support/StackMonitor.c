@@ -0,0 +1,81 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *          Implementation of task stack usage monitoring (see StackMonitor.h).
+ */
+
+#include "StackMonitor.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "app_config.h"
+#include "app_error.h"
+#include "nrf_log.h"
+
+// Provided by freertos_tasks_c_additions.h.
+extern UBaseType_t uxTaskGetStackDepth(TaskHandle_t xTask);
+
+static uint32_t RecommendStackSize(uint32_t peakUsed)
+{
+    uint32_t headroom = (peakUsed * STACK_MONITOR_HEADROOM_PERCENT) / 100;
+
+    if (headroom < STACK_MONITOR_MIN_HEADROOM_BYTES)
+    {
+        headroom = STACK_MONITOR_MIN_HEADROOM_BYTES;
+    }
+
+    // Round up to a whole number of 8-byte aligned units, as required by the AAPCS.
+    return (peakUsed + headroom + 7) & ~7u;
+}
+
+size_t GetTaskStackStats(TaskStackStats * stats, size_t maxTasks)
+{
+    TaskStatus_t tasks[STACK_MONITOR_MAX_TASKS];
+    UBaseType_t taskCount;
+    size_t count = 0;
+
+    taskCount = uxTaskGetSystemState(tasks, STACK_MONITOR_MAX_TASKS, NULL);
+
+    for (UBaseType_t i = 0; i < taskCount && count < maxTasks; i++)
+    {
+        uint32_t stackSize = uxTaskGetStackDepth(tasks[i].xHandle) * sizeof(StackType_t);
+        uint32_t unused    = tasks[i].usStackHighWaterMark * sizeof(StackType_t);
+
+        stats[count].Name        = tasks[i].pcTaskName;
+        stats[count].StackSize   = stackSize;
+        stats[count].PeakUsed    = stackSize - unused;
+        stats[count].Recommended = RecommendStackSize(stats[count].PeakUsed);
+        count++;
+    }
+
+    return count;
+}
+
+#if configCHECK_FOR_STACK_OVERFLOW
+
+void vApplicationStackOverflowHook(TaskHandle_t xTask, char * pcTaskName)
+{
+    NRF_LOG_ERROR("Stack overflow in task %s", (uint32_t) pcTaskName);
+
+    APP_ERROR_HANDLER(NRF_ERROR_NO_MEM);
+}
+
+#endif /* configCHECK_FOR_STACK_OVERFLOW */
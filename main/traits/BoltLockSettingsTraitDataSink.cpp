@@ -54,7 +54,11 @@ BoltLockSettingsTraitDataSink::SetLeafData(PropertyPathHandle aLeafHandle, TLVRe
             err = aReader.Get(auto_relock_on);
             nlREQUIRE_SUCCESS(err, exit);
 
-            BoltLockMgr().EnableAutoRelock(auto_relock_on);
+            // The settings trait applies to the door as a whole, i.e. to every actuator.
+            for (uint8_t i = 0; i < BOLT_LOCK_ACTUATOR_COUNT; i++)
+            {
+                BoltLockMgr(i).EnableAutoRelock(auto_relock_on);
+            }
 
             NRF_LOG_INFO("Auto Relock %s", (auto_relock_on) ? "ENABLED" : "DISABLED");
             break;
@@ -66,7 +70,10 @@ BoltLockSettingsTraitDataSink::SetLeafData(PropertyPathHandle aLeafHandle, TLVRe
             err = aReader.Get(auto_lock_duration);
             nlREQUIRE_SUCCESS(err, exit);
 
-            BoltLockMgr().SetAutoLockDuration(auto_lock_duration);
+            for (uint8_t i = 0; i < BOLT_LOCK_ACTUATOR_COUNT; i++)
+            {
+                BoltLockMgr(i).SetAutoLockDuration(auto_lock_duration);
+            }
 
             NRF_LOG_INFO("Auto Relock Duration (secs): %u", auto_lock_duration);
             break;
@@ -28,10 +28,14 @@
 #include <WDMFeature.h>
 #include <BoltLockManager.h>
 #include <AppTask.h>
+#include <FormatUtils.h>
 
 #include <Weave/DeviceLayer/WeaveDeviceLayer.h>
+#include <Weave/Profiles/security/WeaveSecurity.h>
 #include <Weave/Support/TraitEventUtils.h>
 
+#include <string.h>
+
 using namespace nl::Weave;
 using namespace nl::Weave::TLV;
 using namespace nl::Weave::Profiles::DataManagement;
@@ -40,10 +44,21 @@ using namespace Schema::Weave::Trait::Security::BoltLockTrait;
 
 BoltLockTraitDataSource::BoltLockTraitDataSource() : TraitDataSource(&BoltLockTrait::TraitSchema)
 {
+    mActuator      = 0;
     mLockedState   = BOLT_LOCKED_STATE_LOCKED;
     mLockActor     = BOLT_LOCK_ACTOR_METHOD_PHYSICAL;
     mActuatorState = BOLT_ACTUATOR_STATE_OK;
     mState         = BOLT_STATE_EXTENDED;
+
+    memset(mCommandStats, 0, sizeof(mCommandStats));
+    mIsCommandPending               = false;
+    mPendingCommandSource           = kCommandSource_Service;
+    mPendingCommandInitiationTimeUS = 0;
+}
+
+void BoltLockTraitDataSource::SetActuator(uint8_t aActuator)
+{
+    mActuator = aActuator;
 }
 
 bool BoltLockTraitDataSource::IsLocked()
@@ -124,6 +139,8 @@ void BoltLockTraitDataSource::LockingSuccessful(void)
     SetDirty(BoltLockTrait::kPropertyHandle_LockedState);
     SetDirty(BoltLockTrait::kPropertyHandle_LockedStateLastChangedAt);
 
+    CompleteCommand();
+
     Unlock();
 
     BoltActuatorStateChangeEvent ev;
@@ -149,6 +166,8 @@ void BoltLockTraitDataSource::UnlockingSuccessful(void)
     SetDirty(BoltLockTrait::kPropertyHandle_State);
     SetDirty(BoltLockTrait::kPropertyHandle_ActuatorState);
 
+    CompleteCommand();
+
     Unlock();
 
     BoltActuatorStateChangeEvent ev;
@@ -164,6 +183,108 @@ void BoltLockTraitDataSource::UnlockingSuccessful(void)
     WdmFeature().ProcessTraitChanges();
 }
 
+// Called on the app task when a command has started the lock action.
+void BoltLockTraitDataSource::StartCommand(CommandSource aSource, int64_t aInitiationTimeUS)
+{
+    Lock();
+    mIsCommandPending               = true;
+    mPendingCommandSource           = aSource;
+    mPendingCommandInitiationTimeUS = aInitiationTimeUS;
+    Unlock();
+}
+
+// Called on the app task when a command did not start a lock action.
+void BoltLockTraitDataSource::RefuseCommand(CommandSource aSource)
+{
+    Lock();
+    mCommandStats[aSource].Refused++;
+    Unlock();
+}
+
+void BoltLockTraitDataSource::GetCommandStats(CommandSource aSource, CommandStats & aStats)
+{
+    Lock();
+    aStats = mCommandStats[aSource];
+    Unlock();
+}
+
+const char * BoltLockTraitDataSource::GetCommandSourceName(CommandSource aSource)
+{
+    switch (aSource)
+    {
+        case kCommandSource_Service:
+            return "service";
+        case kCommandSource_Local:
+            return "local";
+        default:
+            return "unknown";
+    }
+}
+
+// Called with the data source locked, when the lock action finishes.
+void BoltLockTraitDataSource::CompleteCommand(void)
+{
+    CommandStats & stats = mCommandStats[mPendingCommandSource];
+
+    if (!mIsCommandPending)
+    {
+        return;
+    }
+
+    mIsCommandPending = false;
+    stats.Completed++;
+
+#if WEAVE_DEVICE_CONFIG_ENABLE_WEAVE_TIME_SERVICE_TIME_SYNC
+    uint64_t nowMS;
+
+    if (mPendingCommandInitiationTimeUS > 0 && System::Platform::Layer::GetClock_RealTimeMS(nowMS) == WEAVE_NO_ERROR)
+    {
+        int64_t elapsedMS  = static_cast<int64_t>(nowMS) - mPendingCommandInitiationTimeUS / 1000;
+        uint32_t latencyMS = (elapsedMS > 0) ? static_cast<uint32_t>(elapsedMS) : 0; // Clock skew can make it negative.
+
+        stats.Timed++;
+        stats.TotalLatencyMS += latencyMS;
+        if (latencyMS > stats.MaxLatencyMS)
+        {
+            stats.MaxLatencyMS = latencyMS;
+        }
+
+        NRF_LOG_INFO("BoltLockChangeRequest (%s) completed %" PRIu32 " ms after initiation", GetCommandSourceName(mPendingCommandSource),
+                     latencyMS);
+        return;
+    }
+#endif
+
+    NRF_LOG_INFO("BoltLockChangeRequest (%s) completed (no initiation time)", GetCommandSourceName(mPendingCommandSource));
+}
+
+BoltLockTraitDataSource::CommandSource BoltLockTraitDataSource::GetCommandSource(const WeaveMessageInfo * aMsgInfo)
+{
+    // Service endpoint node ids share their upper 32 bits.
+    if ((aMsgInfo->SourceNodeId >> 32) == (kServiceEndpoint_Data_Management >> 32))
+    {
+        return kCommandSource_Service;
+    }
+
+    return kCommandSource_Local;
+}
+
+bool BoltLockTraitDataSource::IsAuthenticated(const WeaveMessageInfo * aMsgInfo)
+{
+    // Only accept commands from a fabric member: a CASE session authenticated with a fabric
+    // certificate (the service, or a paired phone using its access token), or a message
+    // encrypted with a fabric group key.  PASE is rejected.  Its pairing code is printed on
+    // the device, so a PASE session only proves possession of the device, and is accepted
+    // for the provisioning profiles alone (handled by the device layer), to bring the device
+    // onto a fabric.
+    if (aMsgInfo->EncryptionType == kWeaveEncryptionType_None)
+    {
+        return false;
+    }
+
+    return IsCASEAuthMode(aMsgInfo->PeerAuthMode) || IsGroupKeyAuthMode(aMsgInfo->PeerAuthMode);
+}
+
 WEAVE_ERROR BoltLockTraitDataSource::GetLeafData(PropertyPathHandle aLeafHandle, uint64_t aTagToWrite, TLVWriter & aWriter)
 {
     WEAVE_ERROR err = WEAVE_NO_ERROR;
@@ -223,12 +344,32 @@ void BoltLockTraitDataSource::OnCustomCommand(nl::Weave::Profiles::DataManagemen
     WEAVE_ERROR err           = WEAVE_NO_ERROR;
     uint32_t reportProfileId  = nl::Weave::Profiles::kWeaveProfile_Common;
     uint16_t reportStatusCode = nl::Weave::Profiles::Common::kStatus_BadRequest;
+    CommandSource source      = GetCommandSource(aMsgInfo);
+    int64_t initiationTimeUS  = aCommand->IsInitiationTimeValid() ? aCommand->initiationTimeMicroSecond : 0;
+
+    if (!IsAuthenticated(aMsgInfo))
+    {
+        NRF_LOG_INFO("Rejecting unauthenticated %s command", GetCommandSourceName(source));
+
+        Lock();
+        mCommandStats[source].Rejected++;
+        Unlock();
+
+        reportStatusCode = nl::Weave::Profiles::Common::kStatus_AuthenticationRequired;
+        goto exit;
+    }
 
     if (aIsMustBeVersionValid)
     {
         if (aMustBeVersion != GetVersion())
         {
-            NRF_LOG_INFO("Actual version is 0x%X, while must-be version is: 0x%" PRIx64, GetVersion(), aMustBeVersion);
+            char actualVersionStr[kFormatHex64StrSize];
+            char mustBeVersionStr[kFormatHex64StrSize];
+
+            FormatHex(actualVersionStr, sizeof(actualVersionStr), GetVersion());
+            FormatHex(mustBeVersionStr, sizeof(mustBeVersionStr), aMustBeVersion);
+            NRF_LOG_INFO("Actual version is 0x%s, while must-be version is: 0x%s", NRF_LOG_PUSH(actualVersionStr),
+                         NRF_LOG_PUSH(mustBeVersionStr));
             reportProfileId  = nl::Weave::Profiles::kWeaveProfile_WDM;
             reportStatusCode = kStatus_VersionMismatch;
             goto exit;
@@ -317,11 +458,13 @@ void BoltLockTraitDataSource::OnCustomCommand(nl::Weave::Profiles::DataManagemen
 
         if (changeRequestParam_State == BOLT_STATE_RETRACTED)
         {
-            GetAppTask().PostLockActionRequest(changeRequestParam_Actor, BoltLockManager::UNLOCK_ACTION);
+            GetAppTask().PostLockActionRequest(mActuator, changeRequestParam_Actor, BoltLockManager::UNLOCK_ACTION, source,
+                                               initiationTimeUS);
         }
         else if (changeRequestParam_State == BOLT_STATE_EXTENDED)
         {
-            GetAppTask().PostLockActionRequest(changeRequestParam_Actor, BoltLockManager::LOCK_ACTION);
+            GetAppTask().PostLockActionRequest(mActuator, changeRequestParam_Actor, BoltLockManager::LOCK_ACTION, source,
+                                               initiationTimeUS);
         }
         else
         {
@@ -336,7 +479,7 @@ void BoltLockTraitDataSource::OnCustomCommand(nl::Weave::Profiles::DataManagemen
     // Generate a success response right here.
     if (err == WEAVE_NO_ERROR)
     {
-        NRF_LOG_INFO("BoltLockChangeRequest Command Parsed!");
+        NRF_LOG_INFO("BoltLockChangeRequest Command Parsed (%s)!", GetCommandSourceName(source));
 
         PacketBuffer * msgBuf = PacketBuffer::New();
         if (NULL == msgBuf)
@@ -347,6 +490,7 @@ void BoltLockTraitDataSource::OnCustomCommand(nl::Weave::Profiles::DataManagemen
         }
 
         NRF_LOG_INFO("Sending Success Response to BoltLockChangeRequest Command");
+        WdmFeature().RecordCommandAck(aCommand->mEC);
         aCommand->SendResponse(GetVersion(), msgBuf);
         aCommand = NULL;
         msgBuf   = NULL;
@@ -359,6 +503,7 @@ void BoltLockTraitDataSource::OnCustomCommand(nl::Weave::Profiles::DataManagemen
 exit:
     if (NULL != aCommand)
     {
+        WdmFeature().RecordCommandAck(aCommand->mEC);
         aCommand->SendError(reportProfileId, reportStatusCode, err);
         aCommand = NULL;
     }
@@ -26,6 +26,7 @@
 #include <Weave/DeviceLayer/ConfigurationManager.h>
 #include <traits/include/DeviceIdentityTraitDataSource.h>
 #include <schema/include/DeviceIdentityTrait.h>
+#include <FormatUtils.h>
 
 using namespace ::nl::Weave::Profiles::DataManagement_Current;
 using namespace ::nl::Weave::TLV;
@@ -96,18 +97,16 @@ WEAVE_ERROR DeviceIdentityTraitDataSource::GetLeafData(PropertyPathHandle aLeafH
 
         case DeviceIdentityTrait::kPropertyHandle_ManufacturingDate:
         {
-            enum
-            {
-                kDateStrLen = 10 // YYYY-MM-DD
-            };
-            char mfgDateStr[kDateStrLen + 1];
+            char mfgDateStr[kFormatDateStrSize];
+            size_t mfgDateStrLen;
             uint16_t year;
             uint8_t month, dayOfMonth;
             err = ConfigurationMgr().GetManufacturingDate(year, month, dayOfMonth);
             VerifyOrExit(err != WEAVE_DEVICE_ERROR_CONFIG_NOT_FOUND, err = WEAVE_NO_ERROR);
             SuccessOrExit(err);
-            snprintf(mfgDateStr, sizeof(mfgDateStr), "%04" PRIu16 "-%02" PRIu8 "-%02" PRIu8, year, month, dayOfMonth);
-            err = aWriter.PutString(aTagToWrite, mfgDateStr, kDateStrLen);
+            mfgDateStrLen = FormatDate(mfgDateStr, sizeof(mfgDateStr), year, month, dayOfMonth);
+            VerifyOrExit(mfgDateStrLen != 0, err = WEAVE_ERROR_INVALID_ARGUMENT);
+            err = aWriter.PutString(aTagToWrite, mfgDateStr, (uint32_t) mfgDateStrLen);
             SuccessOrExit(err);
             break;
         }
@@ -27,11 +27,43 @@
 
 #include <Weave/Profiles/data-management/DataManagement.h>
 
+/**
+ * Counters for BoltLockChangeRequest commands arriving by one path.  Latency is measured from
+ * the initiation time stamped on the command by its sender (the phone app, for both paths) to
+ * the completion of the lock action, so for service commands it includes the relay through the
+ * service.  It is only measured when the command carries an initiation time and the device
+ * clock is synchronized; both clocks are synchronized to the service, so the skew between them
+ * bounds the accuracy.
+ */
+struct CommandStats
+{
+    uint32_t Completed;      // Commands whose lock action has completed.
+    uint32_t Timed;          // Completed commands whose latency was measured.
+    uint32_t Refused;        // Commands accepted, but refused by the lock because an action was in progress.
+    uint32_t Rejected;       // Commands rejected because the sender was not authenticated as a fabric member.
+    uint32_t TotalLatencyMS; // Sum of the latencies of the timed commands.
+    uint32_t MaxLatencyMS;   // Longest latency of a timed command.
+};
+
 class BoltLockTraitDataSource : public nl::Weave::Profiles::DataManagement::TraitDataSource
 {
 public:
+    /**
+     * The path by which a command reached the device: relayed by the service, or sent
+     * directly by a fabric peer (such as a paired phone) over Thread or WoBLE.
+     */
+    enum CommandSource
+    {
+        kCommandSource_Service = 0,
+        kCommandSource_Local,
+
+        kCommandSource_Count
+    };
+
     BoltLockTraitDataSource();
 
+    void SetActuator(uint8_t aActuator);
+
     bool IsLocked();
     void InitiateLock(int32_t aLockActor);
     void InitiateUnlock(int32_t aLockActor);
@@ -39,6 +71,12 @@ public:
     void LockingSuccessful(void);
     void UnlockingSuccessful(void);
 
+    void StartCommand(CommandSource aSource, int64_t aInitiationTimeUS);
+    void RefuseCommand(CommandSource aSource);
+    void GetCommandStats(CommandSource aSource, CommandStats & aStats);
+
+    static const char * GetCommandSourceName(CommandSource aSource);
+
 private:
     WEAVE_ERROR GetLeafData(::nl::Weave::Profiles::DataManagement_Current::PropertyPathHandle aLeafHandle, uint64_t aTagToWrite,
                             ::nl::Weave::TLV::TLVWriter & aWriter);
@@ -48,10 +86,21 @@ private:
                          const int64_t & aExpiryTimeMicroSecond, const bool aIsMustBeVersionValid, const uint64_t & aMustBeVersion,
                          nl::Weave::TLV::TLVReader & aArgumentReader);
 
+    void CompleteCommand(void);
+
+    static CommandSource GetCommandSource(const nl::Weave::WeaveMessageInfo * aMsgInfo);
+    static bool IsAuthenticated(const nl::Weave::WeaveMessageInfo * aMsgInfo);
+
+    uint8_t mActuator;
     int32_t mLockedState;
     int32_t mLockActor;
     int32_t mActuatorState;
     int32_t mState;
+
+    CommandStats mCommandStats[kCommandSource_Count];
+    bool mIsCommandPending; // A command started the lock action in progress.
+    CommandSource mPendingCommandSource;
+    int64_t mPendingCommandInitiationTimeUS; // Initiation time of that command; 0 if not given.
 };
 
 #endif /* BOLT_LOCK_TRAIT_DATA_SOURCE_H */
@@ -0,0 +1,294 @@
+#!/usr/bin/env python3
+#
+#    Copyright (c) 2019 Google LLC.
+#    All rights reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+
+#
+#    @file
+#          Simulates the app task's dispatch of lock events for a device driving several
+#          bolt lock actuators, and estimates the RAM cost of each actuator.
+#
+#          Models the event flow of main/AppTask.cpp and main/BoltLockManager.cpp for
+#          BOLT_LOCK_ACTUATOR_COUNT = 1 .. N: service commands addressed to one actuator
+#          (lock events), door-wide button presses that operate every actuator, and the
+#          per-actuator movement timers whose expiry is posted back to the app event
+#          queue (APP_EVENT_QUEUE_SIZE = 10 + N entries; posts to a full queue are
+#          dropped).  The app task handles one event at a time; the cost of an event is
+#          a fixed number of cycles plus a cost per actuator for the loops over all
+#          actuators (AreAllLocksLocked(), IsAnyLockActionInProgress() and the button's
+#          door-wide InitiateAction()).  For each actuator count it reports the dispatch
+#          time per event, the deepest queue, dropped events and the command completion
+#          latency.
+#
+#              actuator_sim.py [--max-actuators N] [--burst] [options]
+#              actuator_sim.py --ram-elf COUNT=ELF --ram-elf COUNT=ELF
+#
+#          With --burst every actuator is commanded at the same instant, as when the
+#          service operates all the bolts of a door at once; this is the worst case for
+#          the event queue.  The cycle costs default to rough figures for the nRF52840 at
+#          64 MHz; calibrate them with the DWT cycle counter (see main/support/RunTimeStats.c).
+#
+#          The RAM cost per actuator is estimated from the layout of the per-actuator
+#          structures on a 32-bit ARM target.  Given images built with two or more
+#          actuator counts (--ram-elf), the cost is instead measured from the .data and
+#          .bss sizes reported by arm-none-eabi-size.
+#
+
+import argparse
+import heapq
+import random
+import subprocess
+import sys
+
+CPU_HZ = 64000000
+
+# Per-actuator structures as (field, size, alignment) on a 32-bit ARM target.  The sizes of
+# SDK and Weave types are those of nRF5 SDK 15 and OpenWeave.
+LAYOUTS = {
+    'BoltLockManager': [
+        ('mState', 4, 4),
+        ('mIndex', 1, 1),
+        ('mActionInitiated_CB', 4, 4),
+        ('mActionCompleted_CB', 4, 4),
+        ('mAutoRelock', 1, 1),
+        ('mAutoLockDuration', 4, 4),
+        ('mAutoLockTimerArmed', 1, 1),
+        ('mTimerData', 32, 4),              # app_timer_t (APP_TIMER_NODE_SIZE)
+        ('mTimer', 4, 4),
+    ],
+    'BoltLockTraitDataSource': [
+        ('TraitDataSource', 40, 8),         # vtable, schema engine, version, flags
+        ('mActuator', 1, 1),
+        ('mLockedState', 4, 4),
+        ('mLockActor', 4, 4),
+        ('mActuatorState', 4, 4),
+        ('mState', 4, 4),
+        ('mCommandStats', 2 * 24, 4),       # kCommandSource_Count CommandStats
+        ('mIsCommandPending', 1, 1),
+        ('mPendingCommandSource', 4, 4),
+        ('mPendingCommandInitiationTimeUS', 8, 8),
+    ],
+    'CatalogItem': [
+        ('mInstanceId', 8, 8),
+        ('mItem', 4, 4),
+    ],
+    'AppEvent': [
+        ('Type', 2, 2),
+        ('LockEvent', 24, 8),
+        ('Handler', 4, 4),
+    ],
+}
+
+
+def struct_size(fields):
+    offset = 0
+    max_align = 1
+    for _, size, align in fields:
+        offset = (offset + align - 1) // align * align + size
+        max_align = max(max_align, align)
+    return (offset + max_align - 1) // max_align * max_align
+
+
+def estimated_ram_per_actuator():
+    # One of each structure, plus the event queue slot added to APP_EVENT_QUEUE_SIZE.
+    return sum(struct_size(fields) for fields in LAYOUTS.values())
+
+
+def measured_ram(elfs, size_tool):
+    points = []
+    for spec in elfs:
+        count, path = spec.split('=', 1)
+        out = subprocess.check_output([size_tool, '-A', path]).decode()
+        ram = 0
+        for line in out.splitlines():
+            fields = line.split()
+            if len(fields) >= 2 and fields[0] in ('.data', '.bss'):
+                ram += int(fields[1])
+        points.append((int(count), ram))
+    points.sort()
+    (c0, r0), (c1, r1) = points[0], points[-1]
+    return points, float(r1 - r0) / (c1 - c0)
+
+
+class Sim:
+
+    def __init__(self, actuators, args):
+        self.n = actuators
+        self.args = args
+        self.queue_size = 10 + actuators
+        self.queue = []
+        self.busy_until = 0.0
+        self.timers = []            # (expiry, seq, actuator)
+        self.seq = 0
+        self.in_progress = [False] * actuators
+        self.locked = [True] * actuators
+        self.command_start = [0.0] * actuators
+        self.dispatch_us = []
+        self.latencies_ms = []
+        self.max_depth = 0
+        self.dropped = 0
+
+    def cycles(self, event):
+        a = self.args
+        kind = event[0]
+        if kind == 'lock':
+            # LockActionEventHandler() -> InitiateAction() -> ActionInitiated().
+            return a.event_cycles + a.initiate_cycles
+        if kind == 'button':
+            # AreAllLocksLocked(), then InitiateAction() on every actuator.
+            return a.event_cycles + self.n * (a.scan_cycles + a.initiate_cycles)
+        # ActuatorMovementTimerEventHandler() -> ActionCompleted(): IsAnyLockActionInProgress()
+        # and, once no actuator is moving, AreAllLocksLocked().
+        scans = self.n * 2 if not any(self.in_progress) else self.n
+        return a.event_cycles + a.complete_cycles + scans * a.scan_cycles
+
+    def post(self, t, event):
+        if len(self.queue) >= self.queue_size:
+            self.dropped += 1
+            return
+        self.queue.append((t, event))
+        self.max_depth = max(self.max_depth, len(self.queue))
+
+    def initiate(self, t, actuator, action_locks, start):
+        if self.in_progress[actuator] or self.locked[actuator] == action_locks:
+            return
+        # Latency runs from the arrival of the command that started the action.
+        self.command_start[actuator] = start
+        self.in_progress[actuator] = True
+        self.locked[actuator] = action_locks
+        self.seq += 1
+        heapq.heappush(self.timers, (t + self.args.actuation_ms / 1000.0, self.seq, actuator))
+
+    def handle(self, t, event):
+        kind = event[0]
+        if kind == 'lock':
+            self.initiate(t, event[1], event[2], event[3])
+        elif kind == 'button':
+            action_locks = not all(self.locked)
+            for i in range(self.n):
+                self.initiate(t, i, action_locks, event[3])
+        else:
+            actuator = event[1]
+            self.in_progress[actuator] = False
+            self.latencies_ms.append((t - self.command_start[actuator]) * 1000.0)
+
+    def run(self, arrivals):
+        i = 0
+        while i < len(arrivals) or self.queue or self.timers:
+            # Next external arrival, timer expiry or completion of the event being handled.
+            candidates = []
+            if i < len(arrivals):
+                candidates.append(arrivals[i][0])
+            if self.timers:
+                candidates.append(self.timers[0][0])
+            if self.queue:
+                candidates.append(max(self.busy_until, self.queue[0][0]))
+            t = min(candidates)
+
+            if i < len(arrivals) and arrivals[i][0] == t:
+                self.post(t, arrivals[i][1] + (t,))
+                i += 1
+            elif self.timers and self.timers[0][0] == t:
+                _, _, actuator = heapq.heappop(self.timers)
+                self.post(t, ('timer', actuator, None, t))
+            else:
+                _, event = self.queue.pop(0)
+                us = self.cycles(event) * 1e6 / CPU_HZ
+                self.handle(t, event)
+                self.dispatch_us.append(us)
+                self.busy_until = t + us / 1e6
+
+
+def arrivals_for(actuators, args, rng):
+    events = []
+    if args.burst:
+        for cycle in range(args.bursts):
+            t = cycle * args.burst_interval_s
+            for i in range(actuators):
+                events.append((t, ('lock', i, cycle % 2 == 1)))
+        return events
+    duration = args.hours * 3600.0
+    for i in range(actuators):
+        t = rng.expovariate(args.commands_per_hour / 3600.0)
+        while t < duration:
+            events.append((t, ('lock', i, rng.random() < 0.5)))
+            t += rng.expovariate(args.commands_per_hour / 3600.0)
+    t = rng.expovariate(args.buttons_per_hour / 3600.0)
+    while t < duration:
+        events.append((t, ('button', None, None)))
+        t += rng.expovariate(args.buttons_per_hour / 3600.0)
+    return sorted(events, key=lambda e: e[0])
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    k = min(len(values) - 1, int(round(p / 100.0 * (len(values) - 1))))
+    return values[k]
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Simulate lock event dispatch and RAM cost for several actuators.')
+    parser.add_argument('--max-actuators', type=int, default=8, help='largest actuator count (default: 8)')
+    parser.add_argument('--burst', action='store_true', help='command every actuator at the same instant')
+    parser.add_argument('--bursts', type=int, default=100, help='number of bursts with --burst (default: 100)')
+    parser.add_argument('--burst-interval-s', type=float, default=10, help='time between bursts (default: 10)')
+    parser.add_argument('--hours', type=float, default=24, help='simulated time without --burst (default: 24)')
+    parser.add_argument('--commands-per-hour', type=float, default=20, help='service commands per actuator (default: 20)')
+    parser.add_argument('--buttons-per-hour', type=float, default=4, help='door-wide button presses (default: 4)')
+    parser.add_argument('--seed', type=int, default=1, help='random seed')
+    # Device model; ACTUATOR_MOVEMENT_PERIOS_MS from main/include/app_config.h.
+    parser.add_argument('--actuation-ms', type=float, default=2000)
+    parser.add_argument('--event-cycles', type=int, default=3000, help='fixed cost of dispatching an event')
+    parser.add_argument('--initiate-cycles', type=int, default=4000, help='InitiateAction() incl. trait update')
+    parser.add_argument('--complete-cycles', type=int, default=4000, help='ActionCompleted() incl. trait update')
+    parser.add_argument('--scan-cycles', type=int, default=20, help='one iteration of a loop over the actuators')
+    parser.add_argument('--ram-elf', action='append', default=[], metavar='COUNT=ELF',
+                        help='image built with BOLT_LOCK_ACTUATOR_COUNT=COUNT (give two or more)')
+    parser.add_argument('--size-tool', default='arm-none-eabi-size')
+    args = parser.parse_args(argv[1:])
+
+    if len(args.ram_elf) == 1:
+        parser.error('--ram-elf needs images for at least two actuator counts')
+
+    if args.ram_elf:
+        points, per_actuator = measured_ram(args.ram_elf, args.size_tool)
+        for count, ram in points:
+            print('%2d actuators: %d bytes .data + .bss' % (count, ram))
+        print('RAM per actuator: %.0f bytes (measured)' % per_actuator)
+        return 0
+
+    per_actuator = estimated_ram_per_actuator()
+    for name, fields in sorted(LAYOUTS.items()):
+        print('%-24s %4d bytes' % (name, struct_size(fields)))
+    print('RAM per actuator: %d bytes (estimated)\n' % per_actuator)
+
+    print('%-4s %-8s %-8s %-8s %-8s %-6s %-8s %-10s %s' %
+          ('n', 'events', 'mean us', 'p99 us', 'max us', 'depth', 'dropped', 'p99 ms', 'RAM'))
+    for n in range(1, args.max_actuators + 1):
+        rng = random.Random(args.seed)
+        sim = Sim(n, args)
+        sim.run(arrivals_for(n, args, rng))
+        d = sim.dispatch_us
+        print('%-4d %-8d %-8.1f %-8.1f %-8.1f %-6d %-8d %-10.1f %d' %
+              (n, len(d), sum(d) / len(d) if d else 0.0, percentile(d, 99), max(d) if d else 0.0,
+               sim.max_depth, sim.dropped, percentile(sim.latencies_ms, 99), n * per_actuator))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
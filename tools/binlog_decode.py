@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+#
+#    Copyright (c) 2019 Google LLC.
+#    All rights reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+
+#
+#    @file
+#          Decodes binary log records produced by an application built with LOG_FORMAT=binary.
+#
+#          Capture the raw RTT output of the device to a file (e.g. with JLinkRTTLogger),
+#          then run:
+#
+#              binlog_decode.py [--timestamp-hz HZ] <application ELF file> <capture file>
+#
+#          Format strings and module names are resolved against the ELF file of the image
+#          running on the device; the record format is described in
+#          main/include/BinaryLogBackend.h.
+#
+
+import argparse
+import re
+import struct
+import sys
+
+RECORD_MAGIC = 0xB1
+RECORD_TYPE_MESSAGE = 1
+RECORD_TYPE_HEXDUMP = 2
+RECORD_HEADER_LENGTH = 4
+
+# Records longer than BINARY_LOG_MAX_RECORD_SIZE (main/include/app_config.h) are truncated
+# by the device.
+DEFAULT_MAX_RECORD_SIZE = 256
+
+TRUNCATED = '<truncated>'
+
+SEVERITY_NAMES = {1: 'error', 2: 'warning', 3: 'info', 4: 'debug'}
+
+CONVERSION_RE = re.compile(r'%([-+ #0]*)(\d+)?(?:\.(\d+))?(?:hh|h|ll|l|j|z|t|L)?([diouxXcsp%])')
+
+SHF_ALLOC = 0x2
+SHT_PROGBITS = 1
+
+
+class ElfImage:
+    """Minimal reader for the loadable sections of a 32-bit little-endian ELF file."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF' or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError('%s: not a 32-bit little-endian ELF file' % path)
+        shoff, = struct.unpack_from('<I', self.data, 0x20)
+        shentsize, shnum = struct.unpack_from('<HH', self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            (_, sh_type, sh_flags, sh_addr, sh_offset, sh_size) = struct.unpack_from('<IIIIII', self.data,
+                                                                                   shoff + i * shentsize)
+            if sh_type == SHT_PROGBITS and (sh_flags & SHF_ALLOC) and sh_size:
+                self.sections.append((sh_addr, sh_size, sh_offset))
+
+    def string_at(self, addr):
+        for sh_addr, sh_size, sh_offset in self.sections:
+            if sh_addr <= addr < sh_addr + sh_size:
+                start = sh_offset + addr - sh_addr
+                end = self.data.index(b'\0', start)
+                return self.data[start:end].decode('utf-8', errors='replace')
+        return '<unknown string 0x%08x>' % addr
+
+
+def format_message(fmt, args):
+    """Formats a C printf format string with decoded record arguments."""
+    args = list(args)
+    out = []
+    pos = 0
+    for m in CONVERSION_RE.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, precision, conv = m.groups()
+        if conv == '%':
+            out.append('%')
+            continue
+        if not args:
+            # The record was truncated before this argument.
+            out.append('?')
+            continue
+        value = args.pop(0)
+        spec = '%' + flags + (width or '') + ('.' + precision if precision else '')
+        if conv == 's':
+            out.append((spec + 's') % value)
+        elif conv in 'di':
+            out.append((spec + 'd') % (value - (1 << 32) if value & 0x80000000 else value))
+        elif conv == 'u':
+            out.append((spec + 'd') % value)
+        elif conv == 'c':
+            out.append((spec + 'c') % chr(value & 0xFF))
+        elif conv == 'p':
+            out.append('0x%08x' % value)
+        else:
+            out.append((spec + conv) % value)
+    out.append(fmt[pos:])
+    return ''.join(out)
+
+
+def decode_args(body, offset, convs, nargs):
+    """Decodes up to nargs message arguments; returns the arguments and whether the record was truncated."""
+    args = []
+    for i in range(nargs):
+        if i < len(convs) and convs[i] == 's':
+            if offset >= len(body):
+                return args, True
+            slen = body[offset]
+            value = body[offset + 1:offset + 1 + slen].decode('utf-8', errors='replace')
+            if offset + 1 + slen > len(body):
+                args.append(value + TRUNCATED)
+                return args, True
+            args.append(value)
+            offset += 1 + slen
+        else:
+            if offset + 4 > len(body):
+                return args, True
+            args.append(struct.unpack_from('<I', body, offset)[0])
+            offset += 4
+    return args, False
+
+
+def decode_records(data, elf, max_record_size=DEFAULT_MAX_RECORD_SIZE):
+    pos = 0
+    while pos + 4 <= len(data):
+        if data[pos] != RECORD_MAGIC or data[pos + 1] not in (RECORD_TYPE_MESSAGE, RECORD_TYPE_HEXDUMP):
+            # Not at a record boundary (e.g. the capture started mid-record); resynchronize.
+            pos += 1
+            continue
+        rtype = data[pos + 1]
+        length, = struct.unpack_from('<H', data, pos + 2)
+        body = data[pos + 4:pos + 4 + length]
+        pos += 4 + length
+        if len(body) < length or length < 12:
+            break
+
+        timestamp, module_addr, dropped, severity, nargs = struct.unpack_from('<IIHBB', body, 0)
+        module = elf.string_at(module_addr)
+        offset = 12
+
+        if rtype == RECORD_TYPE_MESSAGE:
+            if offset + 4 > length:
+                yield timestamp, SEVERITY_NAMES.get(severity, str(severity)), module, dropped, TRUNCATED
+                continue
+            fmt_addr, = struct.unpack_from('<I', body, offset)
+            offset += 4
+            fmt = elf.string_at(fmt_addr)
+            convs = [m.group(4) for m in CONVERSION_RE.finditer(fmt) if m.group(4) != '%']
+            args, truncated = decode_args(body, offset, convs, nargs)
+            text = format_message(fmt, args)
+            if truncated:
+                text += ' ' + TRUNCATED
+        else:
+            text = ' '.join('%02x' % b for b in body[offset:])
+            # The device does not mark a truncated dump; a full record may have been cut short.
+            if RECORD_HEADER_LENGTH + length >= max_record_size:
+                text += ' ' + TRUNCATED
+
+        yield timestamp, SEVERITY_NAMES.get(severity, str(severity)), module, dropped, text
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Decode binary nrf_log records.')
+    parser.add_argument('--timestamp-hz', type=int, default=1000,
+                        help='log timestamp frequency (default: 1000, see LOG_TIMESTAMP_FREQ in main.cpp)')
+    parser.add_argument('--max-record-size', type=int, default=DEFAULT_MAX_RECORD_SIZE,
+                        help='BINARY_LOG_MAX_RECORD_SIZE of the image (default: %d)' % DEFAULT_MAX_RECORD_SIZE)
+    parser.add_argument('elf', help='application ELF file')
+    parser.add_argument('capture', help='raw RTT capture')
+    args = parser.parse_args(argv[1:])
+
+    elf = ElfImage(args.elf)
+    with open(args.capture, 'rb') as f:
+        data = f.read()
+
+    for timestamp, severity, module, dropped, text in decode_records(data, elf, args.max_record_size):
+        if dropped:
+            print('<%d log entries dropped>' % dropped)
+        ms = timestamp * 1000 // args.timestamp_hz if args.timestamp_hz else 0
+        print('[%08d] <%s> %s: %s' % (ms, severity, module, text))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+#
+#    Copyright (c) 2019 Google LLC.
+#    All rights reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+
+#
+#    @file
+#          Simulates WoBLE provisioning against a simulated central, with and without
+#          the connection parameter policy of main/BLEConnectionPolicy.cpp.
+#
+#          A provisioning session is a sequence of WoBLE messages between the central
+#          (the phone app) and the device, with the device's processing time and the
+#          time spent joining the Thread network and registering with the service in
+#          between.  Each message is fragmented into ATT PDUs of ATT_MTU - 3 bytes less
+#          the WoBLE header.  The central writes with Write Requests and the device sends
+#          indications, so each PDU is acknowledged at the ATT layer and at most one is
+#          sent per connection event and direction; a PDU longer than the link layer
+#          data length is split into several link layer packets, of which the central
+#          allows only a few per connection event.
+#
+#          The central connects with its own interval and the 1M PHY.  With the policy,
+#          the device requests the 2M PHY and an interval in [BLE_CONN_FAST_MIN_INTERVAL_MS,
+#          BLE_CONN_FAST_MAX_INTERVAL_MS] as soon as it is connected; the requests take
+#          effect --procedure-events connection events later (including the retry after
+#          the GATT module's MTU and data length procedures) if the central supports
+#          them.  The central picks the lowest interval it supports in the requested range.
+#
+#          For each central and policy the simulator reports the values recorded by the
+#          device for a provisioning connection (see Diagnostics::ReportBLE()): the time
+#          from connection to provisioning and the bytes written by the central, plus the
+#          time spent on the air interface and the resulting throughput.
+#
+#              ble_transfer_sim.py [--central NAME] [options]
+#
+
+import argparse
+import math
+import sys
+
+# Connection parameters requested while provisioning; from main/include/app_config.h.
+FAST_MIN_INTERVAL_MS = 15
+FAST_MAX_INTERVAL_MS = 30
+
+# NRF_SDH_BLE_GATT_MAX_MTU_SIZE and NRF_SDH_BLE_GAP_DATA_LENGTH.
+DEVICE_MTU = 251
+DEVICE_DATA_LENGTH = 251
+
+WOBLE_HEADER = 3
+L2CAP_HEADER = 4
+
+# Simulated centrals: connection interval at connection, shortest interval accepted, 2M PHY
+# support, ATT MTU, link layer data length and link layer packets per connection event.
+CENTRALS = {
+    'ios': dict(interval_ms=30, min_interval_ms=15, phy_2m=True, mtu=185, data_length=251, packets_per_event=4),
+    'android': dict(interval_ms=45, min_interval_ms=7.5, phy_2m=True, mtu=517, data_length=251, packets_per_event=6),
+    'legacy': dict(interval_ms=50, min_interval_ms=7.5, phy_2m=False, mtu=23, data_length=27, packets_per_event=2),
+}
+
+# Provisioning session: (sender, message bytes, device processing before the next message).
+# The device processing times are filled in from the options.
+SESSION = [
+    ('central', 120, None),     # PASE step 1
+    ('device', 140, 'pase'),    # PASE step 2
+    ('central', 90, None),      # PASE step 3
+    ('device', 40, 'pase'),     # PASE step 4
+    ('central', 40, None),      # ArmFailSafe
+    ('device', 20, None),
+    ('central', 220, None),     # AddNetwork
+    ('device', 20, None),
+    ('central', 20, None),      # EnableNetwork
+    ('device', 20, 'join'),
+    ('central', 1200, None),    # RegisterServicePairAccount (service config and account token)
+    ('device', 20, 'service'),
+    ('central', 20, None),      # DisarmFailSafe
+    ('device', 20, None),
+]
+
+
+class Link:
+
+    def __init__(self, central, use_policy, args):
+        self.central = central
+        self.use_policy = use_policy
+        self.args = args
+        self.mtu = min(central['mtu'], DEVICE_MTU)
+        self.data_length = min(central['data_length'], DEVICE_DATA_LENGTH)
+        self.fast_interval_ms = None
+        if use_policy and central['min_interval_ms'] <= FAST_MAX_INTERVAL_MS:
+            self.fast_interval_ms = max(FAST_MIN_INTERVAL_MS, math.ceil(central['min_interval_ms'] / 1.25) * 1.25)
+        self.updated_ms = central['interval_ms'] * args.procedure_events
+
+    def interval_ms(self, t):
+        if self.fast_interval_ms is not None and t >= self.updated_ms:
+            return self.fast_interval_ms
+        return self.central['interval_ms']
+
+    def phy_mbps(self, t):
+        if self.use_policy and self.central['phy_2m'] and t >= self.updated_ms:
+            return 2.0
+        return 1.0
+
+    def next_event(self, t):
+        # Connection events are spaced by the interval in force.
+        interval = self.interval_ms(t)
+        return (math.floor(t / interval) + 1) * interval
+
+    def send(self, t, size):
+        # Returns the time at which the whole message has been acknowledged.
+        payload = self.mtu - 3 - WOBLE_HEADER
+        remaining = size
+        air_ms = 0.0
+        while remaining > 0:
+            chunk = min(payload, remaining)
+            remaining -= chunk
+            pdu = chunk + WOBLE_HEADER + 3
+            packets = int(math.ceil((pdu + L2CAP_HEADER) / float(self.data_length)))
+            events = int(math.ceil(packets / float(self.central['packets_per_event'])))
+            for _ in range(events):
+                t = self.next_event(t)
+                # Data packets plus link layer header, CRC and preamble, and the empty acknowledgement.
+                air_ms += (min(pdu + L2CAP_HEADER, self.data_length) + 10 + 10) * 8 / (self.phy_mbps(t) * 1000.0)
+            # The ATT response or confirmation travels in the following connection event.
+            t = self.next_event(t)
+        return t, air_ms
+
+
+def provision(central, use_policy, args):
+    link = Link(central, use_policy, args)
+    processing = {None: 0.0, 'pase': args.pase_ms, 'join': args.join_ms, 'service': args.service_ms}
+    t = 0.0
+    air_ms = 0.0
+    waiting_ms = 0.0
+    rx_bytes = 0
+    for sender, size, step in SESSION:
+        t, air = link.send(t, size)
+        air_ms += air
+        if sender == 'central':
+            rx_bytes += size
+        t += processing[step]
+        waiting_ms += processing[step]
+    return t, t - waiting_ms, rx_bytes, air_ms, link
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Simulate WoBLE provisioning against simulated centrals.')
+    parser.add_argument('--central', choices=sorted(CENTRALS), action='append',
+                        help='central to simulate (default: all)')
+    parser.add_argument('--procedure-events', type=int, default=10,
+                        help='connection events until the PHY and interval updates take effect (default: 10)')
+    parser.add_argument('--pase-ms', type=float, default=1500, help='device PASE processing per step (default: 1500)')
+    parser.add_argument('--join-ms', type=float, default=3000, help='Thread network join (default: 3000)')
+    parser.add_argument('--service-ms', type=float, default=2500, help='service registration (default: 2500)')
+    args = parser.parse_args(argv[1:])
+
+    print('%-8s %-7s %-9s %-5s %-10s %-10s %-8s %-8s %s' %
+          ('central', 'policy', 'interval', 'PHY', 'prov ms', 'xfer ms', 'rx B', 'air ms', 'B/s'))
+    for name in args.central or sorted(CENTRALS):
+        central = CENTRALS[name]
+        for use_policy in (False, True):
+            total_ms, transfer_ms, rx_bytes, air_ms, link = provision(central, use_policy, args)
+            total_bytes = sum(size for _, size, _ in SESSION)
+            print('%-8s %-7s %-9s %-5s %-10.0f %-10.0f %-8d %-8.1f %.0f' %
+                  (name, 'fast' if use_policy else 'none', '%g ms' % link.interval_ms(total_ms),
+                   '%gM' % link.phy_mbps(total_ms), total_ms, transfer_ms, rx_bytes, air_ms,
+                   total_bytes * 1000.0 / transfer_ms))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
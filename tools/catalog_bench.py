@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+#
+#    Copyright (c) 2019 Google LLC.
+#    All rights reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+
+#
+#    @file
+#          Benchmarks the WDM source trait catalog as the number of published traits grows.
+#
+#          Models the SingleResourceSourceTraitCatalog used by main/WDMFeature.cpp, whose
+#          items are stored in an array indexed by trait data handle (handles are assigned
+#          in registration order by WDMFeature::RegisterSourceTrait()), and counts the
+#          catalog items visited by the operations on the request and notify paths:
+#
+#              Locate(handle)      trait data handle to trait source (command and
+#                                  notify paths)
+#              HandleToAddress     trait data handle to path (building notifications)
+#              AddressToHandle     path (profile id, instance id) to trait data handle
+#                                  (incoming commands and subscribe requests)
+#              Locate(source)      trait source to trait data handle (SetDirty())
+#              Iterate             every item (subscribe and notify paths)
+#
+#          and a notify pass that, as the notification engine does for a subscription
+#          covering every published trait, checks each trait for changes and encodes the
+#          changed ones.  The visit counts are converted to cycles with --visit-cycles
+#          and --encode-cycles (defaults are rough figures for the nRF52840; calibrate
+#          them with the DWT cycle counter), and the host time of a Python model of each
+#          operation is reported alongside.
+#
+#              catalog_bench.py [--counts 3,4,8,16,32,64] [--dirty K] [options]
+#
+
+import argparse
+import random
+import sys
+import timeit
+
+# SingleResourceSourceTraitCatalog::CatalogItem: a 64-bit instance id and a pointer.
+ITEM_BYTES = 16
+
+
+class Catalog:
+
+    def __init__(self, traits):
+        # Item i is the trait registered with handle i: (profile id, instance id).
+        self.items = traits
+        self.visits = 0
+
+    def locate_handle(self, handle):
+        self.visits += 1
+        return self.items[handle] if handle < len(self.items) else None
+
+    def handle_to_address(self, handle):
+        self.visits += 1
+        return self.items[handle]
+
+    def address_to_handle(self, profile_id, instance_id):
+        for handle, item in enumerate(self.items):
+            self.visits += 1
+            if item == (profile_id, instance_id):
+                return handle
+        return None
+
+    def locate_source(self, trait):
+        for handle, item in enumerate(self.items):
+            self.visits += 1
+            if item is trait:
+                return handle
+        return None
+
+    def iterate(self, callback):
+        for handle in range(len(self.items)):
+            self.visits += 1
+            callback(handle)
+
+    def notify(self, dirty):
+        encoded = []
+
+        def check(handle):
+            if handle in dirty:
+                self.handle_to_address(handle)
+                encoded.append(handle)
+
+        self.iterate(check)
+        return encoded
+
+
+def make_traits(count):
+    # A few traits with several instances, as for a device with several bolt lock actuators.
+    traits = []
+    profile = 0x0E01
+    while len(traits) < count:
+        for instance in range(min(4, count - len(traits))):
+            traits.append((profile, instance))
+        profile += 1
+    return traits
+
+
+def average_visits(catalog, operation, args_list):
+    catalog.visits = 0
+    for args in args_list:
+        operation(*args)
+    return float(catalog.visits) / len(args_list)
+
+
+def host_us(stmt, number):
+    return min(timeit.repeat(stmt, number=number, repeat=3)) * 1e6 / number
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Benchmark WDM trait catalog lookups and notify-path iteration.')
+    parser.add_argument('--counts', default='3,4,8,16,32,64', help='trait counts (default: 3,4,8,16,32,64)')
+    parser.add_argument('--dirty', type=int, default=1, help='traits changed per notification (default: 1)')
+    parser.add_argument('--visit-cycles', type=int, default=12, help='target cycles per catalog item visited')
+    parser.add_argument('--encode-cycles', type=int, default=6000, help='target cycles to encode one changed trait')
+    parser.add_argument('--iterations', type=int, default=2000, help='host iterations per measurement')
+    parser.add_argument('--seed', type=int, default=1, help='random seed')
+    args = parser.parse_args(argv[1:])
+
+    counts = [int(c) for c in args.counts.split(',')]
+    rng = random.Random(args.seed)
+
+    print('Catalog items visited per operation; target cycles at --visit-cycles %d, --encode-cycles %d' %
+          (args.visit_cycles, args.encode_cycles))
+    print('%-6s %-8s %-8s %-8s %-8s %-8s %-10s %-10s %s' %
+          ('traits', 'by hdl', 'to addr', 'by addr', 'by src', 'notify', 'notify cyc', 'notify us', 'RAM'))
+    for count in counts:
+        traits = make_traits(count)
+        catalog = Catalog(traits)
+        handles = [(rng.randrange(count),) for _ in range(args.iterations)]
+        addresses = [traits[h] for (h,) in handles]
+        sources = [(traits[h],) for (h,) in handles]
+        dirty = set(rng.sample(range(count), min(args.dirty, count)))
+
+        by_handle = average_visits(catalog, catalog.locate_handle, handles)
+        to_address = average_visits(catalog, catalog.handle_to_address, handles)
+        by_address = average_visits(catalog, catalog.address_to_handle, addresses)
+        by_source = average_visits(catalog, catalog.locate_source, sources)
+        notify = average_visits(catalog, catalog.notify, [(dirty,)])
+
+        notify_cycles = notify * args.visit_cycles + len(dirty) * args.encode_cycles
+        notify_host = host_us(lambda: catalog.notify(dirty), args.iterations)
+
+        print('%-6d %-8.1f %-8.1f %-8.1f %-8.1f %-8.1f %-10.0f %-10.2f %d' %
+              (count, by_handle, to_address, by_address, by_source, notify, notify_cycles, notify_host,
+               count * ITEM_BYTES))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
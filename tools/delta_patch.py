@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+#
+#    Copyright (c) 2019 Google LLC.
+#    All rights reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+
+#
+#    @file
+#          Generates and applies delta software update images for the lock example.
+#
+#          The patch format is described in main/include/DeltaPatcher.h.  The source
+#          image must be the exact application binary (.bin) running on the device.
+#
+#          Usage:
+#              delta_patch.py create <source.bin> <target.bin> <patch.bin>
+#              delta_patch.py apply <source.bin> <patch.bin> <target.bin>
+#
+
+import hashlib
+import struct
+import sys
+
+MAGIC = 0x544C4457  # 'WDLT'
+VERSION = 1
+HEADER_FORMAT = '<IHHII32s32s'
+CONTROL_FORMAT = '<IIi'
+MATCH_LEN = 8        # Minimum exact match used to seed a diff region.
+MAX_RUN = 128        # Maximum length of a single diff run.
+EXTEND_SLACK = 64    # Stop extending a match after this many bytes without improvement.
+
+USAGE = '''usage:
+    delta_patch.py create <source.bin> <target.bin> <patch.bin>
+    delta_patch.py apply <source.bin> <patch.bin> <target.bin>
+'''
+
+
+def build_index(source):
+    index = {}
+    for i in range(len(source) - MATCH_LEN + 1):
+        index[source[i:i + MATCH_LEN]] = i
+    return index
+
+
+def extend_match(source, s, target, t):
+    # Extend an approximate match in the manner of bsdiff: choose the length that
+    # maximises (matching bytes - mismatching bytes).
+    best_len = 0
+    best_score = 0
+    score = 0
+    i = 0
+    while s + i < len(source) and t + i < len(target):
+        score += 1 if source[s + i] == target[t + i] else -1
+        i += 1
+        if score > best_score:
+            best_score, best_len = score, i
+        elif i - best_len > EXTEND_SLACK:
+            break
+    return best_len
+
+
+def find_match(source, index, target, t, expected):
+    # Prefer continuing at the expected source position (i.e. the code simply moved),
+    # otherwise look the position up in the index.
+    while t + MATCH_LEN <= len(target):
+        key = target[t:t + MATCH_LEN]
+        if 0 <= expected and source[expected:expected + MATCH_LEN] == key:
+            return expected, t
+        s = index.get(key)
+        if s is not None:
+            return s, t
+        t += 1
+        expected += 1
+    return None
+
+
+def encode_diff(source, s, target, t, length):
+    out = bytearray()
+    i = 0
+    while i < length:
+        if source[s + i] == target[t + i] and i + 1 < length and source[s + i + 1] == target[t + i + 1]:
+            n = 0
+            while i + n < length and n < MAX_RUN and source[s + i + n] == target[t + i + n]:
+                n += 1
+            out.append(0x80 | (n - 1))
+        else:
+            n = 0
+            while i + n < length and n < MAX_RUN:
+                if n > 0 and i + n + 1 < length and source[s + i + n] == target[t + i + n] and \
+                        source[s + i + n + 1] == target[t + i + n + 1]:
+                    break
+                n += 1
+            out.append(n - 1)
+            out += bytes((target[t + i + k] - source[s + i + k]) & 0xFF for k in range(n))
+        i += n
+    return bytes(out)
+
+
+def create_patch(source, target):
+    index = build_index(source)
+    body = bytearray()
+
+    src_pos = 0
+    tgt_pos = 0
+    match = find_match(source, index, target, 0, 0)
+
+    while tgt_pos < len(target):
+        diff_len = 0
+        if match is not None and match[1] == tgt_pos:
+            diff_len = extend_match(source, match[0], target, tgt_pos)
+            src_pos = match[0]
+
+        next_match = find_match(source, index, target, tgt_pos + diff_len, src_pos + diff_len)
+        extra_end = next_match[1] if next_match is not None else len(target)
+        next_src = next_match[0] if next_match is not None else src_pos + diff_len
+
+        body += struct.pack(CONTROL_FORMAT, diff_len, extra_end - tgt_pos - diff_len, next_src - src_pos - diff_len)
+        body += encode_diff(source, src_pos, target, tgt_pos, diff_len)
+        body += target[tgt_pos + diff_len:extra_end]
+
+        src_pos = next_src
+        tgt_pos = extra_end
+        match = next_match
+
+    header = struct.pack(HEADER_FORMAT, MAGIC, VERSION, 0, len(source), len(target),
+                         hashlib.sha256(source).digest(), hashlib.sha256(target).digest())
+    return header + bytes(body)
+
+
+def apply_patch(source, patch):
+    header_len = struct.calcsize(HEADER_FORMAT)
+    magic, version, _, source_len, target_len, source_hash, target_hash = \
+        struct.unpack_from(HEADER_FORMAT, patch, 0)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError('not a version %d delta image' % VERSION)
+    if source_len > len(source) or hashlib.sha256(source[:source_len]).digest() != source_hash:
+        raise ValueError('delta image does not apply to this source image')
+
+    target = bytearray()
+    pos = header_len
+    src_pos = 0
+    while len(target) < target_len:
+        diff_len, extra_len, seek = struct.unpack_from(CONTROL_FORMAT, patch, pos)
+        pos += struct.calcsize(CONTROL_FORMAT)
+        remaining = diff_len
+        while remaining > 0:
+            token = patch[pos]
+            pos += 1
+            n = (token & 0x7F) + 1
+            if token & 0x80:
+                target += source[src_pos:src_pos + n]
+            else:
+                target += bytes((source[src_pos + k] + patch[pos + k]) & 0xFF for k in range(n))
+                pos += n
+            src_pos += n
+            remaining -= n
+        target += patch[pos:pos + extra_len]
+        pos += extra_len
+        src_pos += seek
+
+    if pos != len(patch) or hashlib.sha256(target).digest() != target_hash:
+        raise ValueError('reconstructed image does not match target hash')
+    return bytes(target)
+
+
+def main(argv):
+    if len(argv) != 5 or argv[1] not in ('create', 'apply'):
+        sys.stderr.write(USAGE)
+        return 2
+
+    with open(argv[2], 'rb') as f:
+        source = f.read()
+    with open(argv[3], 'rb') as f:
+        second = f.read()
+
+    if argv[1] == 'create':
+        result = create_patch(source, second)
+        # Always check that the patch reproduces the target before emitting it.
+        apply_patch(source, result)
+        sys.stdout.write('%d byte target -> %d byte delta image (%.1f%%)\n' %
+                         (len(second), len(result), 100.0 * len(result) / max(len(second), 1)))
+    else:
+        result = apply_patch(source, second)
+
+    with open(argv[4], 'wb') as f:
+        f.write(result)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+#
+#    Copyright (c) 2019 Google LLC.
+#    All rights reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+
+#
+#    @file
+#          Estimates the daily keep-alive traffic of service subscription liveness settings.
+#
+#          Models the liveness policy implemented by main/LivenessPolicy.cpp, together with
+#          the fixed 60 second timeout it replaces.  The device holds two subscriptions
+#          with the service: its subscription to the service and the service's
+#          counter-subscription to the device.  The publisher of each sends an empty
+#          notify whenever the liveness timeout passes without other traffic on that
+#          subscription.  Lock operations generate notifies on the counter-subscription,
+#          which restart its liveness timer.
+#
+#              liveness_sim.py [options]
+#
+#          Reports, for each policy and power state, the number of keep-alive exchanges
+#          and messages per day, averaged over --days simulated days.
+#
+
+import argparse
+import random
+import sys
+
+DAY_S = 24 * 60 * 60
+
+
+def keepalives(timeout_s, traffic, duration_s):
+    """Counts the keep-alives sent on a subscription with the given traffic times."""
+    count = 0
+    last = 0.0
+    for t in traffic + [duration_s]:
+        count += int((t - last) // timeout_s)
+        last = t
+    return count
+
+
+def lock_traffic(days, per_day, rng):
+    events = []
+    for day in range(days):
+        for _ in range(rng.randint(max(0, per_day - 2), per_day + 2)):
+            events.append(day * DAY_S + rng.uniform(0, DAY_S))
+    return sorted(events)
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Estimate subscription keep-alive traffic per liveness policy.')
+    parser.add_argument('--days', type=int, default=30, help='number of days to simulate (default: 30)')
+    parser.add_argument('--seed', type=int, default=1, help='random seed')
+    parser.add_argument('--locks-per-day', type=int, default=8, help='average lock operations per day (default: 8)')
+    parser.add_argument('--msgs-per-keepalive', type=int, default=2,
+                        help='messages per keep-alive exchange: notify and status report (default: 2)')
+    # Policy parameters; the defaults match main/include/app_config.h.
+    parser.add_argument('--fixed-s', type=int, default=60)
+    parser.add_argument('--external-s', type=int, default=60)
+    parser.add_argument('--battery-s', type=int, default=15 * 60)
+    parser.add_argument('--low-battery-s', type=int, default=60 * 60)
+    args = parser.parse_args(argv[1:])
+
+    rng = random.Random(args.seed)
+    duration = args.days * DAY_S
+    locks = lock_traffic(args.days, args.locks_per_day, rng)
+
+    rows = [
+        ('fixed', 'any', args.fixed_s),
+        ('adaptive', 'external', args.external_s),
+        ('adaptive', 'battery', args.battery_s),
+        ('adaptive', 'low battery', args.low_battery_s),
+    ]
+
+    print('%-9s %-12s %-9s %-14s %s' % ('policy', 'power state', 'timeout', 'keep-alives/d', 'messages/d'))
+    for policy, state, timeout in rows:
+        # Subscription to the service: no device-driven traffic.  Counter-subscription: lock notifies.
+        total = keepalives(timeout, [], duration) + keepalives(timeout, locks, duration)
+        per_day = total / float(args.days)
+        print('%-9s %-12s %-9s %-14.1f %.1f' % (policy, state, '%d s' % timeout, per_day, per_day * args.msgs_per_keepalive))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+#
+#    Copyright (c) 2019 Google LLC.
+#    All rights reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+
+#
+#    @file
+#          Recommends nRF5 SDK mem_manager pool sizes from captured allocation traces.
+#
+#          Build the application with MEM_MANAGER_MONITOR_TRACE=1, capture the device
+#          log (RTT or UART) while exercising the device, then run:
+#
+#              mem_pool_sizing.py [--class SIZE:COUNT ...] <log file> ...
+#
+#          The --class options describe the configured pools (default: the values in
+#          main/include/app_config.h).  The trace is replayed against a model of
+#          mem_manager (smallest suitable pool first, then larger pools), and the peak
+#          demand per class is reported along with a recommended configuration.
+#
+
+import argparse
+import re
+import sys
+
+DEFAULT_CLASSES = ['32:4', '256:4', '1024:1']
+
+TRACE_RE = re.compile(r'memtrace ([af]) (?:(\d+) )?(0x[0-9A-Fa-f]+)')
+
+
+def parse_class(text):
+    size, count = text.split(':')
+    return int(size), int(count)
+
+
+def replay(lines, classes):
+    in_use = [0] * len(classes)
+    peak_in_use = [0] * len(classes)
+    outstanding = [0] * len(classes)
+    peak_demand = [0] * len(classes)
+    max_request = [0] * len(classes)
+    failures = [0] * len(classes)
+    live = {}
+
+    for line in lines:
+        m = TRACE_RE.search(line)
+        if m is None:
+            continue
+        op, size, addr = m.group(1), m.group(2), int(m.group(3), 16)
+
+        if op == 'a':
+            size = int(size)
+            demand_class = next((i for i, (bs, _) in enumerate(classes) if size <= bs), len(classes) - 1)
+            max_request[demand_class] = max(max_request[demand_class], size)
+            if addr == 0:
+                failures[demand_class] += 1
+                peak_demand[demand_class] = max(peak_demand[demand_class], outstanding[demand_class] + 1)
+                continue
+            outstanding[demand_class] += 1
+            peak_demand[demand_class] = max(peak_demand[demand_class], outstanding[demand_class])
+
+            # Model where mem_manager placed the block.
+            pool = next((i for i, (bs, count) in enumerate(classes) if size <= bs and in_use[i] < count), None)
+            if pool is not None:
+                in_use[pool] += 1
+                peak_in_use[pool] = max(peak_in_use[pool], in_use[pool])
+            live[addr] = (demand_class, pool)
+        else:
+            entry = live.pop(addr, None)
+            if entry is None:
+                continue
+            demand_class, pool = entry
+            outstanding[demand_class] -= 1
+            if pool is not None:
+                in_use[pool] -= 1
+
+    return peak_in_use, peak_demand, max_request, failures
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Recommend mem_manager pool sizes from memtrace logs.')
+    parser.add_argument('--class', dest='classes', action='append', metavar='SIZE:COUNT',
+                        help='configured pool (block size and count), smallest first')
+    parser.add_argument('logs', nargs='+', help='device log files containing memtrace lines')
+    args = parser.parse_args(argv[1:])
+
+    classes = [parse_class(c) for c in (args.classes or DEFAULT_CLASSES)]
+
+    lines = []
+    for path in args.logs:
+        with open(path, errors='replace') as f:
+            lines.extend(f.readlines())
+
+    peak_in_use, peak_demand, max_request, failures = replay(lines, classes)
+
+    configured_ram = sum(size * count for size, count in classes)
+    recommended_ram = 0
+
+    print('%-6s %-8s %-10s %-11s %-11s %-8s %s' %
+          ('class', 'config', 'peak pool', 'peak demand', 'max request', 'failures', 'recommended'))
+    for i, (size, count) in enumerate(classes):
+        # Enough blocks for the peak demand (plus headroom if requests failed), each just large
+        # enough for the largest request seen in the class.
+        rec_count = peak_demand[i] + (1 if failures[i] else 0)
+        rec_size = (max_request[i] + 3) & ~3 if max_request[i] else size
+        recommended_ram += rec_size * rec_count
+        print('%-6d %-8s %-10d %-11d %-11d %-8d %d x %d' %
+              (i, '%dx%d' % (count, size), peak_in_use[i], peak_demand[i], max_request[i], failures[i],
+               rec_count, rec_size))
+
+    print('RAM: configured %d bytes, recommended %d bytes (%+d)' %
+          (configured_ram, recommended_ram, recommended_ram - configured_ram))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
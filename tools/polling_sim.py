@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+#
+#    Copyright (c) 2019 Google LLC.
+#    All rights reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+
+#
+#    @file
+#          Simulates Thread polling policies against traffic traces.
+#
+#          Models the adaptive policy implemented by main/ThreadPollingPolicy.cpp (and a
+#          fixed-interval policy for comparison) and reports, for each, the average
+#          current of the sleepy end device and the latency percentiles of commands
+#          sent by the service.  A command sent to the device waits in the parent until
+#          the device next polls, so its latency is the time to the next poll.
+#
+#              polling_sim.py [options] <trace file> ...
+#              polling_sim.py [options] --synthetic DAYS
+#
+#          A trace file contains one event per line, "<time in seconds> <event>", where
+#          event is one of:
+#
+#              command     a lock/unlock command sent by the service
+#              local       a lock/unlock operated at the device (button, keypad)
+#              subscribe   service subscription setup
+#              ota_start   start of a software update download
+#              ota_end     end of a software update download
+#
+#          The current model is deliberately simple: a constant sleep current plus a
+#          fixed charge per data poll.  The defaults approximate an nRF52840 sleepy end
+#          device; adjust them with --sleep-ua and --poll-uc to match measurements.
+#
+
+import argparse
+import random
+import sys
+
+DAY_S = 24 * 60 * 60
+
+EVENTS = ('command', 'local', 'subscribe', 'ota_start', 'ota_end')
+
+
+def load_trace(paths):
+    events = []
+    for path in paths:
+        with open(path) as f:
+            for lineno, line in enumerate(f, 1):
+                line = line.split('#', 1)[0].strip()
+                if not line:
+                    continue
+                time_s, event = line.split()
+                if event not in EVENTS:
+                    raise ValueError('%s:%d: unknown event %s' % (path, lineno, event))
+                events.append((float(time_s), event))
+    return sorted(events)
+
+
+def synthetic_trace(days, seed):
+    # Habitual unlocks in the morning and evening, a few random remote commands each day,
+    # a resubscription every few hours and a weekly software update.
+    rng = random.Random(seed)
+    events = []
+    for day in range(days):
+        base = day * DAY_S
+        events.append((base + 7.5 * 3600 + rng.gauss(0, 600), 'local'))
+        events.append((base + 18 * 3600 + rng.gauss(0, 900), 'command'))
+        events.append((base + 18 * 3600 + rng.gauss(120, 60), 'local'))
+        for _ in range(rng.randint(0, 3)):
+            events.append((base + rng.uniform(0, DAY_S), 'command'))
+        for hour in range(0, 24, 6):
+            events.append((base + hour * 3600 + rng.uniform(0, 60), 'subscribe'))
+        if day % 7 == 3:
+            start = base + 3 * 3600
+            events.append((start, 'ota_start'))
+            events.append((start + 600, 'ota_end'))
+    return sorted(e for e in events if e[0] >= 0)
+
+
+class FixedPolicy:
+    name = 'fixed'
+
+    def __init__(self, args):
+        self.interval = args.inactive_ms / 1000.0
+        self.ota_interval = args.ota_ms / 1000.0
+        self.ota = False
+
+    def event(self, t, event):
+        if event == 'ota_start':
+            self.ota = True
+        elif event == 'ota_end':
+            self.ota = False
+
+    def interval_at(self, t):
+        return self.ota_interval if self.ota else self.interval
+
+
+class AdaptivePolicy:
+    name = 'adaptive'
+
+    def __init__(self, args):
+        self.args = args
+        self.active = {}            # activity -> deadline (None = until ended)
+        self.idle_since = 0.0
+        self.window_s = DAY_S / args.window_count
+        self.scores = [0] * args.window_count
+        self.current_window = 0
+
+    def window(self, t):
+        return int(t // self.window_s) % self.args.window_count
+
+    def begin(self, activity, t, max_duration):
+        self.active[activity] = (t + max_duration) if max_duration else None
+
+    def end(self, activity, t, linger):
+        if activity in self.active:
+            self.active[activity] = t + linger
+
+    def event(self, t, event):
+        a = self.args
+        if event in ('command', 'local'):
+            w = self.window(t)
+            self.scores[w] = min(255, self.scores[w] + a.window_increment)
+            self.begin('lock', t, a.max_duration_s)
+            self.end('lock', t + a.actuation_s, a.linger_s)
+        elif event == 'subscribe':
+            self.begin('sub', t, a.max_duration_s)
+            self.end('sub', t + a.subscribe_s, a.linger_s)
+        elif event == 'ota_start':
+            self.begin('ota', t, 0)
+        elif event == 'ota_end':
+            self.end('ota', t, 0)
+
+    def interval_at(self, t):
+        a = self.args
+        had_activity = bool(self.active)
+        for activity, deadline in list(self.active.items()):
+            if deadline is not None and t >= deadline:
+                del self.active[activity]
+        if had_activity and not self.active:
+            self.idle_since = t
+
+        w = self.window(t)
+        if w != self.current_window:
+            self.current_window = w
+            self.scores[w] -= self.scores[w] // a.window_decay
+
+        if self.active:
+            return (a.ota_ms if 'ota' in self.active else a.active_ms) / 1000.0
+
+        interval = a.inactive_ms
+        nxt = (w + 1) % a.window_count
+        if self.scores[w] < a.window_threshold and self.scores[nxt] < a.window_threshold:
+            steps = int((t - self.idle_since) // a.backoff_step_s)
+            while steps > 0 and interval < a.max_inactive_ms:
+                interval *= 2
+                steps -= 1
+            interval = min(interval, a.max_inactive_ms)
+        return interval / 1000.0
+
+
+def simulate(policy, events, duration, args):
+    poll_times = []
+    latencies = []
+    t = 0.0
+    i = 0
+
+    while t < duration:
+        # Apply the events that happened since the previous poll.  Commands are delivered
+        # (and start their activity) at this poll; other events happen at the device itself.
+        while i < len(events) and events[i][0] <= t:
+            time_s, event = events[i]
+            if event == 'command':
+                latencies.append(t - time_s)
+                policy.event(t, event)
+            else:
+                policy.event(time_s, event)
+            i += 1
+        poll_times.append(t)
+        t += policy.interval_at(t)
+
+    polls = len(poll_times)
+    avg_ua = args.sleep_ua + polls * args.poll_uc / duration
+    return polls, avg_ua, sorted(latencies)
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    k = min(len(values) - 1, int(round(p / 100.0 * (len(values) - 1))))
+    return values[k]
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Compare Thread polling policies against traffic traces.')
+    parser.add_argument('traces', nargs='*', help='trace files')
+    parser.add_argument('--synthetic', type=int, metavar='DAYS', help='generate a synthetic trace of DAYS days')
+    parser.add_argument('--seed', type=int, default=1, help='random seed for --synthetic')
+    parser.add_argument('--sleep-ua', type=float, default=3.0, help='sleep current in uA (default: 3)')
+    parser.add_argument('--poll-uc', type=float, default=20.0, help='charge per data poll in uC (default: 20)')
+    # Policy parameters; the defaults match main/include/app_config.h.
+    parser.add_argument('--active-ms', type=int, default=100)
+    parser.add_argument('--inactive-ms', type=int, default=1000)
+    parser.add_argument('--ota-ms', type=int, default=50)
+    parser.add_argument('--max-inactive-ms', type=int, default=4000)
+    parser.add_argument('--backoff-step-s', type=float, default=60)
+    parser.add_argument('--linger-s', type=float, default=5)
+    parser.add_argument('--max-duration-s', type=float, default=60)
+    parser.add_argument('--window-count', type=int, default=48)
+    parser.add_argument('--window-increment', type=int, default=64)
+    parser.add_argument('--window-threshold', type=int, default=96)
+    parser.add_argument('--window-decay', type=int, default=4)
+    # Trace model.
+    parser.add_argument('--actuation-s', type=float, default=2, help='lock actuation time (default: 2)')
+    parser.add_argument('--subscribe-s', type=float, default=3, help='subscription setup time (default: 3)')
+    args = parser.parse_args(argv[1:])
+
+    if args.synthetic:
+        events = synthetic_trace(args.synthetic, args.seed)
+        duration = args.synthetic * DAY_S
+    elif args.traces:
+        events = load_trace(args.traces)
+        duration = events[-1][0] + 1 if events else 0
+    else:
+        parser.error('no trace given')
+
+    if duration <= 0:
+        print('Empty trace')
+        return 1
+
+    print('%-9s %-8s %-8s %-8s %-8s %-8s %s' % ('policy', 'polls', 'avg uA', 'p50 s', 'p90 s', 'p99 s', 'max s'))
+    for policy in (FixedPolicy(args), AdaptivePolicy(args)):
+        polls, avg_ua, latencies = simulate(policy, events, duration, args)
+        print('%-9s %-8d %-8.2f %-8.3f %-8.3f %-8.3f %.3f' %
+              (policy.name, polls, avg_ua, percentile(latencies, 50), percentile(latencies, 90),
+               percentile(latencies, 99), latencies[-1] if latencies else 0.0))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+#
+#    Copyright (c) 2019 Google LLC.
+#    All rights reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+
+#
+#    @file
+#          Summarizes the statically allocated RTOS objects in a GNU ld link map.
+#
+#          Build the application with RTOS_ALLOCATION=static and run:
+#
+#              rtos_static_report.py [--match REGEX ...] <map file>
+#
+#          Each object is compiled into its own .bss section (-fdata-sections), so the
+#          task stacks, task control blocks, queue storage and semaphores created with the
+#          FreeRTOS ...Static() APIs appear as individual entries in the map.  The report
+#          lists the entries whose symbol matches one of the --match expressions (default:
+#          the naming used by the application for such objects), along with the total size
+#          of the .bss and .heap output sections for comparison.
+#
+
+import argparse
+import re
+import shutil
+import subprocess
+import sys
+
+DEFAULT_MATCHES = [r'Stack$', r'Struct$', r'QueueBuffer$', r'^sSemBuf_']
+
+INPUT_SECTION_RE = re.compile(r'^ (\.bss|\.data|COMMON)(?:\.(\S+))?(?:\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\S+))?\s*$')
+CONTINUATION_RE = re.compile(r'^\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\S+)\s*$')
+OUTPUT_SECTION_RE = re.compile(r'^(\.\w+)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)')
+
+
+def parse_map(lines):
+    entries = []
+    output_sections = {}
+    pending = None
+
+    for line in lines:
+        line = line.rstrip('\r\n')
+
+        m = OUTPUT_SECTION_RE.match(line)
+        if m:
+            output_sections.setdefault(m.group(1), int(m.group(3), 16))
+            pending = None
+            continue
+
+        if pending is not None:
+            m = CONTINUATION_RE.match(line)
+            if m:
+                entries.append((pending, int(m.group(1), 16), int(m.group(2), 16), m.group(3)))
+            pending = None
+            continue
+
+        m = INPUT_SECTION_RE.match(line)
+        if m and m.group(2):
+            if m.group(3):
+                entries.append((m.group(2), int(m.group(3), 16), int(m.group(4), 16), m.group(5)))
+            else:
+                pending = m.group(2)
+
+    return entries, output_sections
+
+
+def demangle(names):
+    # GCC appends a numeric suffix to the section names of function-local statics.
+    names = [re.sub(r'\.\d+$', '', n) for n in names]
+    cxxfilt = shutil.which('arm-none-eabi-c++filt') or shutil.which('c++filt')
+    if cxxfilt is None:
+        return [re.sub(r'^_ZL\d+', '', n) for n in names]
+    out = subprocess.run([cxxfilt], input='\n'.join(names), stdout=subprocess.PIPE, universal_newlines=True, check=True)
+    return out.stdout.splitlines()
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Report statically allocated RTOS objects from a link map.')
+    parser.add_argument('--match', action='append', metavar='REGEX',
+                        help='symbol name pattern to include (default: %s)' % ' '.join(DEFAULT_MATCHES))
+    parser.add_argument('map', help='GNU ld map file (-Wl,-Map)')
+    args = parser.parse_args(argv[1:])
+
+    matches = [re.compile(m) for m in (args.match or DEFAULT_MATCHES)]
+
+    with open(args.map, errors='replace') as f:
+        entries, output_sections = parse_map(f)
+
+    names = demangle([e[0] for e in entries])
+
+    total = 0
+    print('%-10s %-7s %-40s %s' % ('address', 'size', 'symbol', 'object'))
+    for name, (_, addr, size, obj) in sorted(zip(names, entries), key=lambda e: e[1][1]):
+        short = name.split('::')[-1]
+        if size == 0 or not any(m.search(short) for m in matches):
+            continue
+        total += size
+        print('0x%08x %-7d %-40s %s' % (addr, size, name, obj.split('/')[-1]))
+
+    print('Static RTOS objects: %d bytes' % total)
+    for section in ('.bss', '.heap'):
+        if section in output_sections:
+            print('%s: %d bytes' % (section, output_sections[section]))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+#
+#    Copyright (c) 2019 Google LLC.
+#    All rights reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+
+#
+#    @file
+#          Benchmarks the time to the first lock command after the device reconnects to
+#          the service, with and without pre-establishment of the shared CASE session.
+#
+#          Each trial is a reconnect (a Thread reattach or, with --reboot-fraction, a
+#          reboot) followed by a command from the service.  The command can only be
+#          delivered once the shared CASE session is ready:
+#
+#              on-demand     the behaviour with SERVICE_SESSION_PREESTABLISH = 0.  The
+#                            session is released with probability --release when the
+#                            subscription bindings are reset, and a handshake starts at
+#                            the first exchange that needs it: the resubscription or the
+#                            command, whichever comes first.
+#              preestablish  the behaviour of main/ServiceSession.cpp.  The anchor
+#                            binding keeps the session across a reattach (unless the
+#                            service has dropped it), and the handshake starts as soon
+#                            as service connectivity is available.
+#              resumption    preestablish, with a hypothetical session resumption that
+#                            replaces the full handshake by one round trip without
+#                            public key operations when the resumption state is still
+#                            held (RAM only, unless --resume-persisted).  The device
+#                            does not implement this; it shows what resumption would add.
+#
+#          A full CASE handshake costs two round trips plus the device's public key
+#          operations (one ECDH, one signature and --verify-count signature checks) on
+#          software crypto.  Take these from the boot-time crypto benchmark (see
+#          main/CryptoBenchmark.cpp); an ECDSA signature costs about one scalar
+#          multiplication and a check about two.  Each round trip costs --rtt-ms plus the
+#          wait for the sleepy device's next poll.
+#
+#              session_sim.py [--trials N] [--ecdh-ms MS] [--rtt-ms MS] [options]
+#
+
+import argparse
+import random
+import sys
+
+POLICIES = ('on-demand', 'preestablish', 'resumption')
+
+
+def round_trip_ms(args, rng):
+    return args.rtt_ms + rng.uniform(0, args.poll_ms)
+
+
+def handshake_ms(args, rng):
+    crypto = args.ecdh_ms * (1 + 1 + 2 * args.verify_count)
+    return 2 * round_trip_ms(args, rng) + crypto
+
+
+def trial(policy, args, rng):
+    reboot = rng.random() < args.reboot_fraction
+    command_ms = rng.uniform(0, args.command_window_s * 1000.0)
+    resubscribe_ms = args.resubscribe_ms
+
+    if policy == 'on-demand':
+        have_session = not reboot and rng.random() >= args.release
+    else:
+        have_session = not reboot and rng.random() >= args.service_drop
+
+    handshakes = 0
+    if have_session:
+        ready_ms = 0.0
+    else:
+        start_ms = min(resubscribe_ms, command_ms) if policy == 'on-demand' else 0.0
+        resumable = (not reboot or args.resume_persisted) and rng.random() < args.resume_hit
+        if policy == 'resumption' and resumable:
+            setup_ms = round_trip_ms(args, rng)
+        else:
+            setup_ms = handshake_ms(args, rng)
+            handshakes = 1
+        ready_ms = start_ms + setup_ms
+
+    latency_ms = max(command_ms, ready_ms) - command_ms + round_trip_ms(args, rng)
+    return latency_ms, ready_ms > command_ms, handshakes
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    k = min(len(values) - 1, int(round(p / 100.0 * (len(values) - 1))))
+    return values[k]
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Benchmark time to first command after a reconnect.')
+    parser.add_argument('--trials', type=int, default=10000, help='number of reconnects (default: 10000)')
+    parser.add_argument('--seed', type=int, default=1, help='random seed')
+    parser.add_argument('--reboot-fraction', type=float, default=0.2, help='reconnects that follow a reboot (default: 0.2)')
+    parser.add_argument('--command-window-s', type=float, default=10,
+                        help='the command arrives uniformly within this time of the reconnect (default: 10)')
+    parser.add_argument('--resubscribe-ms', type=float, default=1000, help='delay to the resubscription (default: 1000)')
+    parser.add_argument('--release', type=float, default=0.5,
+                        help='on-demand: probability the session is released on a reattach (default: 0.5)')
+    parser.add_argument('--service-drop', type=float, default=0.05,
+                        help='probability the service has dropped a held session (default: 0.05)')
+    # Network and crypto model.
+    parser.add_argument('--rtt-ms', type=float, default=250, help='service round trip time (default: 250)')
+    parser.add_argument('--poll-ms', type=float, default=1000, help='sleepy device poll interval (default: 1000)')
+    parser.add_argument('--ecdh-ms', type=float, default=450, help='P-256 scalar multiplication (default: 450)')
+    parser.add_argument('--verify-count', type=int, default=2, help='signature checks per handshake (default: 2)')
+    # Hypothetical resumption.
+    parser.add_argument('--resume-hit', type=float, default=0.9, help='resumption state accepted (default: 0.9)')
+    parser.add_argument('--resume-persisted', action='store_true', help='resumption state survives a reboot')
+    args = parser.parse_args(argv[1:])
+
+    crypto_ms = args.ecdh_ms * (1 + 1 + 2 * args.verify_count)
+    print('Full handshake: %.0f ms on average, of which %.0f ms of public key operations\n' %
+          (2 * (args.rtt_ms + args.poll_ms / 2.0) + crypto_ms, crypto_ms))
+    print('%-13s %-8s %-8s %-8s %-8s %-8s %s' % ('policy', 'mean ms', 'p50 ms', 'p90 ms', 'p99 ms', 'waited', 'handshakes'))
+    for policy in POLICIES:
+        rng = random.Random(args.seed)
+        latencies = []
+        waited = 0
+        handshakes = 0
+        for _ in range(args.trials):
+            latency_ms, did_wait, count = trial(policy, args, rng)
+            latencies.append(latency_ms)
+            waited += did_wait
+            handshakes += count
+        latencies.sort()
+        print('%-13s %-8.0f %-8.0f %-8.0f %-8.0f %-8.3f %.3f' %
+              (policy, sum(latencies) / len(latencies), percentile(latencies, 50), percentile(latencies, 90),
+               percentile(latencies, 99), float(waited) / args.trials, float(handshakes) / args.trials))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
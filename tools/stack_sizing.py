@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+#
+#    Copyright (c) 2019 Google LLC.
+#    All rights reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+
+#
+#    @file
+#          Recommends task stack sizes from the stack usage reported in device logs.
+#
+#          The periodic diagnostics report (see main/include/StackMonitor.h) logs the
+#          allocated size and peak usage of every task stack.  Capture the device log
+#          (RTT or UART) over one or more runs that exercise the device (pairing,
+#          software update, lock operations, ...), then run:
+#
+#              stack_sizing.py [--headroom PERCENT] [--min-headroom BYTES] <log file> ...
+#
+#          The peak usage of each task is taken over all of the logs, and a stack size
+#          is recommended using the same headroom rule as the device (default: the
+#          values in main/include/app_config.h).
+#
+
+import argparse
+import re
+import sys
+
+STACK_RE = re.compile(r'Stack (.+?): size (\d+), peak (\d+)')
+
+
+def recommend(peak, headroom_percent, min_headroom):
+    headroom = max(peak * headroom_percent // 100, min_headroom)
+    return (peak + headroom + 7) & ~7
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Recommend task stack sizes from device stack reports.')
+    parser.add_argument('--headroom', type=int, default=25, metavar='PERCENT',
+                        help='headroom as a percentage of the peak usage (default: 25)')
+    parser.add_argument('--min-headroom', type=int, default=256, metavar='BYTES',
+                        help='minimum headroom in bytes (default: 256)')
+    parser.add_argument('logs', nargs='+', help='device log files containing stack reports')
+    args = parser.parse_args(argv[1:])
+
+    tasks = {}
+    for path in args.logs:
+        with open(path, errors='replace') as f:
+            for line in f:
+                m = STACK_RE.search(line)
+                if m is None:
+                    continue
+                name, size, peak = m.group(1), int(m.group(2)), int(m.group(3))
+                prev_size, prev_peak, samples = tasks.get(name, (size, 0, 0))
+                tasks[name] = (max(size, prev_size), max(peak, prev_peak), samples + 1)
+
+    if not tasks:
+        print('No stack reports found')
+        return 1
+
+    configured_ram = 0
+    recommended_ram = 0
+
+    print('%-10s %-8s %-8s %-8s %s' % ('task', 'samples', 'size', 'peak', 'recommended'))
+    for name in sorted(tasks):
+        size, peak, samples = tasks[name]
+        rec = recommend(peak, args.headroom, args.min_headroom)
+        configured_ram += size
+        recommended_ram += rec
+        print('%-10s %-8d %-8d %-8d %d (%+d)' % (name, samples, size, peak, rec, rec - size))
+
+    print('RAM: configured %d bytes, recommended %d bytes (%+d)' %
+          (configured_ram, recommended_ram, recommended_ram - configured_ram))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+#
+#    Copyright (c) 2019 Google LLC.
+#    All rights reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+
+#
+#    @file
+#          Emulates WRM request/response exchanges over a lossy, variable-delay link.
+#
+#          Runs a sequence of back-to-back request/response exchanges (as in a BDX image
+#          download) with a fixed retransmission timeout, and with the timeout derived
+#          from measured round trip times as in main/RTTEstimator.cpp, and reports for
+#          each the goodput, exchange latency, retransmissions (and how many of them were
+#          spurious, i.e. the original would have been answered) and failed exchanges.
+#
+#              wrm_sim.py [--delay-ms MS] [--jitter-ms MS] [--loss P] [options]
+#
+#          The one-way delay of each message is delay + an exponentially distributed
+#          jitter with the given mean; each message is lost independently with
+#          probability P.  As with the round trip probes on the device (see
+#          WDMFeature::ProbeServiceRTT()), the estimator is only fed exchanges answered before
+#          their first retransmission (Karn's algorithm): the elapsed time of a retransmitted
+#          exchange cannot be attributed to either attempt.
+#
+
+import argparse
+import random
+import sys
+
+
+class FixedTimeout:
+    name = 'fixed'
+
+    def __init__(self, timeout_ms):
+        self.timeout = timeout_ms
+
+    def sample(self, rtt):
+        pass
+
+
+class RTTEstimator:
+    """RFC 6298 estimator, as implemented by main/RTTEstimator.cpp."""
+    name = 'adaptive'
+
+    def __init__(self, initial_ms, min_ms, max_ms):
+        self.timeout = initial_ms
+        self.min = min_ms
+        self.max = max_ms
+        self.srtt = None
+        self.rttvar = None
+
+    def sample(self, rtt):
+        if self.srtt is None:
+            self.srtt = rtt
+            self.rttvar = rtt / 2.0
+        else:
+            self.rttvar = 0.75 * self.rttvar + 0.25 * abs(self.srtt - rtt)
+            self.srtt = 0.875 * self.srtt + 0.125 * rtt
+        self.timeout = min(max(self.srtt + 4 * self.rttvar, self.min), self.max)
+
+
+def run(policy, args, rng):
+    now = 0.0
+    latencies = []
+    retrans = spurious = failures = 0
+
+    for _ in range(args.exchanges):
+        timeout = policy.timeout
+        start = now
+        done = None
+        answered = []   # Attempts whose response eventually arrives.
+        for attempt in range(args.max_retrans + 1):
+            sent = start + attempt * timeout
+            if done is not None and sent >= done:
+                break
+            if attempt > 0:
+                retrans += 1
+                if answered:
+                    spurious += 1
+            if rng.random() >= args.loss and rng.random() >= args.loss:
+                arrival = sent + 2 * args.delay_ms + rng.expovariate(1.0 / args.jitter_ms) + rng.expovariate(1.0 / args.jitter_ms)
+                answered.append(attempt)
+                done = arrival if done is None else min(done, arrival)
+
+        if done is None:
+            failures += 1
+            now = start + max((args.max_retrans + 1) * timeout, args.response_timeout_ms)
+        else:
+            latencies.append(done - start)
+            if done - start < timeout:
+                policy.sample(done - start)
+            now = done
+
+    latencies.sort()
+    completed = len(latencies)
+    goodput = completed * args.block_size * 1000.0 / now if now else 0
+    mean = sum(latencies) / completed if completed else 0
+    p95 = latencies[int(0.95 * (completed - 1))] if completed else 0
+    return goodput, mean, p95, retrans, spurious, failures
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Compare fixed and RTT-derived WRM retransmission timeouts.')
+    parser.add_argument('--delay-ms', type=float, default=150, help='base one-way delay (default: 150)')
+    parser.add_argument('--jitter-ms', type=float, default=50, help='mean one-way jitter (default: 50)')
+    parser.add_argument('--loss', type=float, default=0.05, help='per-message loss probability (default: 0.05)')
+    parser.add_argument('--exchanges', type=int, default=2000, help='number of exchanges (default: 2000)')
+    parser.add_argument('--block-size', type=int, default=1024, help='payload per exchange in bytes (default: 1024)')
+    parser.add_argument('--seed', type=int, default=1, help='random seed')
+    # Transport parameters; the defaults match main/WDMFeature.cpp.
+    parser.add_argument('--fixed-ms', type=int, default=2500)
+    parser.add_argument('--min-ms', type=int, default=1000)
+    parser.add_argument('--max-ms', type=int, default=8000)
+    parser.add_argument('--max-retrans', type=int, default=3)
+    parser.add_argument('--response-timeout-ms', type=int, default=10000)
+    args = parser.parse_args(argv[1:])
+
+    print('%-9s %-10s %-10s %-10s %-8s %-9s %s' % ('policy', 'B/s', 'mean ms', 'p95 ms', 'retrans', 'spurious', 'failed'))
+    for policy in (FixedTimeout(args.fixed_ms), RTTEstimator(args.fixed_ms, args.min_ms, args.max_ms)):
+        goodput, mean, p95, retrans, spurious, failures = run(policy, args, random.Random(args.seed))
+        print('%-9s %-10.0f %-10.0f %-10.0f %-8d %-9d %d' % (policy.name, goodput, mean, p95, retrans, spurious, failures))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))